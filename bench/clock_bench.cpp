@@ -0,0 +1,122 @@
+/**
+ * TscClock micro-benchmark: per-call cost and resolution of the engine's
+ * candidate clocks, then the TSC clock's offset from the reference clock
+ * (clock_gettime(CLOCK_MONOTONIC) / steady_clock) over a run.
+ *
+ *   cping_clock_bench [seconds]
+ */
+
+#include "cping/clock.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#if !defined(_WIN32)
+  #include <time.h>
+#endif
+
+using namespace std::chrono;
+
+namespace {
+
+constexpr int kCalls = 5'000'000;
+
+volatile int64_t g_sink;   // Keeps the timed reads from being optimised out
+
+struct Cost {
+    double ns_per_call;
+    int64_t resolution_ns;  // Smallest non-zero step between two reads
+};
+
+template <typename Now>
+Cost measure(Now now) {
+    int64_t prev = now();
+    int64_t step = INT64_MAX;
+
+    const auto t0 = steady_clock::now();
+    for (int i = 0; i < kCalls; ++i) {
+        const int64_t v = now();
+        if (v != prev && v - prev < step) step = v - prev;
+        prev = v;
+    }
+    const auto t1 = steady_clock::now();
+
+    g_sink = prev;
+    return { double(duration_cast<nanoseconds>(t1 - t0).count()) / kCalls, step };
+}
+
+void report(const char* name, const Cost& c) {
+    std::printf("  %-28s %7.1f ns/call   resolution %lld ns\n",
+                name, c.ns_per_call, static_cast<long long>(c.resolution_ns));
+}
+
+int64_t ns_of(steady_clock::time_point t) {
+    return duration_cast<nanoseconds>(t.time_since_epoch()).count();
+}
+
+} // namespace
+
+
+int main(int argc, char** argv) {
+    const int seconds = argc > 1 ? std::max(1, std::atoi(argv[1])) : 5;
+
+    std::printf("Invariant TSC usable: %s\n", cping::TscClock::suitable() ? "yes" : "no");
+    const bool tsc = cping::TscClock::calibrate();
+    if (tsc)
+        std::printf("Calibrated: %.3f MHz\n", cping::TscClock::frequency_hz() / 1e6);
+    else
+        std::printf("Calibration failed: TscClock::now() falls back to steady_clock\n");
+
+    // -----------------------------------------------------------------
+    // Cost per call
+    // -----------------------------------------------------------------
+    std::printf("\nCost (%d calls each)\n", kCalls);
+#if !defined(_WIN32)
+    report("clock_gettime(MONOTONIC)", measure([] {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return int64_t(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+    }));
+#endif
+    report("steady_clock::now()", measure([] { return ns_of(steady_clock::now()); }));
+    report("high_resolution_clock::now()", measure([] {
+        return duration_cast<nanoseconds>(high_resolution_clock::now().time_since_epoch()).count();
+    }));
+    report("TscClock::now()", measure([] { return ns_of(cping::TscClock::now()); }));
+
+    if (!tsc)
+        return 0;
+
+    // -----------------------------------------------------------------
+    // Accuracy: offset from the reference, sampled every 10 ms
+    // -----------------------------------------------------------------
+    std::printf("\nOffset TscClock - steady_clock over %d s\n", seconds);
+
+    int64_t worst = 0, last = 0;
+    const auto end = steady_clock::now() + std::chrono::seconds(seconds);
+    while (steady_clock::now() < end) {
+        // Bracket the reference read; keep the tightest of a few tries
+        int64_t best_gap = INT64_MAX, off = 0;
+        for (int i = 0; i < 16; ++i) {
+            const int64_t a = ns_of(cping::TscClock::now());
+            const int64_t r = ns_of(steady_clock::now());
+            const int64_t b = ns_of(cping::TscClock::now());
+            if (b - a < best_gap) {
+                best_gap = b - a;
+                off = (a + b) / 2 - r;
+            }
+        }
+        last  = off;
+        worst = std::max(worst, std::abs(off));
+        std::this_thread::sleep_for(milliseconds(10));
+    }
+
+    std::printf("  final offset  %lld ns\n", static_cast<long long>(last));
+    std::printf("  worst offset  %lld ns\n", static_cast<long long>(worst));
+    std::printf("  drift         %.3f ppm\n", double(last) / (seconds * 1e9) * 1e6);
+    return 0;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "cping/visibility.hpp"
+
+namespace cping {
+
+/**
+ * Pre-parsed IP address.
+ *
+ * Trivially copyable value type (17 bytes): IPv6 addresses are stored
+ * as-is, IPv4 addresses in IPv4-mapped form (::ffff:a.b.c.d), the same
+ * layout TargetTable uses. Parse a target once and hand the Address to
+ * the probe APIs: repeated probes then skip inet_pton and never build a
+ * std::string on the hot path.
+ *
+ * A default-constructed Address is empty (family() == 0).
+ */
+struct CPING_API Address {
+    std::array<uint8_t, 16> bytes{};
+    uint8_t family{0};                    // 0 = empty, 4 = IPv4, 6 = IPv6
+
+    /**
+     * Parse a textual address. IPv4 dotted quads take a hand-rolled
+     * path with the same acceptance rules as inet_pton (no leading
+     * zeros, no shorthand); IPv6 falls back to inet_pton.
+     */
+    static std::optional<Address> parse(std::string_view text) noexcept;
+
+    /** IPv4 address from its host-order integer (e.g. 0x7F000001). */
+    static Address v4(uint32_t host_order) noexcept;
+
+    bool empty()   const noexcept { return family == 0; }
+    bool is_v4()   const noexcept { return family == 4; }
+    bool is_v6()   const noexcept { return family == 6; }
+
+    /** IPv4 address in network byte order (in_addr::s_addr); 0 if not v4. */
+    uint32_t v4_net() const noexcept;
+
+    std::string to_string() const;
+
+    friend bool operator==(const Address&, const Address&) = default;
+};
+
+/**
+ * Bulk-parse a target list held in memory: one address per line, the
+ * first whitespace-separated token counts, '#' starts a comment and
+ * blank lines are skipped. Valid addresses are appended to `out`.
+ *
+ * @param rejected  Optional count of non-empty lines that did not parse
+ * @return number of addresses appended
+ */
+CPING_API size_t parse_address_list(std::string_view text,
+                                    std::vector<Address>& out,
+                                    size_t* rejected = nullptr);
+
+} // namespace cping
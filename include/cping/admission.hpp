@@ -0,0 +1,98 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stop_token>
+#include <vector>
+#include "cping/ping.hpp"
+#include "cping/visibility.hpp"
+
+namespace cping {
+
+/**
+ * How a submitter reacts when the engine has no free in-flight slot.
+ */
+enum class AdmitMode : unsigned char {
+    Block,      // Wait until a slot is granted (backpressure on the caller)
+    Try,        // Fail immediately instead of waiting
+    Callback    // Queue the request; it is started when a slot frees up
+};
+
+/**
+ * In-flight admission control with strict priority classes.
+ *
+ * Holds a cap on outstanding probes and one FIFO queue per ProbePriority.
+ * When a slot is released it is handed to the oldest waiter of the highest
+ * non-empty class, so bulk work can never delay an interactive probe by
+ * more than the probes already on the wire.
+ *
+ * A limit of 0 means "unlimited" (every request is admitted at once).
+ * Thread-safe; admit callbacks run on the thread that released the slot.
+ */
+class CPING_API AdmissionControl {
+public:
+    /// Invoked once: admitted=true when a slot is granted, false on abort.
+    using AdmitFn = std::function<void(bool admitted)>;
+
+    explicit AdmissionControl(int max_inflight = 0);
+
+    AdmissionControl(const AdmissionControl&) = delete;
+    AdmissionControl& operator=(const AdmissionControl&) = delete;
+
+    /** Change the cap; raising it immediately admits queued waiters. */
+    void set_limit(int max_inflight);
+    int  limit() const;
+
+    /** Take a slot only if one is free right now. */
+    bool try_acquire(ProbePriority prio);
+
+    /**
+     * Block until a slot is granted; false if the controller was aborted
+     * or `stop` was requested while waiting (the queue entry is dropped).
+     */
+    bool acquire(ProbePriority prio, std::stop_token stop = {});
+
+    /** Queue a request; on_admit fires (possibly inline) once admitted. */
+    void acquire_async(ProbePriority prio, AdmitFn on_admit);
+
+    /** Return a slot and hand it to the next waiter by priority. */
+    void release();
+
+    /**
+     * Fail every queued waiter and reject new requests until reset().
+     * Slots still held are simply returned by release().
+     */
+    void abort_all();
+    void reset();
+
+    int    in_flight() const;
+    size_t queued(ProbePriority prio) const;
+
+private:
+    struct Ticket {
+        bool granted{false};
+        bool aborted{false};
+    };
+
+    struct Entry {
+        Ticket* blocked{nullptr};   // Blocking submitter (stack-owned ticket)
+        AdmitFn on_admit;           // Asynchronous submitter
+    };
+
+    static constexpr int kClasses = 3;
+
+    bool has_slot_locked() const;
+    bool queue_ahead_locked(ProbePriority prio) const;
+    void grant_locked(std::vector<AdmitFn>& ready);
+
+    mutable std::mutex mtx_;
+    std::condition_variable_any cv_;   // _any: waits honour stop tokens
+    std::deque<Entry> queues_[kClasses];
+    int  limit_{0};
+    int  inflight_{0};
+    bool aborted_{false};
+};
+
+} // namespace cping
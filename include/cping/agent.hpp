@@ -0,0 +1,152 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "cping/address.hpp"
+#include "cping/histogram.hpp"
+#include "cping/visibility.hpp"
+
+namespace cping {
+
+/**
+ * A probe job sent from a coordinator to its agents: probe every target
+ * `rounds` times, one round per `interval_ms`.
+ */
+struct AgentJob {
+    uint32_t id{0};                     // Echoed back in every result batch
+    std::vector<Address> targets;       // IPv4 targets, probed in this order
+    int rounds{1};
+    int interval_ms{1000};
+    int timeout_ms{1000};
+    int payload_size{0};
+    int ttl{-1};
+};
+
+/**
+ * Options for ProbeAgent.
+ */
+struct AgentOptions {
+    std::string bind{"127.0.0.1"};      // Listen address (IPv4)
+    uint16_t port{7227};                // 0 = pick a free port (see port())
+    size_t   batch_size{512};           // Max results per batch frame
+    std::string secret;                 // Shared with coordinators; required off loopback
+    size_t   max_targets{65536};        // Larger jobs are refused
+    int      min_interval_ms{100};      // Jobs probing faster are refused
+};
+
+/**
+ * Remote vantage point.
+ *
+ * Listens on TCP and serves one coordinator connection at a time; the
+ * connection stays open across jobs. Each job runs on the process-wide
+ * engine (init_engine must have succeeded) through a Monitor, and its
+ * results stream back after every round as compact batches of
+ * (target index, RTT) pairs, 8 bytes per probe.
+ *
+ * A coordinator must open with a Hello frame carrying the shared secret
+ * within a few seconds; a late or wrong secret, a job over `max_targets`,
+ * below `min_interval_ms` or with an out-of-range timeout, payload size or
+ * TTL closes the connection. The secret is compared, not encrypted: off a
+ * trusted network run agents behind a tunnel. Binding anything but a
+ * loopback address without a secret is refused by listen().
+ *
+ * Wire format: frames of  u32 length | u8 type | payload,  integers
+ * little-endian. Types: Hello and Job (coordinator -> agent), Results
+ * and Done (agent -> coordinator). See agent.cpp for the payload layouts.
+ *
+ * POSIX only; listen() fails elsewhere.
+ */
+class CPING_API ProbeAgent {
+public:
+    explicit ProbeAgent(AgentOptions opt = {});
+    ~ProbeAgent();
+
+    ProbeAgent(const ProbeAgent&) = delete;
+    ProbeAgent& operator=(const ProbeAgent&) = delete;
+
+    /**
+     * Bind and listen; false if the address / port is unavailable, or
+     * the address is not loopback and no secret is set.
+     */
+    bool listen();
+
+    /** Bound port (useful with AgentOptions::port = 0). */
+    uint16_t port() const { return port_; }
+
+    /**
+     * Accept coordinators and run their jobs until `keep_running` turns
+     * false (checked at least every 100 ms).
+     */
+    void serve(const std::atomic<bool>* keep_running = nullptr);
+
+private:
+    AgentOptions opt_;
+    int      fd_{-1};
+    uint16_t port_{0};
+};
+
+/**
+ * Per-vantage-point outcome of a coordinated job.
+ */
+struct VantageStats {
+    std::string agent;                  // "host:port"
+    bool     complete{false};           // Agent reported the job as done
+    uint64_t sent{0};
+    uint64_t received{0};
+    LatencyHistogram latency;
+
+    double loss_pct() const {
+        return sent ? 100.0 * double(sent - received) / double(sent) : 0.0;
+    }
+};
+
+/**
+ * Merged outcome of one job across all agents.
+ */
+struct CoordinatorResult {
+    std::vector<VantageStats> vantage;  // One per connected agent, in connect order
+    uint64_t sent{0};
+    uint64_t received{0};
+    LatencyHistogram global;            // Union of all vantage histograms
+};
+
+/**
+ * Central side: keeps persistent connections to agents, fans jobs out
+ * and merges the streamed results into per-vantage and global stats.
+ */
+class CPING_API AgentCoordinator {
+public:
+    AgentCoordinator() = default;
+    ~AgentCoordinator();
+
+    AgentCoordinator(const AgentCoordinator&) = delete;
+    AgentCoordinator& operator=(const AgentCoordinator&) = delete;
+
+    /**
+     * Connect to an agent at an IPv4 address and present `secret`
+     * (AgentOptions::secret on the agent); false on failure. A wrong
+     * secret shows up as an incomplete agent on the first run().
+     */
+    bool connect(const std::string& host, uint16_t port, const std::string& secret = {});
+
+    size_t agents() const { return conns_.size(); }
+
+    /**
+     * Send `job` to every agent and collect until all of them report it
+     * done or `timeout_ms` passes (0 = derived from the job schedule).
+     * Agents whose connection fails or that miss the deadline are marked
+     * incomplete and dropped.
+     */
+    CoordinatorResult run(const AgentJob& job, int timeout_ms = 0);
+
+private:
+    struct Conn {
+        int fd{-1};
+        std::string name;
+        std::vector<uint8_t> inbuf;
+    };
+    std::vector<Conn> conns_;
+};
+
+} // namespace cping
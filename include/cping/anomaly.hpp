@@ -0,0 +1,100 @@
+#pragma once
+#include <cstdint>
+#include "cping/ping.hpp"
+#include "cping/visibility.hpp"
+
+namespace cping {
+
+/**
+ * Kinds of events raised by the online anomaly detector.
+ */
+enum class AnomalyKind : unsigned char {
+    RttLevelShift,   // Sustained RTT change (value = new RTT, baseline = old mean)
+    JitterSpike,     // Sample-to-sample jump (value = |delta|, baseline = mean jitter)
+    LossBurst        // Loss episode (value = loss rate 0..1, baseline = losses in a row)
+};
+
+/**
+ * One detected anomaly. RTT-derived values are in microseconds.
+ */
+struct AnomalyEvent {
+    AnomalyKind kind{AnomalyKind::RttLevelShift};
+    double value{0.0};
+    double baseline{0.0};
+    uint32_t sample{0};          // Index of the triggering sample (per target)
+};
+
+/**
+ * Detector tuning, shared by all targets using one AnomalyDetector.
+ */
+struct AnomalyConfig {
+    double   ewma_alpha{0.125};      // RTT mean/variance smoothing
+    double   cusum_k{0.5};           // CUSUM slack, in standard deviations
+    double   cusum_h{8.0};           // CUSUM decision threshold, in std devs
+    double   z_clamp{4.0};           // Per-sample cap so one outlier never trips CUSUM
+    double   jitter_alpha{0.0625};   // RFC 3550 style jitter smoothing
+    double   jitter_factor{4.0};     // Spike = delta above factor x mean jitter
+    double   min_spread_us{50.0};    // Floor for std dev / jitter (quiet links)
+    double   loss_alpha{0.1};        // Loss-rate smoothing
+    double   loss_threshold{0.3};    // Smoothed loss rate that starts a burst
+    uint16_t loss_run{3};            // ...or this many losses in a row
+    uint32_t warmup{10};             // Samples before RTT events are raised
+};
+
+/**
+ * Per-target detector state: 40 bytes, no sample history.
+ */
+struct AnomalyState {
+    float    mean_us{0};
+    float    var_us2{0};
+    float    jitter_us{0};
+    float    last_us{0};
+    float    cusum_up{0};
+    float    cusum_down{0};
+    float    loss_rate{0};
+    uint32_t samples{0};             // Replies seen
+    uint32_t probes{0};              // Replies + losses
+    uint16_t loss_run{0};
+    uint8_t  in_loss_burst{0};
+    uint8_t  reserved{0};
+};
+
+/**
+ * Online change-point detection for RTT level shifts, jitter spikes and
+ * loss bursts.
+ *
+ * - Level shifts: two-sided CUSUM over the standardized residual against
+ *   an EWMA mean/variance that outliers do not update; after a detection
+ *   the baseline restarts at the new level.
+ * - Jitter spikes: |rtt - previous rtt| compared with its own EWMA.
+ * - Loss bursts: a run of consecutive losses or a smoothed loss rate
+ *   above threshold; re-armed once replies bring the rate back down.
+ *
+ * observe() is O(1) in time and memory, so one detector can serve
+ * thousands of targets, each with its own AnomalyState.
+ */
+class CPING_API AnomalyDetector {
+public:
+    static constexpr int kMaxEvents = 3;
+
+    explicit AnomalyDetector(AnomalyConfig cfg = {}) : cfg_(cfg) {}
+
+    /**
+     * Fold one probe outcome into `st`.
+     * @return number of events written to `out` (0..kMaxEvents)
+     */
+    int observe(AnomalyState& st, const PingProbeResult& probe,
+                AnomalyEvent out[kMaxEvents]) const;
+
+    const AnomalyConfig& config() const { return cfg_; }
+
+private:
+    AnomalyConfig cfg_;
+};
+
+/**
+ * Human-readable event kind ("rtt-shift", "jitter-spike", "loss-burst").
+ */
+CPING_API const char* to_string(AnomalyKind kind);
+
+} // namespace cping
@@ -0,0 +1,97 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <vector>
+#include "cping/ping.hpp"
+#include "cping/visibility.hpp"
+
+namespace cping {
+
+/**
+ * Run-scoped bump allocator.
+ *
+ * A std::pmr::monotonic_buffer_resource over one preallocated block:
+ * every probe record and error string of a run is carved out of it with
+ * a pointer bump and nothing is freed individually. The whole run is
+ * dropped at once by release() or by destroying the arena. If the block
+ * runs out, the resource grows geometrically from the upstream resource.
+ *
+ * Not thread-safe; containers using it must not outlive it.
+ */
+class CPING_API RunArena {
+public:
+    static constexpr size_t kDefaultBytes = 64 * 1024;
+
+    explicit RunArena(size_t initial_bytes = kDefaultBytes,
+                      std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+
+    RunArena(const RunArena&) = delete;
+    RunArena& operator=(const RunArena&) = delete;
+
+    std::pmr::memory_resource* resource() noexcept { return &mono_; }
+
+    /** Free everything allocated from the arena (containers must be gone). */
+    void release() { mono_.release(); }
+
+    size_t capacity() const noexcept { return size_; }
+
+    /** Block size that holds `probes` records without touching upstream. */
+    static size_t bytes_for(size_t probes);
+
+private:
+    std::unique_ptr<std::byte[]> block_;
+    size_t size_{0};
+    std::pmr::monotonic_buffer_resource mono_;
+};
+
+/**
+ * Allocator-aware copy of a PingProbeResult for run logs.
+ *
+ * Inside a ProbeLog the error text is allocated from the log's resource
+ * (uses-allocator construction), so an arena-backed log costs no heap
+ * traffic per probe.
+ */
+struct ProbeRecord {
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    bool success{false};
+    int  ttl{-1};
+    long rtt_ms{-1};
+    long rtt_us{-1};
+    std::pmr::string error_msg;
+
+    explicit ProbeRecord(allocator_type alloc = {}) : error_msg(alloc) {}
+
+    ProbeRecord(const PingProbeResult& p, allocator_type alloc = {})
+        : success(p.success), ttl(p.ttl), rtt_ms(p.rtt_ms), rtt_us(p.rtt_us),
+          error_msg(p.error_msg, alloc) {}
+
+    ProbeRecord(const ProbeRecord& o, allocator_type alloc = {})
+        : success(o.success), ttl(o.ttl), rtt_ms(o.rtt_ms), rtt_us(o.rtt_us),
+          error_msg(o.error_msg, alloc) {}
+
+    ProbeRecord(ProbeRecord&& o, allocator_type alloc)
+        : success(o.success), ttl(o.ttl), rtt_ms(o.rtt_ms), rtt_us(o.rtt_us),
+          error_msg(std::move(o.error_msg), alloc) {}
+
+    ProbeRecord(ProbeRecord&&) noexcept = default;
+    ProbeRecord& operator=(const ProbeRecord&) = default;
+    ProbeRecord& operator=(ProbeRecord&&) = default;
+};
+
+/**
+ * Ordered probe records of one run; pass an arena's resource to make
+ * the whole log bump-allocated.
+ */
+using ProbeLog = std::pmr::vector<ProbeRecord>;
+
+/**
+ * ping_host() variant appending each completed probe to `log` instead of
+ * building a PingResult::probes vector (returned `probes` stays empty).
+ */
+CPING_API PingResult ping_host(const std::string& ip, const PingOptions& opt,
+                               ProbeLog& log, std::stop_token stop = {});
+
+} // namespace cping
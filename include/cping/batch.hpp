@@ -0,0 +1,64 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "cping/ping.hpp"
+#include "cping/visibility.hpp"
+
+namespace cping {
+
+/**
+ * Outcome of one target in a deadline-bounded batch.
+ */
+enum class BatchStatus : unsigned char {
+    Replied,    // Echo reply received
+    Lost,       // Full per-probe timeout elapsed without a reply
+    Pending,    // No verdict before the batch deadline (not sent, or cut short)
+    Failed      // Rejected up front or send error (bad address, engine down)
+};
+
+struct BatchResult {
+    std::string     ip;
+    BatchStatus     status{BatchStatus::Pending};
+    PingProbeResult probe;          // Valid for Replied / Lost / Failed
+};
+
+/**
+ * Options for ping_batch().
+ */
+struct BatchOptions {
+    int    deadline_ms{1000};       // Total budget for the whole batch
+    int    probe_timeout_ms{1000};  // Per-probe timeout, capped by the deadline
+    double send_fraction{0.5};      // Part of the budget used to spread sends
+    int    payload_size{0};
+    int    ttl{-1};
+    ProbePriority priority{ProbePriority::High};
+    int    window{16384};           // Probes outstanding at most (capped at 32768)
+};
+
+/**
+ * Probe every target once and return within `deadline_ms`.
+ *
+ * Sends are paced evenly over the first `send_fraction` of the budget so
+ * a large set does not burst. All probes are submitted at once with a
+ * ProbeRequest::send_at departure, so the spacing is kept by the engine
+ * (kernel txtime or its pacer thread) rather than by sleeping between
+ * submissions, up to `window` outstanding probes at a time: replies are
+ * matched by a 16-bit sequence number, so a window past half of that
+ * space could pair a reply with the wrong target. Every probe's timeout
+ * is cut to the time left until the deadline. Results come back in input
+ * order; a target without a verdict at the deadline (never sent, held
+ * back by the window or the in-flight cap, or its shortened timeout ran
+ * out) is marked Pending. Probes still waiting for admission or their
+ * departure at the deadline are cancelled, so nothing of the batch is
+ * sent after it returns.
+ * Dead hosts therefore cost nothing beyond the shared budget.
+ *
+ * Requires a running engine (init_engine); otherwise every target is
+ * reported as Failed.
+ */
+CPING_API std::vector<BatchResult> ping_batch(const std::vector<std::string>& targets,
+                                              const BatchOptions& opt = {});
+
+CPING_API const char* to_string(BatchStatus status);
+
+} // namespace cping
@@ -0,0 +1,115 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <istream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "cping/address.hpp"
+#include "cping/ping.hpp"
+#include "cping/visibility.hpp"
+
+namespace cping {
+
+/**
+ * Packet direction, as stored in the pcapng epb_flags option.
+ */
+enum class CaptureDirection : uint8_t {
+    Unknown  = 0,
+    Inbound  = 1,
+    Outbound = 2
+};
+
+/**
+ * One packet read back from a capture: a complete IPv4 datagram.
+ */
+struct CapturedPacket {
+    uint64_t ts_ns{0};                  // UNIX time, nanoseconds
+    CaptureDirection dir{CaptureDirection::Unknown};
+    std::vector<uint8_t> data;          // IPv4 header + ICMP message
+};
+
+/**
+ * Buffered pcapng writer (one raw-IPv4 interface, nanosecond timestamps).
+ *
+ * Producers encode each packet into an Enhanced Packet Block under a
+ * short lock; a background thread writes the accumulated blocks to the
+ * file every 100 ms or once 1 MiB is pending, so the probe path never
+ * waits on disk. If the disk falls more than 64 MiB behind, packets are
+ * dropped and counted instead.
+ *
+ * The engine datagram socket never sees IP headers, so write_icmp()
+ * synthesizes one; the result opens in Wireshark / tcpdump as plain
+ * IPv4 traffic.
+ */
+class CPING_API PcapngWriter {
+public:
+    PcapngWriter() = default;
+    ~PcapngWriter();
+
+    PcapngWriter(const PcapngWriter&) = delete;
+    PcapngWriter& operator=(const PcapngWriter&) = delete;
+
+    /** Create `path` and start the writer thread; false if it cannot be opened. */
+    bool open(const std::string& path);
+
+    /** Write everything still pending, stop the thread and close the file. */
+    void close();
+
+    bool is_open() const { return file_ != nullptr; }
+
+    /** Queue a complete IPv4 packet. Thread-safe. */
+    void write_ipv4(CaptureDirection dir, uint64_t ts_ns,
+                    const uint8_t* packet, size_t len);
+
+    /**
+     * Queue an ICMP message behind a synthesized IPv4 header. Addresses
+     * are in network byte order; 0 means unknown. Thread-safe.
+     */
+    void write_icmp(CaptureDirection dir, uint64_t ts_ns,
+                    uint32_t src_net, uint32_t dst_net, int ttl,
+                    const uint8_t* icmp, size_t len);
+
+    uint64_t packets() const { return packets_.load(); }
+    uint64_t dropped() const { return dropped_.load(); }
+
+private:
+    void run();
+
+    std::FILE* file_{nullptr};
+    std::thread thread_;
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::vector<uint8_t> pending_;      // Encoded blocks not yet written
+    bool stop_{false};
+    std::atomic<uint64_t> packets_{0};
+    std::atomic<uint64_t> dropped_{0};
+};
+
+/**
+ * Read the raw-IPv4 packets of a pcapng stream (little-endian sections,
+ * as written by PcapngWriter or Wireshark on x86). Packets of other link
+ * types are skipped. False on a malformed or truncated file.
+ */
+CPING_API bool read_pcapng(std::istream& in, std::vector<CapturedPacket>& out);
+
+/**
+ * Echo exchanges reconstructed from a capture, per target.
+ */
+struct ReplayTarget {
+    Address target;
+    std::vector<PingProbeResult> probes;    // One per request, in send order
+};
+
+/**
+ * Pair outbound Echo Requests with inbound Echo Replies by (peer, id,
+ * seq) and rebuild per-probe results: RTT from the two capture
+ * timestamps, TTL from the reply header. Requests without a reply in
+ * the capture are lost. Targets appear in order of their first request.
+ */
+CPING_API std::vector<ReplayTarget> replay_capture(const std::vector<CapturedPacket>& packets);
+
+} // namespace cping
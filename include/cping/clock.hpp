@@ -0,0 +1,137 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "cping/visibility.hpp"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  #include <intrin.h>
+#endif
+
+namespace cping {
+
+/**
+ * Calibrated invariant-TSC clock on the steady_clock timeline.
+ *
+ * Once calibrate() succeeded, now() is one RDTSC plus a multiply-shift
+ * (a few ns, no vDSO call) with nanosecond resolution. Before that, or
+ * on a CPU whose TSC is unusable, it is steady_clock::now(). Either way
+ * it returns a steady_clock::time_point with the same epoch
+ * (CLOCK_MONOTONIC on Linux), so its values mix freely with
+ * steady_clock ones, std::condition_variable deadlines and SO_TXTIME.
+ *
+ * The TSC is used only when the CPU advertises an invariant TSC (constant
+ * rate across P-/C-states) and, on Linux, the kernel itself runs its
+ * clocksource on it, which rules out VMs and boards where the TSCs of
+ * different sockets are not synchronised.
+ *
+ * Calibration measures the tick rate against steady_clock over a short
+ * window. The residual rate error would let the clock drift from
+ * CLOCK_MONOTONIC, so about once a second the first now() past that
+ * period re-anchors it: one extra steady_clock sample (a microsecond or
+ * two, on that one call) refines the rate over the whole run and slews
+ * the offset out over the next period, so the clock never steps back.
+ *
+ * The conversion parameters sit behind a sequence lock: calibrate(),
+ * disable() and re-anchoring may run while other threads call now().
+ */
+class CPING_API TscClock {
+public:
+    using duration   = std::chrono::steady_clock::duration;
+    using rep        = duration::rep;
+    using period     = duration::period;
+    using time_point = std::chrono::steady_clock::time_point;
+    static constexpr bool is_steady = true;
+
+    static time_point now() noexcept {
+        if (!active_.load(std::memory_order_acquire))
+            return std::chrono::steady_clock::now();
+
+        const uint64_t t = ticks();
+        Params p = params();
+        if (t > p.base_ticks && t - p.base_ticks > p.period_ticks) {
+            reanchor();
+            p = params();
+        }
+        return convert(t, p);
+    }
+
+    /**
+     * Measure the TSC rate against steady_clock for `window` and switch
+     * now() over to it. False (and steady_clock stays in use) when the
+     * TSC is unsuitable or the measured rate is implausible.
+     */
+    static bool calibrate(std::chrono::milliseconds window = std::chrono::milliseconds(50));
+
+    /** Go back to steady_clock::now(). */
+    static void disable() noexcept { active_.store(false, std::memory_order_release); }
+
+    /** @return true while now() reads the TSC. */
+    static bool active() noexcept { return active_.load(std::memory_order_acquire); }
+
+    /** Invariant TSC present and trusted by the OS (no calibration done). */
+    static bool suitable();
+
+    /** Calibrated TSC frequency in Hz, 0 when not active. */
+    static double frequency_hz() noexcept;
+
+    /** Raw time-stamp counter (0 on CPUs without one). */
+    static uint64_t ticks() noexcept {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+  #if defined(_MSC_VER)
+        return __rdtsc();
+  #else
+        return __builtin_ia32_rdtsc();
+  #endif
+#else
+        return 0;
+#endif
+    }
+
+    /**
+     * Convert a counter value to a time point (needs an active
+     * calibration). Counts before the current anchor map to the anchor.
+     */
+    static time_point from_ticks(uint64_t t) noexcept { return convert(t, params()); }
+
+private:
+    struct Params {
+        uint64_t base_ticks;
+        rep      base_ns;
+        uint64_t mult;                  // ns per tick, 32.32 fixed point
+        uint64_t period_ticks;          // Re-anchor once this far past the base
+    };
+
+    /** Consistent snapshot of the parameters (sequence-lock read side). */
+    static Params params() noexcept {
+        for (;;) {
+            const uint32_t s = seq_.load(std::memory_order_acquire);
+            Params p{ base_ticks_.load(std::memory_order_relaxed),
+                      base_ns_.load(std::memory_order_relaxed),
+                      mult_.load(std::memory_order_relaxed),
+                      period_ticks_.load(std::memory_order_relaxed) };
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (!(s & 1) && seq_.load(std::memory_order_relaxed) == s)
+                return p;
+        }
+    }
+
+    static time_point convert(uint64_t t, const Params& p) noexcept {
+        // (delta * mult) >> 32 without a 128-bit product: split delta in halves
+        const uint64_t d  = t > p.base_ticks ? t - p.base_ticks : 0;
+        const uint64_t ns = (d >> 32) * p.mult + (((d & 0xFFFFFFFFu) * p.mult) >> 32);
+        return time_point(duration(p.base_ns + static_cast<rep>(ns)));
+    }
+
+    static void publish(const Params& p) noexcept;
+    static void reanchor() noexcept;
+
+    static inline std::atomic<bool>     active_{false};
+    static inline std::atomic<uint32_t> seq_{0};          // Odd while a write is in progress
+    static inline std::atomic<uint64_t> base_ticks_{0};
+    static inline std::atomic<rep>      base_ns_{0};
+    static inline std::atomic<uint64_t> mult_{0};
+    static inline std::atomic<uint64_t> period_ticks_{0};
+};
+
+} // namespace cping
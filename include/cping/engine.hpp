@@ -1,9 +1,41 @@
 #pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <stop_token>
 #include <string>
+#include <vector>
 #include "ping.hpp"
+#include "admission.hpp"
 
 namespace cping {
 
+class PcapngWriter;
+
+/**
+ * A single asynchronous probe request for the shared engine.
+ */
+struct ProbeRequest {
+    std::string ip;                        // Target IPv4 address
+    Address addr;                          // Pre-parsed target; used instead of ip if set
+    Address source;                        // Source IPv4 address, empty = routing decides
+    unsigned if_index{0};                  // Egress interface index, 0 = routing decides
+    int timeout_ms{1000};                  // Reply deadline, measured from send
+    int payload_size{0};                   // Extra payload bytes after timestamp
+    int ttl{-1};                           // Custom TTL, -1 = engine default
+    ProbePriority priority{ProbePriority::Normal};
+    uint64_t tag{0};                       // Opaque caller tag, handed back in on_done
+    std::stop_token stop;                  // Cancels the probe (completes as "Cancelled")
+    std::chrono::steady_clock::time_point send_at{};  // Departure time, empty/past = now
+};
+
+/**
+ * Completion callback for submit_probe().
+ * Runs on the engine listener thread (or inline on send failure),
+ * so it must be short and must not block.
+ */
+using ProbeCallback = std::function<void(const PingProbeResult& probe, uint64_t tag)>;
+
 /**
  * Initializes the global ICMP engine.
  * Opens WinPcap capture + raw ICMP socket + listener thread.
@@ -21,11 +53,189 @@ void shutdown_engine();
 /**
  * Executes a single ICMP probe using the shared engine.
  * Returns the best matching PingProbeResult.
+ *
+ * Blocks for a send slot when the in-flight cap is reached.
+ * A stop request on `stop` ends the wait at once (error "Cancelled").
  */
 PingProbeResult ping_once_engine(const std::string& ip,
                                  int timeout_ms,
                                  int payload_size = 0,
-                                 int ttl = -1);
+                                 int ttl = -1,
+                                 ProbePriority priority = ProbePriority::Normal,
+                                 std::stop_token stop = {});
+
+/**
+ * Pre-parsed variant of ping_once_engine(): skips address parsing.
+ */
+PingProbeResult ping_once_engine(const Address& addr,
+                                 int timeout_ms,
+                                 int payload_size = 0,
+                                 int ttl = -1,
+                                 ProbePriority priority = ProbePriority::Normal,
+                                 std::stop_token stop = {});
+
+/**
+ * Submits a probe without waiting for its reply.
+ *
+ * Admission follows `mode` when the in-flight cap is reached:
+ *  - Block:    waits for a send slot, then sends
+ *  - Try:      returns false right away
+ *  - Callback: queues the probe in its priority class and returns
+ *
+ * A stop request on `req.stop` completes the probe right away with
+ * error "Cancelled" and frees its waiter entry and send slot; a Block
+ * submitter waiting for a slot returns false instead. Probes queued in
+ * Callback mode are cancelled when their slot comes up.
+ *
+ * `req.source` / `req.if_index` select the source address and egress
+ * interface of this one packet (IP_PKTINFO on Linux), so probes from
+ * several sources share the engine socket. Not supported by the Windows
+ * engine, which rejects such requests.
+ *
+ * A future `req.send_at` defers the departure: the probe takes its send
+ * slot now and leaves at that instant, handed to the kernel with a
+ * transmit time (set_engine_txtime) or released by the engine's pacer
+ * thread. RTT and timeout count from `send_at`.
+ *
+ * @return true if the probe was accepted; on_done then fires exactly once.
+ *         false if it was rejected (no slot in Try mode, invalid IP or
+ *         source, engine not running, cancelled while blocked); on_done
+ *         is not called.
+ */
+bool submit_probe(const ProbeRequest& req,
+                  ProbeCallback on_done,
+                  AdmitMode mode = AdmitMode::Block);
+
+/**
+ * One host that answered a collecting probe.
+ */
+struct EchoResponder {
+    Address addr;                          // Source of the reply
+    long rtt_us{-1};
+    int ttl{-1};
+};
+
+/**
+ * Outcome of a collecting probe.
+ */
+struct CollectResult {
+    std::vector<EchoResponder> responders;  // Distinct sources, in arrival order
+    std::string error_msg;                  // "Timeout" if nobody answered, "Cancelled", ...
+};
+
+/**
+ * Completion callback for submit_collect(); same threading rules as
+ * ProbeCallback.
+ */
+using CollectCallback = std::function<void(const CollectResult& result, uint64_t tag)>;
+
+/**
+ * Submits a probe that collects every reply until its deadline instead
+ * of completing on the first one: one Echo Request to a broadcast
+ * (e.g. 192.168.1.255) or multicast (224.0.0.1) address finds every
+ * host on the segment that answers such pings.
+ *
+ * Replies are told apart by source address; duplicates from a host
+ * that already answered are ignored. The probe ends at
+ * `req.timeout_ms` (or on cancel / shutdown) with the responders
+ * gathered so far. Admission, `send_at`, source selection and
+ * cancellation work as in submit_probe(). A per-probe `ttl` applies to
+ * that packet only; other multicast probes keep the default of 1 (the
+ * local segment).
+ *
+ * Most hosts ignore broadcast pings by default
+ * (net.ipv4.icmp_echo_ignore_broadcasts on Linux).
+ *
+ * @return true if the probe was accepted; on_done then fires exactly once.
+ */
+bool submit_collect(const ProbeRequest& req,
+                    CollectCallback on_done,
+                    AdmitMode mode = AdmitMode::Block);
+
+/**
+ * Blocking submit_collect(): one probe to `addr`, every responder
+ * within `timeout_ms`.
+ */
+CollectResult ping_collect_engine(const Address& addr,
+                                  int timeout_ms,
+                                  int payload_size = 0,
+                                  int ttl = -1,
+                                  std::stop_token stop = {});
+
+/**
+ * Caps the number of probes on the wire at once (0 = unlimited).
+ * Excess submissions are held back per priority class.
+ */
+void set_max_inflight(int max_probes);
+
+/**
+ * @return number of probes currently holding a send slot.
+ */
+int engine_inflight();
+
+/**
+ * Mirrors every Echo Request the engine sends and every ICMP message it
+ * receives into `writer` (nullptr detaches). Replies carry the kernel
+ * receive timestamp (SO_TIMESTAMPNS on Linux, the capture timestamp on
+ * Windows); requests are stamped just before they are handed to the
+ * kernel. May be called before or after init_engine(); detach before
+ * destroying the writer.
+ */
+void set_engine_capture(PcapngWriter* writer);
+
+/**
+ * Kernel departure scheduling for ProbeRequest::send_at (Linux).
+ *
+ * When enabled, deferred probes are sent at once with an SCM_TXTIME
+ * transmit time (CLOCK_MONOTONIC) and the fq / etf qdisc on the egress
+ * interface releases them at that nanosecond, so large batches can be
+ * submitted in one go while wire spacing stays exact. Other qdiscs
+ * ignore the time and send immediately, so only enable it on an
+ * interface set up with fq (`tc qdisc replace dev eth0 root fq`).
+ *
+ * Returns false when SO_TXTIME is unavailable (old kernel, Windows);
+ * deferred probes then fall back to the userspace pacer. May be called
+ * before or after init_engine().
+ */
+bool set_engine_txtime(bool on);
+
+/**
+ * @return true if deferred probes are currently scheduled by the kernel.
+ */
+bool engine_txtime();
+
+/**
+ * Take engine timestamps (send, receive, deadlines) from the calibrated
+ * TSC (cping::TscClock) instead of steady_clock.
+ *
+ * Takes effect at the next init_engine(), which calibrates the clock
+ * (about 50 ms). Returns false when the CPU has no usable invariant TSC;
+ * the engine then stays on steady_clock.
+ */
+bool set_engine_tsc(bool on);
+
+/**
+ * Receive-side health of the engine socket.
+ *
+ * Replies the kernel drops because the socket's receive queue is full
+ * complete as "Timeout" just like real network loss; rx_dropped tells
+ * the two apart.
+ */
+struct EngineStats {
+    uint64_t rx_dropped{0};        // Datagrams dropped on a full receive queue
+    int      rcvbuf_bytes{0};      // Current receive buffer (kernel accounting)
+    int      rcvbuf_grows{0};      // Automatic receive buffer increases
+};
+
+/**
+ * Counters since the last init_engine().
+ *
+ * On Linux the drop count is the socket's kernel drop counter
+ * (SO_MEMINFO), and every time new drops show up the listener doubles
+ * SO_RCVBUF, up to net.core.rmem_max. On Windows rx_dropped is the
+ * capture's drop count and the buffer is left alone.
+ */
+EngineStats engine_stats();
 
 /**
  * @return true if init_engine() was successfully started.
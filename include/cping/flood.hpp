@@ -0,0 +1,68 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "cping/histogram.hpp"
+#include "cping/ping.hpp"
+#include "cping/visibility.hpp"
+
+namespace cping {
+
+/**
+ * Options for flood mode.
+ */
+struct FloodOptions {
+    std::vector<std::string> targets;   // Probed round-robin
+    int      duration_ms{10000};        // Sending phase length (0 = until max_probes)
+    uint64_t max_probes{0};             // Stop after this many sends (0 = no limit)
+    int      timeout_ms{1000};          // Reply deadline; a timeout counts as loss
+    int      payload_size{0};
+    int      initial_window{8};         // Probes in flight at start
+    int      min_window{1};
+    int      max_window{1024};
+    double   decrease{0.5};             // Multiplicative window cut on loss
+    ProbePriority priority{ProbePriority::Bulk};
+};
+
+/**
+ * Outcome of a flood run.
+ */
+struct FloodStats {
+    uint64_t sent{0};
+    uint64_t received{0};
+    uint64_t lost{0};
+    double   elapsed_s{0};              // Sending phase wall time
+    double   send_pps{0};
+    double   reply_pps{0};
+    double   loss_pct{0};
+    int      final_window{0};
+    int      peak_window{0};
+    size_t   invalid_targets{0};        // Unparsable or non-IPv4, never probed
+    LatencyHistogram latency;           // RTT of every reply
+};
+
+/**
+ * ping -f style flood with an AIMD-controlled window of outstanding
+ * probes, built on the shared engine (init_engine must have succeeded).
+ *
+ * The window starts in slow start (+1 per reply, doubling per round
+ * trip) until the first loss, then grows by one probe per window of
+ * clean replies. A lost probe cuts it by `decrease`, at most once per
+ * window so a burst of timeouts is treated as one congestion event.
+ * A new probe is sent whenever a reply frees room in the window, so the
+ * achieved rate tracks what the path (or a rate-limiting firewall)
+ * actually answers.
+ *
+ * Targets are validated once up front; invalid ones are reported in
+ * `invalid_targets` and never probed, so they neither count as loss nor
+ * shrink the window.
+ *
+ * Blocks until the sending phase ends and in-flight probes settle.
+ * `keep_running` (optional) stops the sending phase early.
+ */
+CPING_API FloodStats run_flood(const FloodOptions& opt,
+                               const std::atomic<bool>* keep_running = nullptr);
+
+} // namespace cping
@@ -0,0 +1,129 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "cping/histogram.hpp"
+#include "cping/ping.hpp"
+#include "cping/target_table.hpp"
+#include "cping/visibility.hpp"
+
+namespace cping {
+
+class PrefixTrie;
+
+/**
+ * Dense group identifier: index into a GroupIndex.
+ */
+using GroupId = uint32_t;
+
+inline constexpr GroupId kNoGroup = 0xFFFFFFFFu;
+
+/**
+ * Point-in-time rollup of one group.
+ */
+struct GroupSummary {
+    std::string name;             // "10.1.2.0/24", "site:fra1", "web", ...
+    size_t   members{0};          // Targets mapped to this group
+    uint64_t sent{0};             // Completed probes (replied + lost)
+    uint64_t received{0};
+    double   loss_pct{0.0};
+    uint64_t min_us{0};
+    double   mean_us{0.0};
+    uint64_t p50_us{0};
+    uint64_t p90_us{0};
+    uint64_t p99_us{0};
+    uint64_t max_us{0};
+};
+
+/**
+ * Hierarchical result aggregation for large target sets.
+ *
+ * Targets are mapped to up to kMaxMemberships groups at load time
+ * (typically their /24, a site tag and a service group). Every probe
+ * completion is folded straight into the accumulators of those groups,
+ * so a rollup read costs O(groups) and never rescans per-target data.
+ *
+ * Membership is stored as a fixed-width dense column (16 B per target).
+ * record() is safe to call from the engine listener while another thread
+ * reads summaries.
+ */
+class CPING_API GroupIndex {
+public:
+    static constexpr int kMaxMemberships = 4;
+
+    /** Find or create a group by name (load time). */
+    GroupId group(const std::string& name);
+
+    /** Map a target to a group; false if it already has kMaxMemberships. */
+    bool assign(TargetId target, GroupId g);
+
+    /** Map every target of the table to its IPv4 /24 (or IPv6 /64). */
+    void assign_prefixes(const TargetTable& table);
+
+    /**
+     * Map every target to the group of its longest matching prefix in
+     * `trie`, whose values are GroupIds of this index (see
+     * load_prefix_list). Targets without a match are left alone.
+     */
+    void assign_matches(const TargetTable& table, const PrefixTrie& trie);
+
+    /** Fold one probe outcome into every group of the target. */
+    void record(TargetId target, const PingProbeResult& probe);
+
+    /**
+     * Add counters and RTTs gathered elsewhere (another GroupIndex with
+     * the same group ids, e.g. in a worker process) to group `g`.
+     */
+    void merge(GroupId g, uint64_t sent, uint64_t received, const LatencyHistogram& hist);
+
+    size_t group_count() const;
+    GroupSummary summary(GroupId g) const;
+    std::vector<GroupSummary> summaries() const;
+
+    /** Copy of a group's RTT histogram (for export or further merging). */
+    LatencyHistogram histogram(GroupId g) const;
+
+    /** Name of the /24 (IPv4) or /64 (IPv6) prefix holding a target. */
+    static std::string prefix_name(const TargetTable& table, TargetId target);
+
+private:
+    struct Accumulator {
+        std::string name;
+        size_t   members{0};
+        uint64_t sent{0};
+        uint64_t received{0};
+        LatencyHistogram hist;
+    };
+
+    GroupSummary summarize(const Accumulator& acc) const;
+
+    mutable std::mutex mtx_;
+    std::vector<Accumulator> groups_;
+    std::unordered_map<std::string, GroupId> by_name_;
+    std::vector<GroupId> membership_;     // kMaxMemberships per target
+};
+
+/**
+ * Load a target list into `table` (and optionally `groups`).
+ *
+ * Format: one target per line, `<ip> [label...]`; blank lines and
+ * `#` comments are ignored. Every label becomes a group, and when
+ * `groups` is given each target is also mapped to its /24.
+ * Targets inside a prefix of `exclude` are dropped. IPv6 targets are
+ * skipped too, since the engine probes IPv4 only; their number is added
+ * to `unsupported` so callers can tell the user.
+ *
+ * @return number of targets added; unparsable, excluded and IPv6 lines
+ *         are skipped.
+ */
+CPING_API size_t load_target_list(std::istream& in,
+                                  TargetTable& table,
+                                  GroupIndex* groups = nullptr,
+                                  const PrefixTrie* exclude = nullptr,
+                                  size_t* unsupported = nullptr);
+
+} // namespace cping
@@ -0,0 +1,69 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include "cping/visibility.hpp"
+
+namespace cping {
+
+/**
+ * Fixed-size, mergeable RTT histogram (microsecond resolution).
+ *
+ * Log-linear layout in the spirit of HdrHistogram: values below 8 us get
+ * one bucket each, every power of two above is split into 8 sub-buckets.
+ * That bounds the relative error of any percentile to ~6% while covering
+ * 0 us .. ~67 s in 192 counters. Merging is a plain element-wise add, so
+ * per-target histograms can be rolled up into groups or across processes.
+ */
+class CPING_API LatencyHistogram {
+public:
+    static constexpr int      kSubBits    = 3;
+    static constexpr int      kSubBuckets = 1 << kSubBits;
+    static constexpr int      kMaxExp     = 25;      // Top octave [2^25, 2^26) us
+    static constexpr int      kBuckets    = kSubBuckets + (kMaxExp - kSubBits + 1) * kSubBuckets;
+    static constexpr uint64_t kMaxValueUs = (uint64_t(1) << (kMaxExp + 1)) - 1;
+
+    /** Add `n` samples of `us` microseconds (clamped to kMaxValueUs). */
+    void record(uint64_t us, uint32_t n = 1);
+
+    /**
+     * Record `us` and, HdrHistogram-style, back-fill the samples a
+     * fixed-rate sender would have taken while this one was stalled:
+     * us - interval, us - 2*interval, ... down to interval. Use it for
+     * latencies measured against a schedule of `expected_interval_us` so
+     * a stall counts once per omitted probe, not once in total.
+     */
+    void record_corrected(uint64_t us, uint64_t expected_interval_us);
+
+    /** Element-wise add of another histogram. */
+    void merge(const LatencyHistogram& other);
+
+    void clear();
+
+    uint64_t count()  const { return count_; }
+    uint64_t min_us() const { return count_ ? min_ : 0; }
+    uint64_t max_us() const { return count_ ? max_ : 0; }
+    double   mean_us() const;
+
+    /**
+     * Value at percentile p (0..100), reported as the midpoint of the
+     * bucket holding that rank and clamped to the observed min/max.
+     */
+    uint64_t percentile_us(double p) const;
+
+    /** Raw bucket access, used by serializers. */
+    uint32_t bucket(int idx) const { return counts_[idx]; }
+    void     add_bucket(int idx, uint32_t n);
+
+    static int      bucket_of(uint64_t us);
+    static uint64_t bucket_lower(int idx);
+    static uint64_t bucket_width(int idx);
+
+private:
+    std::array<uint32_t, kBuckets> counts_{};
+    uint64_t count_{0};
+    uint64_t sum_{0};
+    uint64_t min_{0};
+    uint64_t max_{0};
+};
+
+} // namespace cping
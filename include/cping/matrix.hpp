@@ -0,0 +1,109 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include "cping/address.hpp"
+#include "cping/ping.hpp"
+#include "cping/visibility.hpp"
+
+namespace cping {
+
+/**
+ * One row of a reachability matrix: where probes are sent from.
+ * Either a source address, an egress interface, or both.
+ */
+struct MatrixSource {
+    std::string label;              // As given on input (address or interface name)
+    Address     addr;               // Source address, empty = routing decides
+    unsigned    if_index{0};        // Egress interface, 0 = routing decides
+};
+
+/**
+ * Resolve a source spec: an IPv4 address, or an interface name.
+ * @return false if it is neither
+ */
+CPING_API bool parse_matrix_source(const std::string& spec, MatrixSource& out);
+
+/**
+ * Options for run_matrix().
+ */
+struct MatrixOptions {
+    int  probes{3};                 // Probes per (source, target) pair
+    int  timeout_ms{1000};          // Reply deadline per probe
+    int  rate_pps{20000};           // Send pacing across all pairs (0 = unpaced)
+    int  payload_size{0};
+    int  ttl{-1};
+    ProbePriority priority{ProbePriority::Bulk};
+};
+
+/**
+ * Loss and RTT percentiles of one (source, target) pair.
+ * RTT fields are microseconds and 0 when nothing replied.
+ */
+struct MatrixCell {
+    uint32_t sent{0};
+    uint32_t received{0};
+    uint32_t min_us{0};
+    uint32_t p50_us{0};
+    uint32_t p90_us{0};
+    uint32_t p99_us{0};
+    uint32_t max_us{0};
+
+    double loss_pct() const {
+        return sent ? 100.0 * (sent - received) / sent : 0.0;
+    }
+};
+
+/**
+ * Dense sources x targets result, cells in row-major order.
+ */
+struct ReachabilityMatrix {
+    std::vector<std::string> sources;
+    std::vector<std::string> targets;
+    std::vector<MatrixCell>  cells;
+
+    const MatrixCell& at(size_t s, size_t t) const { return cells[s * targets.size() + t]; }
+};
+
+/**
+ * Probe every (source, target) pair `opt.probes` times over the shared
+ * engine (init_engine must have succeeded).
+ *
+ * All pairs are multiplexed on the one engine socket: each packet picks
+ * its source address / egress interface through ProbeRequest::source and
+ * ::if_index, and replies are matched by sequence number as usual. Sends
+ * are paced at `rate_pps` and walk targets fastest, so consecutive
+ * packets to one target are a full row apart.
+ *
+ * Blocks until every probe has completed; `keep_running` (optional)
+ * stops sending early, unsent probes are not counted.
+ */
+CPING_API ReachabilityMatrix run_matrix(const std::vector<MatrixSource>& sources,
+                                        const std::vector<Address>& targets,
+                                        const MatrixOptions& opt,
+                                        const std::atomic<bool>* keep_running = nullptr);
+
+/**
+ * CSV, one line per pair:
+ * source,target,sent,received,loss_pct,min_us,p50_us,p90_us,p99_us,max_us
+ */
+CPING_API bool write_matrix_csv(const ReachabilityMatrix& m, std::ostream& out);
+
+/**
+ * Compact binary form, all integers little-endian:
+ *
+ *   "CPMX"  u16 version (1)  u16 reserved  u32 sources  u32 targets
+ *   per source, then per target:  u16 length + label bytes
+ *   per cell (row-major):         7 x u32 (MatrixCell field order)
+ *
+ * 28 bytes per cell, so a 100 x 10 000 fabric fits in ~28 MB.
+ * read_matrix_binary() refuses a header claiming more than 2^26 cells,
+ * or more than a seekable stream has left, before allocating anything.
+ */
+CPING_API bool write_matrix_binary(const ReachabilityMatrix& m, std::ostream& out);
+CPING_API bool read_matrix_binary(std::istream& in, ReachabilityMatrix& m);
+
+} // namespace cping
@@ -0,0 +1,102 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include "cping/histogram.hpp"
+#include "cping/ping.hpp"
+#include "cping/target_table.hpp"
+#include "cping/visibility.hpp"
+
+namespace cping {
+
+/**
+ * Options for the multi-target monitor.
+ */
+struct MonitorOptions {
+    int interval_ms{1000};                        // Per-target probe interval
+    int timeout_ms{1000};                         // Reply deadline per probe
+    int payload_size{0};                          // Extra payload bytes
+    int ttl{-1};                                  // Custom TTL, -1 = default
+    ProbePriority priority{ProbePriority::Bulk};  // Engine scheduling class
+    size_t max_batch{1024};                       // Targets submitted per tick
+};
+
+/**
+ * Multi-target monitoring pipeline on top of the shared engine.
+ *
+ * Each tick collects the due targets from a TargetTable and submits them
+ * asynchronously with the TargetId as probe tag. Completions update the
+ * table and are then fanned out to the registered result hooks (group
+ * rollups, detectors, sinks). They may arrive on the engine listener
+ * thread, on the thread that freed an admission slot, or inline in tick()
+ * for rejected probes, but never concurrently: hooks need no locking of
+ * their own, should stay short and must not wait on probes.
+ *
+ * Targets stay on their intended send grid, and besides the raw RTT the
+ * monitor keeps a coordinated-omission corrected latency distribution:
+ * completion time minus *intended* send time, plus HDR-style back-fill
+ * for the slots TargetTable::collect_due dropped when it re-anchored a
+ * target after a stall. Scheduler hiccups and admission
+ * queueing therefore show up in the tail instead of vanishing from it.
+ *
+ * The engine must be running (init_engine) while the monitor ticks.
+ */
+class CPING_API Monitor {
+public:
+    using ResultHook = std::function<void(TargetId, const PingProbeResult&)>;
+
+    explicit Monitor(TargetTable& table, MonitorOptions opt = {});
+
+    Monitor(const Monitor&) = delete;
+    Monitor& operator=(const Monitor&) = delete;
+
+    /** Register a per-completion hook; call before the first tick(). */
+    void add_hook(ResultHook hook);
+
+    /** Submit every target due now; returns the number submitted. */
+    size_t tick();
+
+    /** Tick until `duration` elapses (or keep_running turns false). */
+    void run_for(std::chrono::milliseconds duration,
+                 const std::atomic<bool>* keep_running = nullptr);
+
+    /** Wait until no probe is outstanding, at most `max_wait`. */
+    bool wait_idle(std::chrono::milliseconds max_wait);
+
+    /** Snapshot of raw RTTs of all successful probes. */
+    LatencyHistogram raw_latency() const;
+
+    /** Snapshot of latencies measured from intended send times. */
+    LatencyHistogram corrected_latency() const;
+
+    int      outstanding() const { return outstanding_.load(); }
+    uint64_t completed()   const { return completed_.load(); }
+
+    /** Steady-clock timestamp in microseconds (the table's time base). */
+    static int64_t now_us();
+
+private:
+    void on_done(TargetId id, const PingProbeResult& probe,
+                 int64_t intended_us, uint32_t skipped);
+
+    TargetTable& table_;
+    MonitorOptions opt_;
+    std::vector<ResultHook> hooks_;
+    std::vector<TargetId> due_;
+    std::vector<int64_t>  intended_;
+    std::vector<uint32_t> skipped_;
+
+    std::mutex done_mtx_;                  // Serialises on_done()
+    mutable std::mutex hist_mtx_;
+    LatencyHistogram raw_;
+    LatencyHistogram corrected_;
+
+    std::atomic<int>      outstanding_{0};
+    std::atomic<uint64_t> completed_{0};
+};
+
+} // namespace cping
@@ -0,0 +1,150 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <istream>
+#include <string>
+#include <vector>
+#include "cping/ping.hpp"
+#include "cping/target_table.hpp"
+#include "cping/visibility.hpp"
+
+namespace cping {
+
+/**
+ * Availability state of a monitored target.
+ */
+enum class TargetState : unsigned char {
+    Unknown,     // No verdict yet (startup, or never answered)
+    Up,          // Replies arriving normally
+    Degraded,    // Replying, but with elevated loss or RTT
+    Down         // Consecutive losses past the threshold
+};
+
+/**
+ * One closed interval during which a target stayed in a single state.
+ * Timestamps are wall-clock milliseconds since the Unix epoch.
+ */
+struct OutageRecord {
+    std::string target;
+    TargetState state{TargetState::Unknown};
+    int64_t  start_ms{0};
+    int64_t  end_ms{0};
+    uint32_t probes{0};
+    uint32_t lost{0};
+    uint32_t rtt_min_us{0};
+    uint32_t rtt_avg_us{0};
+    uint32_t rtt_max_us{0};
+};
+
+/**
+ * Thresholds driving state transitions.
+ */
+struct OutagePolicy {
+    uint16_t down_after{3};          // Consecutive losses that mean Down
+    uint16_t up_after{2};            // Consecutive replies that end Down
+    double   degraded_loss{0.2};     // Smoothed loss rate that means Degraded
+    uint32_t degraded_rtt_us{0};     // Smoothed RTT that means Degraded (0 = off)
+    double   alpha{0.1};             // Smoothing for loss rate / RTT
+};
+
+using OutageSink = std::function<void(const OutageRecord&)>;
+
+/**
+ * Incremental per-target state machine that emits only transitions.
+ *
+ * Probe outcomes are folded into the open interval of each target; when
+ * the state changes the interval is closed and handed to the sink. Storage
+ * therefore grows with the number of incidents, not with probe count.
+ * Interval boundaries are backdated to the first probe of the run that
+ * confirmed the change (e.g. the first of the `down_after` losses), and
+ * those losses are counted in the Down interval, not the one it closes.
+ *
+ * Not thread-safe: feed it from one thread at a time (Monitor serialises
+ * its hooks).
+ */
+class CPING_API OutageTracker {
+public:
+    OutageTracker(const TargetTable& table, OutagePolicy policy, OutageSink sink);
+
+    /** Fold one probe outcome observed at `now_ms`. */
+    void observe(TargetId id, const PingProbeResult& probe, int64_t now_ms);
+
+    /** Close every open interval at `now_ms` (shutdown / log rotation). */
+    void flush(int64_t now_ms);
+
+    TargetState state(TargetId id) const { return slots_[id].state; }
+
+    /** Wall-clock milliseconds since the Unix epoch. */
+    static int64_t now_ms();
+
+private:
+    struct Slot {
+        int64_t  start_ms{0};
+        int64_t  run_start_ms{0};    // First probe of the current ok/fail run
+        uint64_t rtt_sum_us{0};
+        uint32_t probes{0};
+        uint32_t lost{0};
+        uint32_t received{0};
+        uint32_t rtt_min_us{0};
+        uint32_t rtt_max_us{0};
+        float    loss_rate{0};
+        float    srtt_us{0};
+        uint16_t ok_run{0};
+        uint16_t fail_run{0};
+        TargetState state{TargetState::Unknown};
+    };
+
+    void transition(TargetId id, Slot& s, TargetState next, int64_t at_ms,
+                    uint32_t carried_losses = 0);
+    OutageRecord close(TargetId id, const Slot& s, int64_t end_ms) const;
+
+    const TargetTable& table_;
+    OutagePolicy policy_;
+    OutageSink sink_;
+    std::vector<Slot> slots_;
+};
+
+/**
+ * Append-only CSV sink for OutageRecords.
+ *
+ * Line format:
+ *   target,state,start_ms,end_ms,probes,lost,rtt_min_us,rtt_avg_us,rtt_max_us
+ */
+class CPING_API OutageLogWriter {
+public:
+    explicit OutageLogWriter(const std::string& path, bool append = true);
+
+    bool ok() const { return static_cast<bool>(out_); }
+    void write(const OutageRecord& rec);
+
+private:
+    std::ofstream out_;
+};
+
+/**
+ * Time spent per state inside a window, plus derived percentages.
+ */
+struct AvailabilityReport {
+    int64_t up_ms{0};
+    int64_t degraded_ms{0};
+    int64_t down_ms{0};
+    int64_t unknown_ms{0};
+    double  availability_pct{0.0};   // (up + degraded) / known time
+    double  slo_pct{0.0};            // up / known time
+};
+
+/** Parse an outage log written by OutageLogWriter (bad lines skipped). */
+CPING_API std::vector<OutageRecord> read_outage_log(std::istream& in);
+
+/**
+ * Availability over [from_ms, to_ms) for one target, or for all targets
+ * combined when `target` is empty.
+ */
+CPING_API AvailabilityReport availability(const std::vector<OutageRecord>& log,
+                                          const std::string& target,
+                                          int64_t from_ms, int64_t to_ms);
+
+CPING_API const char* to_string(TargetState state);
+
+} // namespace cping
@@ -1,6 +1,9 @@
 #pragma once
+#include <stop_token>
+#include <functional>
 #include <string>
 #include <vector>
+#include "cping/address.hpp"
 #include "cping/visibility.hpp"
 
 namespace cping {
@@ -11,6 +14,7 @@ namespace cping {
 struct PingProbeResult {
     bool success{false};           // Whether a valid reply was received
     long rtt_ms{-1};               // RTT in milliseconds (-1 = invalid)
+    long rtt_us{-1};               // RTT in microseconds (-1 = not measured)
     int  ttl{-1};                  // Observed TTL (-1 = invalid)
     std::string if_name;           // Interface used (optional)
     std::string error_msg;         // Error detail (empty if success=true)
@@ -22,12 +26,27 @@ struct PingProbeResult {
  * Contains:
  * - Best RTT/TTL observed
  * - Full trace of all probe attempts
+ * - RTT of the warmup probe, kept apart from the measured attempts
  */
 struct PingResult {
     bool reachable{false};                // At least one successful reply
     long rtt_ms{-1};                      // Best RTT in ms
     int  ttl{-1};                         // TTL associated with best RTT
     std::vector<PingProbeResult> probes;  // Details for each attempt
+    long warmup_rtt_us{-1};               // First warmup reply RTT (-1 = none)
+};
+
+/**
+ * Scheduling class of a probe submitted to the shared engine.
+ *
+ * When the engine's in-flight cap is reached, queued probes are admitted
+ * strictly by class: a High probe always takes the next free send slot
+ * ahead of any queued Normal or Bulk probe.
+ */
+enum class ProbePriority : unsigned char {
+    High   = 0,                           // Interactive / latency-sensitive checks
+    Normal = 1,                           // Default class
+    Bulk   = 2                            // Sweeps and background scans
 };
 
 /**
@@ -36,11 +55,22 @@ struct PingResult {
 struct PingOptions {
     int timeout_ms{1000};                 // Timeout per probe (ms)
     int retries{1};                       // Number of sequential attempts
-    std::string if_name;                  // Interface name/substring filter
+    std::string if_name;                  // Interface name/substring filter (bypasses the engine)
     bool stop_on_first_success{true};     // Early exit on first valid reply
     int payload_size{0};                  // Extra payload bytes after timestamp
     int ttl{-1};                          // Custom TTL, -1 = system default
     bool timestamp{false};                // Print timestamp in CLI output
+    ProbePriority priority{ProbePriority::Normal}; // Engine scheduling class
+
+    /**
+     * Unrecorded probes before the attempts. The first probe to an
+     * on-link host usually pays for ARP/ND resolution and route-cache
+     * misses, so ping_host() first sends up to this many, stopping at the
+     * first reply; they count neither as attempts nor towards
+     * rtt_ms/probes, and the RTT of the reply is reported as
+     * PingResult::warmup_rtt_us.
+     */
+    int warmup{0};
 };
 
 /**
@@ -53,4 +83,39 @@ CPING_API PingResult ping_host(const std::string& ip, int timeout_ms);
  */
 CPING_API PingResult ping_host(const std::string& ip, const PingOptions& opt);
 
+/**
+ * Cancellable variant: a stop request ends the probe in flight at once
+ * (error "Cancelled", slot freed) and skips the remaining retries.
+ */
+CPING_API PingResult ping_host(const std::string& ip, const PingOptions& opt,
+                               std::stop_token stop);
+
+/**
+ * Per-probe callback for streaming ping_host(). Called on the caller's
+ * thread as soon as each attempt completes; `attempt` is 0-based.
+ * Return false to skip the remaining attempts.
+ */
+using ProbeVisitor = std::function<bool(const PingProbeResult& probe, int attempt)>;
+
+/**
+ * Streaming variant: every probe is handed to `on_probe` by reference
+ * and not stored, so the returned PingResult carries reachable / best
+ * RTT / TTL but an empty `probes` vector.
+ */
+CPING_API PingResult ping_host(const std::string& ip, const PingOptions& opt,
+                               const ProbeVisitor& on_probe,
+                               std::stop_token stop = {});
+
+/**
+ * Pre-parsed target variants: nothing is parsed or formatted per call,
+ * for callers probing the same targets at high rate. Only IPv4
+ * addresses can be probed; anything else fails as "Invalid IP address".
+ */
+CPING_API PingResult ping_host(const Address& addr, const PingOptions& opt,
+                               std::stop_token stop = {});
+
+CPING_API PingResult ping_host(const Address& addr, const PingOptions& opt,
+                               const ProbeVisitor& on_probe,
+                               std::stop_token stop = {});
+
 } // namespace cping
@@ -0,0 +1,95 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <string_view>
+#include <vector>
+#include "cping/address.hpp"
+#include "cping/visibility.hpp"
+
+namespace cping {
+
+class GroupIndex;
+
+/**
+ * Longest-prefix-match table of IPv4 / IPv6 prefixes, each carrying a
+ * 32-bit value (a GroupId, a rule number, ...).
+ *
+ * Path-compressed binary radix trie (Patricia): a node exists only where
+ * a prefix ends or two prefixes diverge, so a lookup visits at most one
+ * node per distinct prefix length on its path and compares whole 64-bit
+ * words along the way -- O(address bits), independent of the number of
+ * prefixes. IPv4 and IPv6 live in separate trees, so an IPv4 lookup
+ * walks at most 32 bits.
+ *
+ * Nodes sit in one flat vector linked by index. Build once (insert() is
+ * not thread-safe); lookups are const and may run on any number of
+ * threads afterwards.
+ */
+class CPING_API PrefixTrie {
+public:
+    static constexpr uint32_t kNoValue = 0xFFFFFFFFu;
+
+    PrefixTrie();
+
+    /**
+     * Add `addr`/`len` (len in bits of the address family; host bits are
+     * ignored). Re-inserting a prefix replaces its value.
+     *
+     * @return false if `addr` is empty or `len` is out of range
+     */
+    bool insert(const Address& addr, int len, uint32_t value);
+
+    /** Add "a.b.c.d/len", "v6::/len" or a single address. */
+    bool insert(std::string_view cidr, uint32_t value);
+
+    /** Value of the longest prefix holding `addr`, or kNoValue. */
+    uint32_t lookup(const Address& addr) const noexcept;
+
+    /** lookup() for an IPv4 address in host byte order (sweep path). */
+    uint32_t lookup_v4(uint32_t host_order) const noexcept;
+
+    bool contains(const Address& addr) const noexcept { return lookup(addr) != kNoValue; }
+    bool contains_v4(uint32_t host_order) const noexcept { return lookup_v4(host_order) != kNoValue; }
+
+    size_t size()  const { return prefixes_; }
+    bool   empty() const { return prefixes_ == 0; }
+    void   clear();
+
+private:
+    static constexpr uint32_t kNil = 0xFFFFFFFFu;
+
+    struct Node {
+        uint64_t hi{0}, lo{0};          // Prefix bits, MSB first, host bits zero
+        uint32_t child[2]{kNil, kNil};
+        uint32_t value{kNoValue};
+        uint8_t  len{0};
+    };
+
+    bool insert_key(uint32_t root, uint64_t hi, uint64_t lo, int len, uint32_t value);
+    uint32_t lookup_key(uint32_t root, uint64_t hi, uint64_t lo, int max_len) const noexcept;
+
+    std::vector<Node> nodes_;           // [0] IPv4 root, [1] IPv6 root
+    size_t prefixes_{0};
+};
+
+/**
+ * Parse "a.b.c.d/len" or "v6::/len"; a bare address is a host prefix.
+ */
+CPING_API bool parse_prefix(std::string_view text, Address& addr, int& len);
+
+/**
+ * Load a prefix file into `trie`.
+ *
+ * Format: one prefix per line, `<cidr> [label]`; blank lines and `#`
+ * comments are ignored. With `groups`, each label becomes a group and
+ * the prefix maps to its GroupId (lines without a label are skipped);
+ * without, every prefix maps to its 0-based line number among the valid
+ * ones, which suits exclusion lists.
+ *
+ * @return number of prefixes added; unparsable lines are skipped.
+ */
+CPING_API size_t load_prefix_list(std::istream& in, PrefixTrie& trie,
+                                  GroupIndex* groups = nullptr);
+
+} // namespace cping
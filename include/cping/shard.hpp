@@ -0,0 +1,77 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "cping/groups.hpp"
+#include "cping/histogram.hpp"
+#include "cping/monitor.hpp"
+#include "cping/target_table.hpp"
+#include "cping/visibility.hpp"
+
+namespace cping {
+
+/**
+ * Options for run_sharded().
+ */
+struct ShardOptions {
+    int  workers{0};                // Worker processes (0 = one per NUMA node)
+    bool pin{true};                 // Pin each worker to its node / core group
+    int  rounds{1};                 // Probe rounds per target (< 0 = until stopped)
+    std::string if_name;            // Engine interface of every worker
+    MonitorOptions monitor;         // Per-worker monitor settings
+};
+
+/**
+ * Final per-target state reported by a worker.
+ */
+struct TargetRecord {
+    uint32_t sent{0};
+    uint32_t lost{0};
+    uint32_t srtt_us{0};
+    uint32_t rttvar_us{0};
+};
+
+/**
+ * Unified outcome of a sharded run.
+ */
+struct ShardedResult {
+    int workers{0};                         // Workers started
+    int workers_ok{0};                      // Workers that reported back
+    std::vector<TargetRecord> targets;      // Indexed by the input TargetId
+    LatencyHistogram raw;                   // Merged Monitor::raw_latency()
+    LatencyHistogram corrected;             // Merged Monitor::corrected_latency()
+};
+
+/**
+ * CPU sets for `workers` worker processes: the NUMA nodes' CPU lists
+ * when there is one worker per node, otherwise the allowed CPUs split
+ * into contiguous core groups. Empty groups mean "do not pin".
+ */
+CPING_API std::vector<std::vector<int>> shard_cpu_groups(int workers);
+
+/**
+ * Scale-out monitor: shards `table` across worker processes on this
+ * machine, each running its own engine and Monitor over a contiguous
+ * slice of the targets, and merges what they report.
+ *
+ * Workers are forked, so they inherit the parsed table and `groups`
+ * without re-reading anything. Each one sends back its per-target
+ * records, its raw and corrected latency histograms and the counters
+ * and histograms of every group it touched, over a pipe in native
+ * layout (same executable image). Group rollups are merged into
+ * `groups` (optional); everything else lands in `out`.
+ *
+ * Must be called before init_engine() and before the process starts
+ * other threads. `keep_running` is read by the workers as inherited,
+ * so a SIGINT handler that clears it stops every worker (they share
+ * the terminal's process group). POSIX only; returns false elsewhere
+ * or if no worker could be started.
+ */
+CPING_API bool run_sharded(const TargetTable& table,
+                           GroupIndex* groups,
+                           const ShardOptions& opt,
+                           ShardedResult& out,
+                           const std::atomic<bool>* keep_running = nullptr);
+
+} // namespace cping
@@ -0,0 +1,212 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "cping/address.hpp"
+#include "cping/ping.hpp"
+#include "cping/visibility.hpp"
+
+namespace cping {
+
+class PrefixTrie;
+
+/**
+ * A contiguous IPv4 block to sweep: `size` addresses from `first`
+ * (host byte order).
+ */
+struct SweepRange {
+    uint32_t first{0};
+    uint64_t size{0};
+
+    bool operator==(const SweepRange&) const = default;
+};
+
+/**
+ * Parse "a.b.c.d/len" (host bits are ignored) or a single address.
+ * Prefixes shorter than /8 are rejected: the responder bitmap of a /8
+ * is already 2 MiB.
+ */
+CPING_API bool parse_sweep_range(std::string_view cidr, SweepRange& out);
+
+/**
+ * Visiting order of a sweep: a full-period linear congruential sequence
+ * modulo the next power of two above `n`, with values >= n skipped
+ * (cycle walking), so every offset comes up exactly once and consecutive
+ * probes land far apart in the range. The whole position is one 64-bit
+ * state, which is what a checkpoint stores.
+ */
+class CPING_API SweepPermutation {
+public:
+    SweepPermutation(uint64_t n, uint64_t seed);
+
+    /** Next offset in [0, n); false once all n have been produced. */
+    bool next(uint64_t& offset);
+
+    uint64_t state()   const { return x_; }
+    uint64_t emitted() const { return emitted_; }
+
+    /** Continue from a saved (state, emitted) pair. */
+    void restore(uint64_t state, uint64_t emitted) { x_ = state; emitted_ = emitted; }
+
+private:
+    uint64_t n_;
+    uint64_t mask_;
+    uint64_t a_;
+    uint64_t c_;
+    uint64_t x_;
+    uint64_t emitted_{0};
+};
+
+/**
+ * One host that answered, by offset into the range.
+ */
+struct SweepResponder {
+    uint32_t offset{0};
+    uint32_t rtt_us{0};
+    uint8_t  ttl{0};
+};
+
+/**
+ * Result and resume point of a (possibly unfinished) sweep.
+ *
+ * `bitmap` holds one bit per address (bit i of word i / 64 for offset
+ * i), set once the address replied; `responders` adds the RTT / TTL of
+ * each of them. Every permutation position before (`perm_state`,
+ * `done`) has settled, so a resumed sweep continues right there and
+ * re-probes at most the window that was in flight when it stopped.
+ */
+struct SweepState {
+    SweepRange range;
+    uint64_t seed{0};
+    uint64_t perm_state{0};
+    uint64_t done{0};                           // Addresses settled
+    std::vector<uint64_t> bitmap;
+    std::vector<SweepResponder> responders;     // Completion order
+
+    bool complete() const { return done >= range.size; }
+
+    bool alive(uint64_t offset) const {
+        return (bitmap[offset >> 6] >> (offset & 63)) & 1u;
+    }
+
+    uint32_t address(uint64_t offset) const {
+        return range.first + static_cast<uint32_t>(offset);
+    }
+};
+
+/** Fresh state for `range`; `seed` picks the visiting order. */
+CPING_API SweepState new_sweep(const SweepRange& range, uint64_t seed = 0);
+
+/**
+ * Options for run_sweep().
+ */
+struct SweepOptions {
+    int rate_pps{10000};                // Send pacing (0 = unpaced)
+    int timeout_ms{1000};
+    int window{4096};                   // Probes in flight at most
+    int checkpoint_ms{5000};            // Checkpoint period
+    std::string checkpoint_path;        // Empty = no checkpoints
+    int payload_size{0};
+    int ttl{-1};
+    ProbePriority priority{ProbePriority::Bulk};
+    const PrefixTrie* exclude{nullptr}; // Addresses never probed (settle as silent)
+};
+
+/**
+ * Probe the rest of `st` over the shared engine (init_engine must have
+ * succeeded), one probe per address in permutation order.
+ *
+ * With a checkpoint path, the state is written there every
+ * `checkpoint_ms` and once more on return (to a temporary file, then
+ * renamed, so a crash never leaves a torn checkpoint). `keep_running`
+ * (optional) stops sending early; probes in flight still settle first.
+ * A probe that could not be sent (rejected, send failure, engine shut
+ * down) also stops the sweep, and the resume point stays before it.
+ *
+ * @return true when the whole range has been probed.
+ */
+CPING_API bool run_sweep(SweepState& st, const SweepOptions& opt,
+                         const std::atomic<bool>* keep_running = nullptr);
+
+/**
+ * Binary checkpoint / result format, all integers little-endian:
+ *
+ *   "CPSW"  u16 version (1)  u16 reserved  u32 first  u64 size  u64 seed
+ *   u64 perm_state  u64 done  u64 responders
+ *   ceil(size / 64) x u64   bitmap words
+ *   per responder:          u32 offset  u32 rtt_us  u8 ttl
+ */
+CPING_API bool write_sweep_state(const SweepState& st, std::ostream& out);
+CPING_API bool read_sweep_state(std::istream& in, SweepState& st);
+
+/** write_sweep_state() to `path` atomically (temporary file + rename). */
+CPING_API bool save_sweep_state(const SweepState& st, const std::string& path);
+
+/**
+ * Finished sweep state for `range` with the given hosts marked alive
+ * (no RTT records), e.g. to rescan from a plain responder list.
+ * Addresses outside the range are ignored.
+ */
+CPING_API SweepState sweep_from_list(const SweepRange& range, const std::vector<Address>& alive);
+
+
+// ============================================================================
+// Incremental rescan
+// ============================================================================
+
+enum class RescanChange : uint8_t {
+    NewlyAlive = 0,     // Silent in the previous sweep, answered now
+    NewlyDead  = 1      // Answered before, silent now (after retries)
+};
+
+struct RescanDelta {
+    uint32_t     offset{0};
+    RescanChange change{RescanChange::NewlyAlive};
+    uint32_t     rtt_us{0};     // NewlyAlive only
+};
+
+/**
+ * Options for run_rescan().
+ */
+struct RescanOptions {
+    int rate_pps{10000};                // Previous responders
+    int background_pps{1000};           // Rest of the range, after them
+    int timeout_ms{1000};
+    int dead_retries{1};                // Extra probes before a responder counts as dead
+    int window{4096};                   // Probes in flight at most
+    int payload_size{0};
+    int ttl{-1};
+    ProbePriority priority{ProbePriority::Bulk};
+    const PrefixTrie* exclude{nullptr}; // Addresses never probed (keep their status)
+};
+
+struct RescanResult {
+    SweepState state;                   // Current inventory, input for the next rescan
+    std::vector<RescanDelta> deltas;    // In the order they were found
+    uint64_t probes{0};                 // Probes accepted by the engine, retries included
+    bool complete{false};               // Every address was probed to a verdict
+};
+
+/**
+ * Re-probe the range of `previous` and report only what changed.
+ *
+ * Previous responders go first at `rate_pps`, so a host that went away
+ * shows up within seconds; a silent one is retried `dead_retries` times
+ * before it is reported dead. The rest of the range follows in
+ * permutation order at `background_pps` to find newcomers. Each delta is
+ * handed to `on_delta` (on the calling thread) as soon as it is known.
+ *
+ * Only a timeout counts as silence. If `keep_running` stops the run
+ * early, the engine rejects a probe, or a probe ends in an error rather
+ * than a timeout, hosts without a verdict keep their previous status in
+ * the returned state and the result is not `complete`.
+ */
+CPING_API RescanResult run_rescan(const SweepState& previous, const RescanOptions& opt,
+                                  const std::function<void(const RescanDelta&)>& on_delta = {},
+                                  const std::atomic<bool>* keep_running = nullptr);
+
+} // namespace cping
@@ -0,0 +1,139 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "cping/address.hpp"
+#include "cping/histogram.hpp"
+#include "cping/ping.hpp"
+#include "cping/visibility.hpp"
+
+namespace cping {
+
+/**
+ * Dense target identifier: index into a TargetTable.
+ * Carried through the engine as the ProbeRequest tag.
+ */
+using TargetId = uint32_t;
+
+inline constexpr TargetId kInvalidTarget = 0xFFFFFFFFu;
+
+/**
+ * Struct-of-arrays state for very large target sets.
+ *
+ * Every per-target field lives in its own contiguous column, so the
+ * scheduler scanning due times and the completion path updating RTT
+ * estimators each stream through a few dense arrays instead of chasing
+ * map nodes keyed by strings. Per target:
+ *
+ *   address        16 B   IPv6, or IPv4-mapped (::ffff:a.b.c.d)
+ *   next due        8 B   steady-clock microseconds
+ *   srtt / rttvar   8 B   RFC 6298 estimators, microseconds
+ *   sent / lost     8 B   probe counters
+ *   histogram idx   4 B   slot in the histogram pool, or kNoHistogram
+ *   failure streak  2 B   consecutive lost probes
+ *
+ * = 46 bytes, so one million targets take ~46 MB. Full histograms are
+ * pooled and attached only to the targets that need them.
+ *
+ * Threading: the scheduling columns (next due, sent) and the result
+ * columns (srtt, rttvar, lost, streak, histograms) are disjoint, so one
+ * scheduler thread and one completion thread may update the table
+ * concurrently. Adding targets must not race with either.
+ */
+class CPING_API TargetTable {
+public:
+    static constexpr uint32_t kNoHistogram = 0xFFFFFFFFu;
+    static constexpr size_t   kBytesPerTarget =
+        16 + sizeof(int64_t) + 2 * sizeof(uint32_t) + 2 * sizeof(uint32_t)
+        + sizeof(uint32_t) + sizeof(uint16_t);
+
+    /** Parse and append a target; kInvalidTarget if `ip` is not an address. */
+    TargetId add(std::string_view ip);
+
+    /** Append a pre-parsed target; kInvalidTarget if `addr` is empty. */
+    TargetId add(const Address& addr);
+
+    void   reserve(size_t n);
+    size_t size() const { return next_due_.size(); }
+
+    // ---------------------------------------------------------------------
+    // Addressing
+    // ---------------------------------------------------------------------
+    bool        is_v4(TargetId id) const;
+    std::string address(TargetId id) const;
+
+    /** Target as a pre-parsed Address (no formatting, no allocation). */
+    Address addr(TargetId id) const;
+    const std::array<uint8_t, 16>& raw_address(TargetId id) const { return addr_[id]; }
+
+    // ---------------------------------------------------------------------
+    // Scheduling
+    // ---------------------------------------------------------------------
+    int64_t next_due(TargetId id) const { return next_due_[id]; }
+
+    /**
+     * Collect up to `max` targets due at `now_us`, walking the table as a
+     * ring from where the previous call stopped. Each collected target is
+     * counted as sent and rescheduled one interval after its *intended*
+     * send time, so a late tick does not stretch the probe rate. A target
+     * more than one interval behind is re-anchored to now, and the slots
+     * between its intended send time and now are never probed.
+     *
+     * New due times never go below the last one handed out, which keeps
+     * them non-decreasing along the ring: the walk therefore stops at the
+     * first target that is not due yet, and a tick costs O(due).
+     *
+     * If `intended` is given, the intended send time of every collected
+     * target is appended to it, parallel to `out`; if `skipped` is given,
+     * so is the number of slots dropped by a re-anchor (0 when on time),
+     * which callers back-fill for coordinated omission.
+     */
+    size_t collect_due(int64_t now_us, int64_t interval_us,
+                       std::vector<TargetId>& out, size_t max,
+                       std::vector<int64_t>* intended = nullptr,
+                       std::vector<uint32_t>* skipped = nullptr);
+
+    /** Due time of the next target in ring order (INT64_MAX if empty). */
+    int64_t earliest_due() const;
+
+    // ---------------------------------------------------------------------
+    // Results
+    // ---------------------------------------------------------------------
+    /** Fold one probe outcome into the target's estimators and counters. */
+    void record(TargetId id, const PingProbeResult& probe);
+
+    uint32_t srtt_us(TargetId id)        const { return srtt_us_[id]; }
+    uint32_t rttvar_us(TargetId id)      const { return rttvar_us_[id]; }
+    uint32_t sent(TargetId id)           const { return sent_[id]; }
+    uint32_t lost(TargetId id)           const { return lost_[id]; }
+    uint16_t failure_streak(TargetId id) const { return streak_[id]; }
+
+    // ---------------------------------------------------------------------
+    // Histograms (optional, pooled)
+    // ---------------------------------------------------------------------
+    /** Give the target a full RTT histogram; returns the pool index. */
+    uint32_t attach_histogram(TargetId id);
+    const LatencyHistogram* histogram(TargetId id) const;
+
+    /** Approximate heap footprint of all columns and the histogram pool. */
+    size_t memory_bytes() const;
+
+private:
+    std::vector<std::array<uint8_t, 16>> addr_;
+    std::vector<int64_t>  next_due_;
+    std::vector<uint32_t> srtt_us_;
+    std::vector<uint32_t> rttvar_us_;
+    std::vector<uint32_t> sent_;
+    std::vector<uint32_t> lost_;
+    std::vector<uint32_t> hist_;
+    std::vector<uint16_t> streak_;
+
+    std::vector<LatencyHistogram> hist_pool_;
+    size_t  scan_pos_{0};
+    int64_t tail_due_{0};      // Last due time handed out (ring tail)
+};
+
+} // namespace cping
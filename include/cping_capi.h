@@ -26,6 +26,12 @@ struct CPingOptionsC {
     const char* if_name;        /* Optional interface name */
 };
 
+/**
+ * Opaque cancellation handle. One handle may cancel any number of calls;
+ * once cancelled it stays cancelled.
+ */
+typedef struct cping_cancel cping_cancel_t;
+
 /* Platform-specific export macro */
 #ifdef _WIN32
   #ifdef CPING_BUILDING_DLL
@@ -49,6 +55,35 @@ CPING_API int cping_ping_host_ex(const char* ip,
                                  const struct CPingOptionsC* opt,
                                  struct CPingResultC* out);
 
+/**
+ * Same as cping_ping_host_ex(), but returns early (reachable = 0) once
+ * `cancel` is signalled. `cancel` may be NULL.
+ */
+CPING_API int cping_ping_host_cancellable(const char* ip,
+                                          const struct CPingOptionsC* opt,
+                                          cping_cancel_t* cancel,
+                                          struct CPingResultC* out);
+
+
+// ---------------------------------------------------------------------------
+// CANCELLATION
+// ---------------------------------------------------------------------------
+/**
+ * Creates a cancellation handle (NULL on allocation failure).
+ */
+CPING_API cping_cancel_t* cping_cancel_create();
+
+/**
+ * Cancels every call using this handle: probes in flight complete at once
+ * and free their engine slots. Thread-safe; not async-signal-safe.
+ */
+CPING_API void cping_cancel_request(cping_cancel_t* cancel);
+
+/**
+ * Releases the handle. No call may still be using it.
+ */
+CPING_API void cping_cancel_destroy(cping_cancel_t* cancel);
+
 
 // ---------------------------------------------------------------------------
 // ENGINE API (raw socket + WinPcap capture)
@@ -73,11 +108,27 @@ CPING_API int cping_ping_once_engine(const char* ip,
                                      int ttl,
                                      struct CPingResultC* out);
 
+/**
+ * Engine probe that completes immediately once `cancel` is signalled.
+ */
+CPING_API int cping_ping_once_engine_cancellable(const char* ip,
+                                                 int timeout_ms,
+                                                 int payload_size,
+                                                 int ttl,
+                                                 cping_cancel_t* cancel,
+                                                 struct CPingResultC* out);
+
 /**
  * Determines whether init_engine() successfully started.
  */
 CPING_API int cping_engine_available();
 
+/**
+ * Caps the number of engine probes in flight (0 = unlimited).
+ * Callers beyond the cap block until a send slot frees up.
+ */
+CPING_API void cping_engine_set_max_inflight(int max_probes);
+
 
 #ifdef __cplusplus
 }
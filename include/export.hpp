@@ -1,7 +1,10 @@
 #pragma once
+#include <span>
 #include <string>
 #include <vector>
+#include "cping/arena.hpp"
 #include "cping/ping.hpp"
+#include "cping/groups.hpp"
 
 /**
  * Supported export formats.
@@ -13,13 +16,13 @@ enum class ExportFormat {
 
 /**
  * Export summary from a standard ping run (non-continuous).
- * Statistics are computed from the full vector of probes.
+ * Statistics are computed from the full probe log.
  */
 bool export_summary(const std::string& path,
                     ExportFormat fmt,
                     const std::string& ip,
                     int sent,
-                    const std::vector<cping::PingProbeResult>& probes,
+                    const cping::ProbeLog& probes,
                     bool append = false);
 
 /**
@@ -31,7 +34,7 @@ bool export_summary_continuous(const std::string& path,
                                const std::string& ip,
                                int sent, int received,
                                long min_rtt, long max_rtt, long sum_rtt,
-                               const std::vector<long>& rtts,
+                               std::span<const long> rtts,
                                bool append = false);
 
 /**
@@ -41,3 +44,12 @@ bool export_probes_csv(const std::string& path,
                        const std::string& ip,
                        const std::vector<cping::PingProbeResult>& probes,
                        bool append = false);
+
+/**
+ * Export group rollups from multi-target monitor mode.
+ * One CSV row / JSON object per group; RTT values in microseconds.
+ */
+bool export_groups(const std::string& path,
+                   ExportFormat fmt,
+                   const std::vector<cping::GroupSummary>& groups,
+                   bool append = false);
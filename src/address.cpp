@@ -0,0 +1,160 @@
+/**
+ * Pre-parsed address type and bulk target-list parsing.
+ */
+
+#include "cping/address.hpp"
+
+#include <cstring>
+
+#if defined(_WIN32)
+  #include <winsock2.h>
+  #include <ws2tcpip.h>
+#else
+  #include <arpa/inet.h>
+  #include <netinet/in.h>
+#endif
+
+namespace cping {
+
+// IPv4-mapped IPv6 prefix ::ffff:0:0/96
+static constexpr uint8_t kV4Mapped[12] = { 0,0,0,0, 0,0,0,0, 0,0,0xff,0xff };
+
+
+// ============================================================================
+// Parsing
+// ============================================================================
+/**
+ * Strict dotted quad: four decimal octets 0..255, no leading zeros,
+ * nothing else. Matches what inet_pton(AF_INET) accepts.
+ */
+static bool parse_v4(std::string_view s, uint8_t out[4]) {
+    size_t pos = 0;
+
+    for (int part = 0; part < 4; ++part) {
+        if (part > 0) {
+            if (pos >= s.size() || s[pos] != '.') return false;
+            ++pos;
+        }
+
+        const size_t start = pos;
+        unsigned value = 0;
+        while (pos < s.size() && s[pos] >= '0' && s[pos] <= '9' && pos - start < 3) {
+            value = value * 10 + static_cast<unsigned>(s[pos] - '0');
+            ++pos;
+        }
+
+        const size_t digits = pos - start;
+        if (digits == 0 || value > 255) return false;
+        if (digits > 1 && s[start] == '0') return false;
+        out[part] = static_cast<uint8_t>(value);
+    }
+
+    return pos == s.size();
+}
+
+std::optional<Address> Address::parse(std::string_view text) noexcept {
+    Address a;
+
+    uint8_t v4[4];
+    if (parse_v4(text, v4)) {
+        std::memcpy(a.bytes.data(), kV4Mapped, sizeof(kV4Mapped));
+        std::memcpy(a.bytes.data() + 12, v4, 4);
+        a.family = 4;
+        return a;
+    }
+
+    // IPv6: inet_pton needs a terminated string
+    char buf[INET6_ADDRSTRLEN];
+    if (text.empty() || text.size() >= sizeof(buf) ||
+        text.find(':') == std::string_view::npos)
+        return std::nullopt;
+
+    std::memcpy(buf, text.data(), text.size());
+    buf[text.size()] = '\0';
+
+    in6_addr v6{};
+    if (inet_pton(AF_INET6, buf, &v6) != 1)
+        return std::nullopt;
+
+    std::memcpy(a.bytes.data(), &v6, 16);
+    a.family = 6;
+    return a;
+}
+
+Address Address::v4(uint32_t host_order) noexcept {
+    Address a;
+    std::memcpy(a.bytes.data(), kV4Mapped, sizeof(kV4Mapped));
+    a.bytes[12] = static_cast<uint8_t>(host_order >> 24);
+    a.bytes[13] = static_cast<uint8_t>(host_order >> 16);
+    a.bytes[14] = static_cast<uint8_t>(host_order >> 8);
+    a.bytes[15] = static_cast<uint8_t>(host_order);
+    a.family = 4;
+    return a;
+}
+
+
+// ============================================================================
+// Conversion
+// ============================================================================
+uint32_t Address::v4_net() const noexcept {
+    if (!is_v4()) return 0;
+    uint32_t net;
+    std::memcpy(&net, bytes.data() + 12, 4);
+    return net;
+}
+
+std::string Address::to_string() const {
+    char buf[INET6_ADDRSTRLEN]{};
+
+    if (is_v4()) {
+        in_addr v4{};
+        std::memcpy(&v4, bytes.data() + 12, 4);
+        inet_ntop(AF_INET, &v4, buf, sizeof(buf));
+    } else if (is_v6()) {
+        in6_addr v6{};
+        std::memcpy(&v6, bytes.data(), 16);
+        inet_ntop(AF_INET6, &v6, buf, sizeof(buf));
+    }
+    return buf;
+}
+
+
+// ============================================================================
+// Bulk parsing
+// ============================================================================
+size_t parse_address_list(std::string_view text, std::vector<Address>& out,
+                          size_t* rejected)
+{
+    auto is_space = [](char c) { return c == ' ' || c == '\t' || c == '\r'; };
+
+    size_t added = 0, bad = 0;
+
+    while (!text.empty()) {
+        size_t eol = text.find('\n');
+        std::string_view line = text.substr(0, eol);
+        text.remove_prefix(eol == std::string_view::npos ? text.size() : eol + 1);
+
+        size_t hash = line.find('#');
+        if (hash != std::string_view::npos)
+            line = line.substr(0, hash);
+
+        size_t b = 0;
+        while (b < line.size() && is_space(line[b])) ++b;
+        size_t e = b;
+        while (e < line.size() && !is_space(line[e])) ++e;
+        if (b == e)
+            continue;
+
+        if (auto a = Address::parse(line.substr(b, e - b))) {
+            out.push_back(*a);
+            ++added;
+        } else {
+            ++bad;
+        }
+    }
+
+    if (rejected) *rejected = bad;
+    return added;
+}
+
+} // namespace cping
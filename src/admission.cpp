@@ -0,0 +1,183 @@
+/**
+ * In-flight admission control for the ICMP engine.
+ *
+ * The controller only counts slots; it never touches sockets. Engines call
+ * acquire*() before putting a probe on the wire and release() once the
+ * probe completed (reply, timeout or send failure).
+ */
+
+#include "cping/admission.hpp"
+
+#include <utility>
+
+namespace cping {
+
+AdmissionControl::AdmissionControl(int max_inflight)
+    : limit_(max_inflight > 0 ? max_inflight : 0) {}
+
+
+// ============================================================================
+// Internal helpers (mtx_ held)
+// ============================================================================
+bool AdmissionControl::has_slot_locked() const {
+    return limit_ == 0 || inflight_ < limit_;
+}
+
+/**
+ * True if a waiter of the same or a higher class is already queued.
+ * Same-class waiters keep FIFO order; lower classes never block us.
+ */
+bool AdmissionControl::queue_ahead_locked(ProbePriority prio) const {
+    for (int c = 0; c <= static_cast<int>(prio); ++c) {
+        if (!queues_[c].empty())
+            return true;
+    }
+    return false;
+}
+
+/**
+ * Hand free slots to queued waiters, highest class first.
+ * Blocked submitters are woken; async callbacks are collected so the
+ * caller can run them after dropping the lock.
+ */
+void AdmissionControl::grant_locked(std::vector<AdmitFn>& ready) {
+    bool woke = false;
+
+    for (int c = 0; c < kClasses && has_slot_locked(); ++c) {
+        auto& q = queues_[c];
+        while (!q.empty() && has_slot_locked()) {
+            Entry e = std::move(q.front());
+            q.pop_front();
+            ++inflight_;
+
+            if (e.blocked) {
+                e.blocked->granted = true;
+                woke = true;
+            } else {
+                ready.push_back(std::move(e.on_admit));
+            }
+        }
+    }
+
+    if (woke)
+        cv_.notify_all();
+}
+
+
+// ============================================================================
+// Public API
+// ============================================================================
+void AdmissionControl::set_limit(int max_inflight) {
+    std::vector<AdmitFn> ready;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        limit_ = max_inflight > 0 ? max_inflight : 0;
+        if (!aborted_)
+            grant_locked(ready);
+    }
+    for (auto& fn : ready) fn(true);
+}
+
+int AdmissionControl::limit() const {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return limit_;
+}
+
+bool AdmissionControl::try_acquire(ProbePriority prio) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (aborted_ || !has_slot_locked() || queue_ahead_locked(prio))
+        return false;
+    ++inflight_;
+    return true;
+}
+
+bool AdmissionControl::acquire(ProbePriority prio, std::stop_token stop) {
+    std::unique_lock<std::mutex> lk(mtx_);
+    if (aborted_)
+        return false;
+
+    if (has_slot_locked() && !queue_ahead_locked(prio)) {
+        ++inflight_;
+        return true;
+    }
+
+    Ticket t;
+    auto& q = queues_[static_cast<int>(prio)];
+    q.push_back(Entry{ &t, {} });
+    cv_.wait(lk, stop, [&] { return t.granted || t.aborted; });
+
+    if (!t.granted && !t.aborted) {
+        // Cancelled: leave the queue so the ticket is never granted
+        for (auto it = q.begin(); it != q.end(); ++it) {
+            if (it->blocked == &t) { q.erase(it); break; }
+        }
+    }
+    return t.granted;
+}
+
+void AdmissionControl::acquire_async(ProbePriority prio, AdmitFn on_admit) {
+    bool admitted = false;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        if (!aborted_) {
+            if (!has_slot_locked() || queue_ahead_locked(prio)) {
+                queues_[static_cast<int>(prio)].push_back(
+                    Entry{ nullptr, std::move(on_admit) });
+                return;
+            }
+            ++inflight_;
+            admitted = true;
+        }
+    }
+
+    // Admitted immediately (or rejected because aborted)
+    on_admit(admitted);
+}
+
+void AdmissionControl::release() {
+    std::vector<AdmitFn> ready;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        if (inflight_ > 0)
+            --inflight_;
+        if (!aborted_)
+            grant_locked(ready);
+    }
+    for (auto& fn : ready) fn(true);
+}
+
+void AdmissionControl::abort_all() {
+    std::vector<AdmitFn> rejected;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        aborted_ = true;
+
+        for (auto& q : queues_) {
+            for (auto& e : q) {
+                if (e.blocked) e.blocked->aborted = true;
+                else           rejected.push_back(std::move(e.on_admit));
+            }
+            q.clear();
+        }
+        cv_.notify_all();
+    }
+    for (auto& fn : rejected) fn(false);
+}
+
+void AdmissionControl::reset() {
+    std::lock_guard<std::mutex> lk(mtx_);
+    aborted_  = false;
+    inflight_ = 0;
+}
+
+int AdmissionControl::in_flight() const {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return inflight_;
+}
+
+size_t AdmissionControl::queued(ProbePriority prio) const {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return queues_[static_cast<int>(prio)].size();
+}
+
+} // namespace cping
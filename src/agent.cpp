@@ -0,0 +1,613 @@
+/**
+ * Distributed probe agents and their coordinator (TCP).
+ *
+ * Frame:    u32 length (type + payload) | u8 type | payload
+ * Hello:    shared secret bytes (first frame of every connection)
+ * Job:      u32 job, u32 rounds, u32 interval_ms, u32 timeout_ms,
+ *           u32 payload_size, i32 ttl, u32 n, n x (u8 family, 16 B address)
+ * Results:  u32 job, u32 n, n x (u32 target index, i32 rtt_us; -1 = lost)
+ * Done:     u32 job
+ *
+ * All integers little-endian.
+ */
+
+#include "cping/agent.hpp"
+
+#if defined(_WIN32)
+
+namespace cping {
+
+// Agents are POSIX-only for now; Windows builds link but cannot serve
+ProbeAgent::ProbeAgent(AgentOptions opt) : opt_(std::move(opt)) {}
+ProbeAgent::~ProbeAgent() = default;
+bool ProbeAgent::listen() { return false; }
+void ProbeAgent::serve(const std::atomic<bool>*) {}
+
+AgentCoordinator::~AgentCoordinator() = default;
+bool AgentCoordinator::connect(const std::string&, uint16_t, const std::string&) { return false; }
+CoordinatorResult AgentCoordinator::run(const AgentJob&, int) { return {}; }
+
+} // namespace cping
+
+#else
+
+#include "cping/engine.hpp"
+#include "cping/monitor.hpp"
+#include "cping/target_table.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace cping {
+
+namespace {
+
+enum FrameType : uint8_t {
+    kJob     = 1,
+    kResults = 2,
+    kDone    = 3,
+    kHello   = 4
+};
+
+constexpr uint32_t kMaxFrame  = 64u << 20;     // Sanity bound on a frame
+constexpr int      kPollMs    = 100;            // keep_running check period
+constexpr int      kSlackMs   = 2000;           // Extra coordinator wait per job
+constexpr int      kMaxTimeoutMs = 60000;       // Longest per-probe timeout a job may ask
+constexpr int      kDrainGraceMs = 5000;        // Agent wait for stragglers past the timeout
+constexpr int      kHelloTimeoutMs = 5000;      // Time a peer gets to authenticate
+constexpr uint32_t kMaxSecret = 4096;
+constexpr int      kMaxPayload = 65507;         // Largest ICMP payload over IPv4
+
+// ============================================================================
+// Encoding
+// ============================================================================
+void put_u32(std::vector<uint8_t>& b, uint32_t v) {
+    b.push_back(uint8_t(v));
+    b.push_back(uint8_t(v >> 8));
+    b.push_back(uint8_t(v >> 16));
+    b.push_back(uint8_t(v >> 24));
+}
+
+uint32_t get_u32(const uint8_t* p) {
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+/** Start a frame; finish_frame() patches the length in. */
+std::vector<uint8_t> begin_frame(FrameType type) {
+    std::vector<uint8_t> b(4, 0);
+    b.push_back(type);
+    return b;
+}
+
+void finish_frame(std::vector<uint8_t>& b) {
+    const uint32_t len = static_cast<uint32_t>(b.size() - 4);
+    b[0] = uint8_t(len);
+    b[1] = uint8_t(len >> 8);
+    b[2] = uint8_t(len >> 16);
+    b[3] = uint8_t(len >> 24);
+}
+
+// ============================================================================
+// Socket I/O
+// ============================================================================
+bool send_all(int fd, const std::vector<uint8_t>& b) {
+    size_t off = 0;
+    while (off < b.size()) {
+        ssize_t n = ::send(fd, b.data() + off, b.size() - off, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        off += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool running(const std::atomic<bool>* keep_running) {
+    return !keep_running || keep_running->load();
+}
+
+/**
+ * Blocking read of exactly `len` bytes, giving up when stopped or, with
+ * `deadline` set, once the deadline passes.
+ */
+bool recv_exact(int fd, void* data, size_t len, const std::atomic<bool>* keep_running,
+                const std::chrono::steady_clock::time_point* deadline = nullptr)
+{
+    auto* p = static_cast<uint8_t*>(data);
+    while (len > 0) {
+        if (!running(keep_running))
+            return false;
+
+        int wait_ms = kPollMs;
+        if (deadline) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                *deadline - std::chrono::steady_clock::now()).count();
+            if (left <= 0)
+                return false;
+            wait_ms = static_cast<int>(std::min<long long>(left, kPollMs));
+        }
+
+        pollfd pfd{ fd, POLLIN, 0 };
+        int pr = ::poll(&pfd, 1, wait_ms);
+        if (pr < 0 && errno != EINTR) return false;
+        if (pr <= 0) continue;
+
+        ssize_t n = ::recv(fd, p, len, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p   += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+/** Read one frame into `payload`; false on a broken or oversized frame. */
+bool recv_frame(int fd, uint8_t& type, std::vector<uint8_t>& payload, uint32_t max_len,
+                const std::atomic<bool>* keep_running,
+                const std::chrono::steady_clock::time_point* deadline = nullptr)
+{
+    uint8_t hdr[5];
+    if (!recv_exact(fd, hdr, sizeof(hdr), keep_running, deadline))
+        return false;
+
+    const uint32_t len = get_u32(hdr);
+    if (len == 0 || len > max_len)
+        return false;
+
+    type = hdr[4];
+    payload.resize(len - 1);
+    return payload.empty() ||
+           recv_exact(fd, payload.data(), payload.size(), keep_running, deadline);
+}
+
+// ============================================================================
+// Agent side
+// ============================================================================
+bool is_loopback(const std::string& ip) {
+    in_addr a{};
+    return inet_pton(AF_INET, ip.c_str(), &a) == 1 && (ntohl(a.s_addr) >> 24) == 127;
+}
+
+/** Compare without an early exit, so timing does not leak the prefix. */
+bool secret_matches(const std::vector<uint8_t>& got, const std::string& want) {
+    uint8_t diff = got.size() == want.size() ? 0 : 1;
+    for (size_t i = 0; i < got.size(); ++i)
+        diff |= got[i] ^ uint8_t(want[i % std::max<size_t>(1, want.size())]);
+    return diff == 0;
+}
+
+bool decode_job(const std::vector<uint8_t>& b, AgentJob& job) {
+    if (b.size() < 28) return false;
+    const uint8_t* p = b.data();
+
+    job.id           = get_u32(p);
+    job.rounds       = static_cast<int>(get_u32(p + 4));
+    job.interval_ms  = static_cast<int>(get_u32(p + 8));
+    job.timeout_ms   = static_cast<int>(get_u32(p + 12));
+    job.payload_size = static_cast<int>(get_u32(p + 16));
+    job.ttl          = static_cast<int32_t>(get_u32(p + 20));
+    const uint32_t n = get_u32(p + 24);
+
+    if (b.size() != 28 + size_t(n) * 17) return false;
+
+    job.targets.resize(n);
+    p += 28;
+    for (auto& a : job.targets) {
+        a.family = p[0];
+        std::memcpy(a.bytes.data(), p + 1, 16);
+        p += 17;
+    }
+    return true;
+}
+
+struct ResultRec {
+    uint32_t index;
+    int32_t  rtt_us;
+};
+
+bool send_results(int fd, uint32_t job, std::vector<ResultRec>& recs, size_t batch) {
+    for (size_t off = 0; off < recs.size(); off += batch) {
+        const size_t n = std::min(batch, recs.size() - off);
+
+        auto b = begin_frame(kResults);
+        b.reserve(13 + n * 8);
+        put_u32(b, job);
+        put_u32(b, static_cast<uint32_t>(n));
+        for (size_t i = off; i < off + n; ++i) {
+            put_u32(b, recs[i].index);
+            put_u32(b, static_cast<uint32_t>(recs[i].rtt_us));
+        }
+        finish_frame(b);
+
+        if (!send_all(fd, b))
+            return false;
+    }
+    recs.clear();
+    return true;
+}
+
+bool job_allowed(const AgentJob& job, const AgentOptions& opt) {
+    return job.targets.size() <= opt.max_targets &&
+           job.rounds >= 1 &&
+           job.interval_ms >= std::max(1, opt.min_interval_ms) &&
+           job.timeout_ms >= 0 && job.timeout_ms <= kMaxTimeoutMs &&
+           job.payload_size >= 0 && job.payload_size <= kMaxPayload &&
+           job.ttl >= -1 && job.ttl <= 255;
+}
+
+/**
+ * Everything a job's completion hooks touch. Heap-held so that a job
+ * whose probes outlive the drain grace can be handed off instead of
+ * blocking the connection.
+ */
+struct JobRun {
+    TargetTable table;
+    std::vector<uint32_t> index;        // TargetId -> index in the job
+    std::mutex mtx;
+    std::vector<ResultRec> pending;
+    std::unique_ptr<Monitor> mon;
+};
+
+/** Run one job and stream its results; false if the connection broke. */
+bool run_job(int fd, const AgentJob& job, size_t batch,
+             const std::atomic<bool>* keep_running)
+{
+    auto run = std::make_shared<JobRun>();
+
+    // Unusable addresses are skipped
+    run->table.reserve(job.targets.size());
+    for (uint32_t i = 0; i < job.targets.size(); ++i) {
+        if (run->table.add(job.targets[i]) != kInvalidTarget)
+            run->index.push_back(i);
+    }
+
+    MonitorOptions mo;
+    mo.interval_ms  = std::max(1, job.interval_ms);
+    mo.timeout_ms   = job.timeout_ms;
+    mo.payload_size = job.payload_size;
+    mo.ttl          = job.ttl;
+
+    run->mon = std::make_unique<Monitor>(run->table, mo);
+    Monitor& mon = *run->mon;
+    JobRun* r = run.get();
+    mon.add_hook([r](TargetId id, const PingProbeResult& probe) {
+        long us = probe.rtt_us >= 0 ? probe.rtt_us : probe.rtt_ms * 1000L;
+        std::lock_guard<std::mutex> lk(r->mtx);
+        r->pending.push_back({ r->index[id], probe.success ? static_cast<int32_t>(std::max(0L, us)) : -1 });
+    });
+
+    std::vector<ResultRec> out;
+    auto flush = [&] {
+        {
+            std::lock_guard<std::mutex> lk(r->mtx);
+            out.swap(r->pending);
+        }
+        return send_results(fd, job.id, out, batch);
+    };
+    const TargetTable& table = run->table;
+
+    // Tick by hand rather than run_for(): stop after exactly `rounds`
+    // probes per target, flushing once per interval
+    const uint64_t goal = uint64_t(std::max(1, job.rounds)) * table.size();
+    const int64_t  interval_us = int64_t(mo.interval_ms) * 1000;
+    uint64_t submitted = 0;
+    int64_t  next_flush = Monitor::now_us() + interval_us;
+
+    bool ok = true;
+    while (ok && running(keep_running) && submitted < goal) {
+        submitted += mon.tick();
+
+        int64_t now = Monitor::now_us();
+        if (now >= next_flush) {
+            ok = flush();
+            next_flush = now + interval_us;
+        }
+
+        int64_t wake = std::min({ table.earliest_due(), next_flush, now + kPollMs * 1000 });
+        if (submitted < goal && wake > now)
+            std::this_thread::sleep_for(std::chrono::microseconds(wake - now));
+    }
+
+    // The engine times every probe out, so this normally settles within
+    // the timeout. If it does not, keep the hooks' state alive on a
+    // drain thread and report the job unfinished by dropping the link.
+    if (!mon.wait_idle(std::chrono::milliseconds(mo.timeout_ms + kDrainGraceMs))) {
+        std::thread([run] {
+            while (!run->mon->wait_idle(std::chrono::milliseconds(kDrainGraceMs))) {}
+        }).detach();
+        return false;
+    }
+
+    if (!ok || !flush())
+        return false;
+
+    auto done = begin_frame(kDone);
+    put_u32(done, job.id);
+    finish_frame(done);
+    return send_all(fd, done);
+}
+
+void handle_coordinator(int fd, const AgentOptions& opt, const std::atomic<bool>* keep_running) {
+    std::vector<uint8_t> payload;
+    uint8_t type = 0;
+
+    // Nothing is decoded before the peer proved it holds the secret, and a
+    // silent peer must not hold the (single) coordinator slot for long
+    const auto hello_deadline = std::chrono::steady_clock::now() +
+                                std::chrono::milliseconds(kHelloTimeoutMs);
+    if (!recv_frame(fd, type, payload, kMaxSecret + 1, keep_running, &hello_deadline) ||
+        type != kHello || !secret_matches(payload, opt.secret))
+        return;
+
+    const uint32_t max_job = static_cast<uint32_t>(
+        std::min<uint64_t>(kMaxFrame, 29 + uint64_t(opt.max_targets) * 17));
+
+    for (;;) {
+        if (!recv_frame(fd, type, payload, max_job, keep_running))
+            return;
+
+        if (type != kJob)
+            continue;                       // Unknown frame: ignore
+
+        AgentJob job;
+        if (!decode_job(payload, job) || !job_allowed(job, opt) ||
+            !run_job(fd, job, opt.batch_size, keep_running))
+            return;
+    }
+}
+
+} // namespace
+
+
+ProbeAgent::ProbeAgent(AgentOptions opt) : opt_(std::move(opt)) {
+    if (opt_.batch_size == 0) opt_.batch_size = 1;
+}
+
+ProbeAgent::~ProbeAgent() {
+    if (fd_ >= 0) ::close(fd_);
+}
+
+bool ProbeAgent::listen() {
+    sockaddr_in sa{};
+    sa.sin_family = AF_INET;
+    sa.sin_port   = htons(opt_.port);
+    if (inet_pton(AF_INET, opt_.bind.c_str(), &sa.sin_addr) != 1)
+        return false;
+    if (opt_.secret.empty() && !is_loopback(opt_.bind))
+        return false;
+    if (opt_.secret.size() > kMaxSecret)
+        return false;
+
+    int s = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (s < 0) return false;
+
+    int one = 1;
+    ::setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    socklen_t len = sizeof(sa);
+    if (::bind(s, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) < 0 ||
+        ::listen(s, 4) < 0 ||
+        ::getsockname(s, reinterpret_cast<sockaddr*>(&sa), &len) < 0)
+    {
+        ::close(s);
+        return false;
+    }
+
+    fd_   = s;
+    port_ = ntohs(sa.sin_port);
+    return true;
+}
+
+void ProbeAgent::serve(const std::atomic<bool>* keep_running) {
+    if (fd_ < 0) return;
+
+    while (running(keep_running)) {
+        pollfd pfd{ fd_, POLLIN, 0 };
+        if (::poll(&pfd, 1, kPollMs) <= 0)
+            continue;
+
+        int c = ::accept(fd_, nullptr, nullptr);
+        if (c < 0) continue;
+
+        int one = 1;
+        ::setsockopt(c, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        handle_coordinator(c, opt_, keep_running);
+        ::close(c);
+    }
+}
+
+
+// ============================================================================
+// Coordinator side
+// ============================================================================
+AgentCoordinator::~AgentCoordinator() {
+    for (auto& c : conns_)
+        if (c.fd >= 0) ::close(c.fd);
+}
+
+bool AgentCoordinator::connect(const std::string& host, uint16_t port, const std::string& secret) {
+    sockaddr_in sa{};
+    sa.sin_family = AF_INET;
+    sa.sin_port   = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &sa.sin_addr) != 1)
+        return false;
+
+    int s = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (s < 0) return false;
+
+    if (::connect(s, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) < 0) {
+        ::close(s);
+        return false;
+    }
+
+    int one = 1;
+    ::setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    auto hello = begin_frame(kHello);
+    hello.insert(hello.end(), secret.begin(), secret.end());
+    finish_frame(hello);
+    if (!send_all(s, hello)) {
+        ::close(s);
+        return false;
+    }
+
+    Conn c;
+    c.fd   = s;
+    c.name = host + ":" + std::to_string(port);
+    conns_.push_back(std::move(c));
+    return true;
+}
+
+CoordinatorResult AgentCoordinator::run(const AgentJob& job, int timeout_ms) {
+    CoordinatorResult res;
+    res.vantage.resize(conns_.size());
+    for (size_t i = 0; i < conns_.size(); ++i)
+        res.vantage[i].agent = conns_[i].name;
+
+    // -----------------------------------------------------------------
+    // Fan out
+    // -----------------------------------------------------------------
+    auto b = begin_frame(kJob);
+    b.reserve(33 + job.targets.size() * 17);
+    put_u32(b, job.id);
+    put_u32(b, static_cast<uint32_t>(std::max(1, job.rounds)));
+    put_u32(b, static_cast<uint32_t>(job.interval_ms));
+    put_u32(b, static_cast<uint32_t>(job.timeout_ms));
+    put_u32(b, static_cast<uint32_t>(job.payload_size));
+    put_u32(b, static_cast<uint32_t>(job.ttl));
+    put_u32(b, static_cast<uint32_t>(job.targets.size()));
+    for (const auto& a : job.targets) {
+        b.push_back(a.family);
+        b.insert(b.end(), a.bytes.begin(), a.bytes.end());
+    }
+    finish_frame(b);
+
+    std::vector<bool> live(conns_.size(), false);
+    for (size_t i = 0; i < conns_.size(); ++i)
+        live[i] = send_all(conns_[i].fd, b);
+
+    // -----------------------------------------------------------------
+    // Collect until every live agent is done
+    // -----------------------------------------------------------------
+    if (timeout_ms <= 0)
+        timeout_ms = std::max(1, job.rounds) * job.interval_ms + job.timeout_ms + kSlackMs;
+
+    using Clock = std::chrono::steady_clock;
+    const auto deadline = Clock::now() + std::chrono::milliseconds(timeout_ms);
+
+    auto parse = [&](size_t i) {
+        auto& in = conns_[i].inbuf;
+        auto& v  = res.vantage[i];
+        size_t off = 0;
+
+        while (in.size() - off >= 5) {
+            const uint32_t len = get_u32(in.data() + off);
+            if (len == 0 || len > kMaxFrame) return false;
+            if (in.size() - off < 4 + size_t(len)) break;
+
+            const uint8_t  type = in[off + 4];
+            const uint8_t* p    = in.data() + off + 5;
+            const size_t   plen = len - 1;
+
+            if (type == kResults && plen >= 8 && get_u32(p) == job.id) {
+                const uint32_t n = std::min<uint32_t>(get_u32(p + 4), (plen - 8) / 8);
+                for (uint32_t k = 0; k < n; ++k) {
+                    const int32_t rtt = static_cast<int32_t>(get_u32(p + 8 + k * 8 + 4));
+                    ++v.sent;
+                    if (rtt >= 0) {
+                        ++v.received;
+                        v.latency.record(static_cast<uint64_t>(rtt));
+                    }
+                }
+            } else if (type == kDone && plen >= 4 && get_u32(p) == job.id) {
+                v.complete = true;
+            }
+            off += 4 + len;
+        }
+
+        in.erase(in.begin(), in.begin() + off);
+        return true;
+    };
+
+    uint8_t chunk[64 * 1024];
+    for (;;) {
+        std::vector<pollfd> pfds;
+        std::vector<size_t> who;
+        for (size_t i = 0; i < conns_.size(); ++i) {
+            if (live[i] && !res.vantage[i].complete) {
+                pfds.push_back({ conns_[i].fd, POLLIN, 0 });
+                who.push_back(i);
+            }
+        }
+        if (pfds.empty())
+            break;
+
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        deadline - Clock::now()).count();
+        if (left <= 0)
+            break;
+
+        int pr = ::poll(pfds.data(), pfds.size(), static_cast<int>(std::min<long long>(left, kPollMs)));
+        if (pr < 0 && errno != EINTR) break;
+        if (pr <= 0) continue;
+
+        for (size_t k = 0; k < pfds.size(); ++k) {
+            if (!(pfds[k].revents & (POLLIN | POLLHUP | POLLERR)))
+                continue;
+
+            const size_t i = who[k];
+            ssize_t n = ::recv(conns_[i].fd, chunk, sizeof(chunk), 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                live[i] = false;
+                continue;
+            }
+
+            conns_[i].inbuf.insert(conns_[i].inbuf.end(), chunk, chunk + n);
+            if (!parse(i))
+                live[i] = false;
+        }
+    }
+
+    // -----------------------------------------------------------------
+    // Merge, drop broken connections. An agent that missed the deadline
+    // may still be mid-frame or mid-job: its stream cannot be resynced,
+    // so it goes too.
+    // -----------------------------------------------------------------
+    for (size_t i = 0; i < conns_.size(); ++i)
+        if (!res.vantage[i].complete)
+            live[i] = false;
+
+    for (const auto& v : res.vantage) {
+        res.sent     += v.sent;
+        res.received += v.received;
+        res.global.merge(v.latency);
+    }
+
+    for (size_t i = conns_.size(); i-- > 0;) {
+        if (!live[i]) {
+            ::close(conns_[i].fd);
+            conns_.erase(conns_.begin() + i);
+        }
+    }
+
+    return res;
+}
+
+} // namespace cping
+
+#endif // _WIN32
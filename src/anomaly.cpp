@@ -0,0 +1,114 @@
+/**
+ * Online anomaly detection (EWMA + CUSUM).
+ *
+ * All arithmetic is done in microseconds on floats; precision is ample
+ * for RTTs and keeps the per-target state small.
+ */
+
+#include "cping/anomaly.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace cping {
+
+// Residuals beyond this many std devs do not update the EWMA baseline
+static constexpr double kBaselineZ = 2.0;
+
+const char* to_string(AnomalyKind kind) {
+    switch (kind) {
+    case AnomalyKind::RttLevelShift: return "rtt-shift";
+    case AnomalyKind::JitterSpike:   return "jitter-spike";
+    case AnomalyKind::LossBurst:     return "loss-burst";
+    }
+    return "unknown";
+}
+
+int AnomalyDetector::observe(AnomalyState& st, const PingProbeResult& probe,
+                             AnomalyEvent out[kMaxEvents]) const
+{
+    int n = 0;
+    const uint32_t idx = st.probes++;
+
+    // ---------------------------------------------------------------------
+    // Loss tracking
+    // ---------------------------------------------------------------------
+    const float lost = probe.success ? 0.0f : 1.0f;
+    st.loss_rate += static_cast<float>(cfg_.loss_alpha) * (lost - st.loss_rate);
+
+    if (!probe.success) {
+        if (st.loss_run < 0xFFFF) ++st.loss_run;
+
+        if (!st.in_loss_burst &&
+            (st.loss_run >= cfg_.loss_run || st.loss_rate >= cfg_.loss_threshold))
+        {
+            st.in_loss_burst = 1;
+            out[n++] = { AnomalyKind::LossBurst, st.loss_rate,
+                         static_cast<double>(st.loss_run), idx };
+        }
+        return n;
+    }
+
+    st.loss_run = 0;
+    if (st.in_loss_burst && st.loss_rate < cfg_.loss_threshold / 2)
+        st.in_loss_burst = 0;   // re-arm with hysteresis
+
+    // ---------------------------------------------------------------------
+    // RTT sample
+    // ---------------------------------------------------------------------
+    const double x = probe.rtt_us >= 0 ? double(probe.rtt_us)
+                   : probe.rtt_ms >= 0 ? double(probe.rtt_ms) * 1000.0
+                   : 0.0;
+
+    if (st.samples++ == 0) {
+        st.mean_us = static_cast<float>(x);
+        st.last_us = static_cast<float>(x);
+        return n;
+    }
+
+    const bool armed = st.samples > cfg_.warmup;
+
+    // Jitter spike: compare the jump with the smoothed jitter
+    const double delta  = std::fabs(x - st.last_us);
+    const double jitter = std::max<double>(st.jitter_us, cfg_.min_spread_us);
+    if (armed && delta > cfg_.jitter_factor * jitter)
+        out[n++] = { AnomalyKind::JitterSpike, delta, st.jitter_us, idx };
+
+    st.jitter_us += static_cast<float>(cfg_.jitter_alpha * (delta - st.jitter_us));
+    st.last_us    = static_cast<float>(x);
+
+    // Level shift: two-sided CUSUM over the clamped standardized residual
+    const double sd = std::max({ std::sqrt(double(st.var_us2)),
+                                 0.05 * st.mean_us,
+                                 cfg_.min_spread_us });
+    const double z  = std::clamp((x - st.mean_us) / sd, -cfg_.z_clamp, cfg_.z_clamp);
+
+    if (armed) {
+        st.cusum_up   = static_cast<float>(std::max(0.0, st.cusum_up + z - cfg_.cusum_k));
+        st.cusum_down = static_cast<float>(std::max(0.0, st.cusum_down - z - cfg_.cusum_k));
+
+        if (st.cusum_up > cfg_.cusum_h || st.cusum_down > cfg_.cusum_h) {
+            out[n++] = { AnomalyKind::RttLevelShift, x, st.mean_us, idx };
+
+            // Restart the baseline at the new level
+            st.mean_us    = static_cast<float>(x);
+            st.cusum_up   = 0;
+            st.cusum_down = 0;
+            return n;
+        }
+    }
+
+    // EWMA mean / variance update. Outlying samples are left out of the
+    // baseline, otherwise it would chase a shift before CUSUM can see it.
+    if (armed && std::fabs(z) > kBaselineZ)
+        return n;
+
+    const double a    = cfg_.ewma_alpha;
+    const double diff = x - st.mean_us;
+    st.mean_us += static_cast<float>(a * diff);
+    st.var_us2  = static_cast<float>((1.0 - a) * (st.var_us2 + a * diff * diff));
+
+    return n;
+}
+
+} // namespace cping
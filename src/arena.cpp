@@ -0,0 +1,38 @@
+/**
+ * Run-scoped arena and arena-backed probe logs.
+ */
+
+#include "cping/arena.hpp"
+
+namespace cping {
+
+// Smallest block handed to the monotonic resource
+static constexpr size_t kMinBytes = 1024;
+
+// Per-record budget for error text that does not fit the SSO buffer
+static constexpr size_t kErrorBytes = 64;
+
+RunArena::RunArena(size_t initial_bytes, std::pmr::memory_resource* upstream)
+    : block_(std::make_unique_for_overwrite<std::byte[]>(
+          initial_bytes > kMinBytes ? initial_bytes : kMinBytes)),
+      size_(initial_bytes > kMinBytes ? initial_bytes : kMinBytes),
+      mono_(block_.get(), size_, upstream)
+{}
+
+size_t RunArena::bytes_for(size_t probes) {
+    // Record array, one heap-length error text per record, alignment slack
+    return probes * (sizeof(ProbeRecord) + kErrorBytes) + kMinBytes;
+}
+
+PingResult ping_host(const std::string& ip, const PingOptions& opt,
+                     ProbeLog& log, std::stop_token stop)
+{
+    return ping_host(ip, opt,
+        [&log](const PingProbeResult& probe, int) {
+            log.emplace_back(probe);
+            return true;
+        },
+        stop);
+}
+
+} // namespace cping
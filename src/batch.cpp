@@ -0,0 +1,152 @@
+/**
+ * Deadline-bounded batch probing over the async engine.
+ */
+
+#include "cping/batch.hpp"
+#include "cping/engine.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+
+namespace cping {
+
+const char* to_string(BatchStatus status) {
+    switch (status) {
+    case BatchStatus::Replied: return "replied";
+    case BatchStatus::Lost:    return "lost";
+    case BatchStatus::Pending: return "pending";
+    case BatchStatus::Failed:  return "failed";
+    }
+    return "pending";
+}
+
+namespace {
+
+/**
+ * Shared with completion callbacks; late completions after the deadline
+ * land here harmlessly once `closed` is set.
+ */
+struct BatchState {
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::vector<BatchResult> results;
+    size_t outstanding{0};
+    bool   closed{false};
+    std::stop_source stop;              // Every probe's token; fired at the deadline
+};
+
+// Replies are matched by a 16-bit sequence: stay well inside it
+constexpr int kMaxWindow = 32768;
+
+} // namespace
+
+
+std::vector<BatchResult> ping_batch(const std::vector<std::string>& targets,
+                                    const BatchOptions& opt)
+{
+    using Clock = std::chrono::steady_clock;
+
+    auto st = std::make_shared<BatchState>();
+    st->results.resize(targets.size());
+    for (size_t i = 0; i < targets.size(); ++i)
+        st->results[i].ip = targets[i];
+
+    if (!engine_available()) {
+        for (auto& r : st->results) {
+            r.status = BatchStatus::Failed;
+            r.probe.error_msg = "Engine not running";
+        }
+        return st->results;
+    }
+
+    const auto start    = Clock::now();
+    const auto deadline = start + std::chrono::milliseconds(std::max(0, opt.deadline_ms));
+
+    const double frac = std::clamp(opt.send_fraction, 0.0, 1.0);
+    const auto send_window = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::milliseconds(std::max(0, opt.deadline_ms)) * frac);
+    const auto step = targets.empty() ? Clock::duration::zero()
+                                      : send_window / static_cast<long>(targets.size());
+
+    const size_t window = static_cast<size_t>(std::clamp(opt.window, 1, kMaxWindow));
+
+    ProbeRequest req;
+    req.payload_size = opt.payload_size;
+    req.ttl          = opt.ttl;
+    req.priority     = opt.priority;
+    req.stop         = st->stop.get_token();
+
+    // ---------------------------------------------------------------------
+    // Paced sends: every probe is submitted up front with its departure
+    // time, and the engine (kernel txtime or its pacer) keeps the spacing
+    // ---------------------------------------------------------------------
+    for (size_t i = 0; i < targets.size(); ++i) {
+        const auto when = start + step * static_cast<long>(i);
+        if (Clock::now() >= deadline)
+            break;                          // rest stays Pending
+
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - when).count();
+        const bool cut = left < opt.probe_timeout_ms;
+
+        req.ip         = targets[i];
+        req.timeout_ms = cut ? static_cast<int>(left) : opt.probe_timeout_ms;
+        req.tag        = i;
+        req.send_at    = when;
+
+        {
+            // Window full: wait for a completion (or give up at the deadline)
+            std::unique_lock<std::mutex> lk(st->mtx);
+            if (!st->cv.wait_until(lk, deadline, [&] { return st->outstanding < window; }))
+                break;                      // rest stays Pending
+            ++st->outstanding;
+        }
+
+        bool accepted = submit_probe(req,
+            [st, cut](const PingProbeResult& probe, uint64_t tag) {
+                std::lock_guard<std::mutex> lk(st->mtx);
+                --st->outstanding;
+                if (!st->closed) {
+                    auto& r = st->results[tag];
+                    r.probe = probe;
+                    if (probe.success)
+                        r.status = BatchStatus::Replied;
+                    else if (probe.error_msg == "Timeout")
+                        r.status = cut ? BatchStatus::Pending : BatchStatus::Lost;
+                    else
+                        r.status = BatchStatus::Failed;
+                }
+                st->cv.notify_one();
+            },
+            AdmitMode::Callback);
+
+        if (!accepted) {
+            std::lock_guard<std::mutex> lk(st->mtx);
+            --st->outstanding;
+            st->results[i].status = BatchStatus::Failed;
+            st->results[i].probe.error_msg = "Probe not accepted";
+        }
+    }
+
+    // ---------------------------------------------------------------------
+    // Collect until everything settled or the deadline hits
+    // ---------------------------------------------------------------------
+    std::vector<BatchResult> results;
+    {
+        std::unique_lock<std::mutex> lk(st->mtx);
+        st->cv.wait_until(lk, deadline, [&] { return st->outstanding == 0; });
+        st->closed = true;
+        results = std::move(st->results);
+    }
+
+    // Probes still queued for admission or a departure slot must not go
+    // out after the deadline. Outside the lock: cancelling completes them
+    // on this thread.
+    st->stop.request_stop();
+    return results;
+}
+
+} // namespace cping
@@ -5,6 +5,7 @@
  * - Basic ICMP ping (blocking)
  * - Extended ping options
  * - Optional high-performance engine (pcap + raw socket)
+ * - Cancellation handles wrapping std::stop_source
  *
  * This layer is meant for consumption by C projects or foreign
  * language bindings (e.g., Rust, Go, Python FFI).
@@ -14,10 +15,20 @@
 #include "cping/ping.hpp"
 #include "cping/engine.hpp"
 
+#include <new>
+#include <stop_token>
 #include <string>
 
 using namespace cping;
 
+struct cping_cancel {
+    std::stop_source source;
+};
+
+static std::stop_token token_of(cping_cancel_t* cancel) {
+    return cancel ? cancel->source.get_token() : std::stop_token{};
+}
+
 // ---------------------------------------------------------------------------
 // Conversion helpers
 // ---------------------------------------------------------------------------
@@ -62,6 +73,14 @@ CPING_API int cping_ping_host(const char* ip,
 CPING_API int cping_ping_host_ex(const char* ip,
                                  const struct CPingOptionsC* optC,
                                  struct CPingResultC* out)
+{
+    return cping_ping_host_cancellable(ip, optC, nullptr, out);
+}
+
+CPING_API int cping_ping_host_cancellable(const char* ip,
+                                          const struct CPingOptionsC* optC,
+                                          cping_cancel_t* cancel,
+                                          struct CPingResultC* out)
 {
     if (!ip || !out) return 0;
 
@@ -79,12 +98,28 @@ CPING_API int cping_ping_host_ex(const char* ip,
             opt.if_name = optC->if_name;
     }
 
-    PingResult r = ping_host(std::string(ip), opt);
+    PingResult r = ping_host(std::string(ip), opt, token_of(cancel));
     to_out(r, out);
     return 1;
 }
 
 
+// ---------------------------------------------------------------------------
+// Cancellation handles
+// ---------------------------------------------------------------------------
+CPING_API cping_cancel_t* cping_cancel_create() {
+    return new (std::nothrow) cping_cancel{};
+}
+
+CPING_API void cping_cancel_request(cping_cancel_t* cancel) {
+    if (cancel) cancel->source.request_stop();
+}
+
+CPING_API void cping_cancel_destroy(cping_cancel_t* cancel) {
+    delete cancel;
+}
+
+
 
 // ---------------------------------------------------------------------------
 // Engine API (pcap + raw socket + listener thread)
@@ -103,6 +138,17 @@ CPING_API int cping_ping_once_engine(const char* ip,
                                      int payload_size,
                                      int ttl,
                                      struct CPingResultC* out)
+{
+    return cping_ping_once_engine_cancellable(ip, timeout_ms, payload_size,
+                                              ttl, nullptr, out);
+}
+
+CPING_API int cping_ping_once_engine_cancellable(const char* ip,
+                                                 int timeout_ms,
+                                                 int payload_size,
+                                                 int ttl,
+                                                 cping_cancel_t* cancel,
+                                                 struct CPingResultC* out)
 {
     if (!ip || !out) return 0;
 
@@ -110,7 +156,9 @@ CPING_API int cping_ping_once_engine(const char* ip,
         std::string(ip),
         timeout_ms,
         payload_size,
-        ttl
+        ttl,
+        ProbePriority::Normal,
+        token_of(cancel)
     );
 
     to_out_probe(res, out);
@@ -121,4 +169,8 @@ CPING_API int cping_engine_available() {
     return engine_available() ? 1 : 0;
 }
 
+CPING_API void cping_engine_set_max_inflight(int max_probes) {
+    set_max_inflight(max_probes);
+}
+
 } // extern "C"
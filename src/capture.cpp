@@ -0,0 +1,405 @@
+/**
+ * pcapng capture writer / reader and offline echo replay.
+ *
+ * Layout written: Section Header Block, one Interface Description Block
+ * (LINKTYPE_IPV4, if_tsresol = 9), then one Enhanced Packet Block per
+ * packet with its direction in epb_flags. All little-endian.
+ */
+
+#include "cping/capture.hpp"
+#include "cping/util.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <unordered_map>
+
+namespace cping {
+
+namespace {
+
+constexpr uint32_t kShbType   = 0x0A0D0D0A;
+constexpr uint32_t kIdbType   = 0x00000001;
+constexpr uint32_t kSpbType   = 0x00000003;
+constexpr uint32_t kEpbType   = 0x00000006;
+constexpr uint32_t kByteOrder = 0x1A2B3C4D;
+
+constexpr uint16_t kLinkRaw   = 101;        // LINKTYPE_RAW
+constexpr uint16_t kLinkIpv4  = 228;        // LINKTYPE_IPV4
+
+constexpr uint16_t kOptEnd     = 0;
+constexpr uint16_t kOptTsresol = 9;         // IDB
+constexpr uint16_t kOptFlags   = 2;         // EPB
+
+constexpr size_t kFlushBytes  = 1 << 20;    // Wake the writer early
+constexpr size_t kMaxPending  = 64u << 20;  // Drop beyond this backlog
+constexpr auto   kFlushPeriod = std::chrono::milliseconds(100);
+
+constexpr uint32_t kMaxBlock  = 16u << 20;  // Reader sanity bound
+
+void put_u16(std::vector<uint8_t>& b, uint16_t v) {
+    b.push_back(uint8_t(v));
+    b.push_back(uint8_t(v >> 8));
+}
+
+void put_u32(std::vector<uint8_t>& b, uint32_t v) {
+    put_u16(b, uint16_t(v));
+    put_u16(b, uint16_t(v >> 16));
+}
+
+uint16_t get_u16(const uint8_t* p) {
+    return uint16_t(p[0] | (p[1] << 8));
+}
+
+uint32_t get_u32(const uint8_t* p) {
+    return uint32_t(get_u16(p)) | (uint32_t(get_u16(p + 2)) << 16);
+}
+
+void pad4(std::vector<uint8_t>& b) {
+    while (b.size() % 4) b.push_back(0);
+}
+
+/** Append an Enhanced Packet Block for `len` bytes (two parts, no copy). */
+void put_epb(std::vector<uint8_t>& b, CaptureDirection dir, uint64_t ts_ns,
+             const uint8_t* head, size_t head_len,
+             const uint8_t* body, size_t body_len)
+{
+    const size_t   len   = head_len + body_len;
+    const size_t   data  = (len + 3) & ~size_t(3);
+    const uint32_t total = static_cast<uint32_t>(28 + data + 12 + 4);
+
+    put_u32(b, kEpbType);
+    put_u32(b, total);
+    put_u32(b, 0);                                  // Interface 0
+    put_u32(b, uint32_t(ts_ns >> 32));
+    put_u32(b, uint32_t(ts_ns));
+    put_u32(b, static_cast<uint32_t>(len));         // Captured
+    put_u32(b, static_cast<uint32_t>(len));         // Original
+    b.insert(b.end(), head, head + head_len);
+    b.insert(b.end(), body, body + body_len);
+    pad4(b);
+
+    put_u16(b, kOptFlags);
+    put_u16(b, 4);
+    put_u32(b, static_cast<uint32_t>(dir));
+    put_u16(b, kOptEnd);
+    put_u16(b, 0);
+    put_u32(b, total);
+}
+
+/** Divide / multiply a raw timestamp into nanoseconds per if_tsresol. */
+uint64_t to_ns(uint64_t ts, uint8_t tsresol) {
+    if (tsresol & 0x80) {
+        const int shift = tsresol & 0x7F;
+        return shift >= 64 ? 0 : uint64_t((long double)ts * 1e9L / (long double)(uint64_t(1) << shift));
+    }
+    uint64_t ns = ts;
+    for (int e = tsresol; e < 9; ++e) ns *= 10;
+    for (int e = 9; e < tsresol; ++e) ns /= 10;
+    return ns;
+}
+
+} // namespace
+
+
+// ============================================================================
+// Writer
+// ============================================================================
+PcapngWriter::~PcapngWriter() {
+    close();
+}
+
+bool PcapngWriter::open(const std::string& path) {
+    close();
+
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_)
+        return false;
+
+    std::vector<uint8_t> b;
+
+    // Section Header Block, section length unknown
+    put_u32(b, kShbType);
+    put_u32(b, 28);
+    put_u32(b, kByteOrder);
+    put_u16(b, 1);
+    put_u16(b, 0);
+    put_u32(b, 0xFFFFFFFF);
+    put_u32(b, 0xFFFFFFFF);
+    put_u32(b, 28);
+
+    // Interface Description Block: raw IPv4, nanosecond timestamps
+    put_u32(b, kIdbType);
+    put_u32(b, 32);
+    put_u16(b, kLinkIpv4);
+    put_u16(b, 0);
+    put_u32(b, 0);                                  // No snap length
+    put_u16(b, kOptTsresol);
+    put_u16(b, 1);
+    b.push_back(9);
+    pad4(b);
+    put_u16(b, kOptEnd);
+    put_u16(b, 0);
+    put_u32(b, 32);
+
+    if (std::fwrite(b.data(), 1, b.size(), file_) != b.size()) {
+        std::fclose(file_);
+        file_ = nullptr;
+        return false;
+    }
+
+    stop_ = false;
+    packets_ = 0;
+    dropped_ = 0;
+    pending_.reserve(kFlushBytes);
+    thread_ = std::thread(&PcapngWriter::run, this);
+    return true;
+}
+
+void PcapngWriter::close() {
+    if (!file_)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        stop_ = true;
+    }
+    cv_.notify_one();
+    if (thread_.joinable())
+        thread_.join();
+
+    std::fclose(file_);
+    file_ = nullptr;
+}
+
+void PcapngWriter::run() {
+    std::vector<uint8_t> out;
+    out.reserve(kFlushBytes);
+
+    std::unique_lock<std::mutex> lk(mtx_);
+    for (;;) {
+        cv_.wait_for(lk, kFlushPeriod, [&] { return stop_ || pending_.size() >= kFlushBytes; });
+
+        out.swap(pending_);
+        const bool last = stop_;
+
+        // Disk I/O outside the lock; producers keep appending meanwhile
+        lk.unlock();
+        if (!out.empty()) {
+            std::fwrite(out.data(), 1, out.size(), file_);
+            out.clear();
+        }
+        if (last) {
+            std::fflush(file_);
+            return;
+        }
+        lk.lock();
+    }
+}
+
+void PcapngWriter::write_ipv4(CaptureDirection dir, uint64_t ts_ns,
+                              const uint8_t* packet, size_t len)
+{
+    if (!file_)
+        return;
+
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (pending_.size() + len > kMaxPending) {
+        dropped_++;
+        return;
+    }
+    put_epb(pending_, dir, ts_ns, packet, len, nullptr, 0);
+    packets_++;
+    if (pending_.size() >= kFlushBytes)
+        cv_.notify_one();
+}
+
+void PcapngWriter::write_icmp(CaptureDirection dir, uint64_t ts_ns,
+                              uint32_t src_net, uint32_t dst_net, int ttl,
+                              const uint8_t* icmp, size_t len)
+{
+    if (!file_)
+        return;
+
+    // Minimal IPv4 header (no options) in front of the ICMP message
+    const uint16_t total = static_cast<uint16_t>(20 + len);
+    uint8_t ip[20] = {};
+    ip[0] = 0x45;
+    ip[2] = uint8_t(total >> 8);
+    ip[3] = uint8_t(total);
+    ip[6] = 0x40;                                   // DF
+    ip[8] = static_cast<uint8_t>(ttl > 0 ? ttl : 64);
+    ip[9] = 1;                                      // ICMP
+    std::memcpy(ip + 12, &src_net, 4);
+    std::memcpy(ip + 16, &dst_net, 4);
+    const uint16_t sum = checksum16(ip, sizeof(ip));
+    std::memcpy(ip + 10, &sum, 2);
+
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (pending_.size() + sizeof(ip) + len > kMaxPending) {
+        dropped_++;
+        return;
+    }
+    put_epb(pending_, dir, ts_ns, ip, sizeof(ip), icmp, len);
+    packets_++;
+    if (pending_.size() >= kFlushBytes)
+        cv_.notify_one();
+}
+
+
+// ============================================================================
+// Reader
+// ============================================================================
+bool read_pcapng(std::istream& in, std::vector<CapturedPacket>& out) {
+    out.clear();
+
+    struct Iface { uint16_t link; uint8_t tsresol; };
+    std::vector<Iface> ifaces;
+    std::vector<uint8_t> body;
+    bool section = false;
+
+    for (;;) {
+        uint8_t hdr[8];
+        if (!in.read(reinterpret_cast<char*>(hdr), 8))
+            return section && in.gcount() == 0;
+
+        const uint32_t type  = get_u32(hdr);
+        const uint32_t total = get_u32(hdr + 4);
+        if (total < 12 || total % 4 || total > kMaxBlock)
+            return false;
+
+        body.resize(total - 8);
+        if (!in.read(reinterpret_cast<char*>(body.data()), body.size()))
+            return false;
+
+        const uint8_t* p   = body.data();
+        const size_t   len = body.size() - 4;           // Trailing length
+
+        if (type == kShbType) {
+            if (len < 16 || get_u32(p) != kByteOrder)
+                return false;                           // Big-endian section
+            ifaces.clear();
+            section = true;
+
+        } else if (!section) {
+            return false;
+
+        } else if (type == kIdbType) {
+            if (len < 8) return false;
+            Iface f{ get_u16(p), 6 };
+            for (size_t o = 8; o + 4 <= len;) {
+                const uint16_t code = get_u16(p + o);
+                const uint16_t olen = get_u16(p + o + 2);
+                if (code == kOptEnd || o + 4 + olen > len) break;
+                if (code == kOptTsresol && olen >= 1) f.tsresol = p[o + 4];
+                o += 4 + ((olen + 3u) & ~3u);
+            }
+            ifaces.push_back(f);
+
+        } else if (type == kEpbType) {
+            if (len < 20) return false;
+            const uint32_t iface = get_u32(p);
+            const uint64_t ts    = (uint64_t(get_u32(p + 4)) << 32) | get_u32(p + 8);
+            const uint32_t cap   = get_u32(p + 12);
+            const size_t   data  = (size_t(cap) + 3) & ~size_t(3);
+            if (iface >= ifaces.size() || 20 + data > len)
+                return false;
+
+            const Iface& f = ifaces[iface];
+            if (f.link != kLinkIpv4 && f.link != kLinkRaw)
+                continue;
+
+            CapturedPacket pkt;
+            pkt.ts_ns = to_ns(ts, f.tsresol);
+            pkt.data.assign(p + 20, p + 20 + cap);
+            for (size_t o = 20 + data; o + 4 <= len;) {
+                const uint16_t code = get_u16(p + o);
+                const uint16_t olen = get_u16(p + o + 2);
+                if (code == kOptEnd || o + 4 + olen > len) break;
+                if (code == kOptFlags && olen >= 4)
+                    pkt.dir = static_cast<CaptureDirection>(get_u32(p + o + 4) & 3);
+                o += 4 + ((olen + 3u) & ~3u);
+            }
+            out.push_back(std::move(pkt));
+
+        } else if (type == kSpbType) {
+            continue;                                   // No timestamp: useless here
+        }
+    }
+}
+
+
+// ============================================================================
+// Offline replay
+// ============================================================================
+std::vector<ReplayTarget> replay_capture(const std::vector<CapturedPacket>& packets) {
+    std::vector<ReplayTarget> targets;
+    std::unordered_map<uint32_t, size_t> by_addr;           // peer (host order) -> index
+
+    struct Pending { size_t target; size_t probe; uint64_t ts_ns; };
+    std::unordered_map<uint64_t, Pending> outstanding;      // (peer, id, seq)
+
+    // Blocks are not strictly time-ordered: a reply can be queued before
+    // the send path has recorded its request
+    std::vector<size_t> order(packets.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return packets[a].ts_ns < packets[b].ts_ns;
+    });
+
+    for (size_t i : order) {
+        const auto& pkt = packets[i];
+        const auto& d   = pkt.data;
+        if (d.size() < 20 || (d[0] >> 4) != 4 || d[9] != 1)
+            continue;
+        const size_t ihl = size_t(d[0] & 0x0F) * 4;
+        if (ihl < 20 || d.size() < ihl + 8)
+            continue;
+
+        const uint8_t  icmp_type = d[ihl];
+        const uint32_t id_seq    = (uint32_t(d[ihl + 4]) << 24) | (uint32_t(d[ihl + 5]) << 16) |
+                                   (uint32_t(d[ihl + 6]) << 8)  |  uint32_t(d[ihl + 7]);
+
+        // Requests go out to the peer, replies come back from it
+        const bool request = icmp_type == 8 && pkt.dir != CaptureDirection::Inbound;
+        const bool reply   = icmp_type == 0 && pkt.dir != CaptureDirection::Outbound;
+        if (!request && !reply)
+            continue;
+
+        const uint8_t* a   = d.data() + (request ? 16 : 12);
+        const uint32_t peer = (uint32_t(a[0]) << 24) | (uint32_t(a[1]) << 16) |
+                              (uint32_t(a[2]) << 8)  |  uint32_t(a[3]);
+        const uint64_t key = (uint64_t(peer) << 32) | id_seq;
+
+        if (request) {
+            auto [it, fresh] = by_addr.try_emplace(peer, targets.size());
+            if (fresh)
+                targets.push_back({ Address::v4(peer), {} });
+
+            auto& probes = targets[it->second].probes;
+            PingProbeResult lost;
+            lost.error_msg = "No reply in capture";
+            probes.push_back(std::move(lost));
+
+            outstanding[key] = { it->second, probes.size() - 1, pkt.ts_ns };
+            continue;
+        }
+
+        auto it = outstanding.find(key);
+        if (it == outstanding.end())
+            continue;
+
+        PingProbeResult& probe = targets[it->second.target].probes[it->second.probe];
+        const uint64_t us = pkt.ts_ns >= it->second.ts_ns ? (pkt.ts_ns - it->second.ts_ns) / 1000 : 0;
+        probe.success = true;
+        probe.rtt_us  = static_cast<long>(us);
+        probe.rtt_ms  = static_cast<long>(us / 1000);
+        probe.ttl     = d[8];
+        probe.error_msg.clear();
+        outstanding.erase(it);
+    }
+
+    return targets;
+}
+
+} // namespace cping
@@ -1,4 +1,5 @@
 #include "cli.hpp"
+#include <algorithm>
 #include <iostream>
 #include <string>
 
@@ -13,6 +14,21 @@
  *   - export (CSV/JSON)
  *   - color toggle
  *   - timestamped output
+ *   - multi-target monitoring from a target list
+ *   - outage logging and availability reports
+ *   - flood / throughput mode
+ *   - deadline-bounded batch health checks
+ *   - warmup probes excluded from the statistics
+ *   - sources x targets reachability matrices
+ *   - multi-process monitoring of very large target lists
+ *   - distributed probe agents driven by a central coordinator
+ *   - pcapng capture of probes and replies, with offline replay
+ *   - kernel-scheduled departures for paced sends
+ *   - TSC-based engine timestamps
+ *   - resumable CIDR sweeps with checkpoints
+ *   - incremental rescans reporting only changes
+ *   - prefix exclusion lists and prefix-based groups
+ *   - broadcast / multicast discovery with every responder collected
  *
  * Invalid or unknown flags are reported but do not stop parsing.
  */
@@ -22,13 +38,24 @@ CliOptions parse_args(int argc, char** argv) {
     // Minimal usage help
     if (argc < 2) {
         std::cerr << "Usage:\n"
-                  << "  cping <ip> [options]\n";
+                  << "  cping <ip> [options]\n"
+                  << "  cping --targets <file> [options]\n"
+                  << "  cping --agent <port> [--bind <addr>]\n"
+                  << "  cping --replay <capture.pcapng>\n"
+                  << "  cping --sweep <cidr> [--checkpoint <file>] [--rate <pps>]\n"
+                  << "  cping --rescan <state|list> [--sweep <cidr>] [--checkpoint <file>]\n"
+                  << "  cping --availability <outage-log> [--window <sec>]\n";
         return opt; // opt.ip remains empty → main will print usage
     }
 
-    opt.ip = argv[1];
+    // The target IP is optional when a target list is given
+    int first = 1;
+    if (argv[1][0] != '-') {
+        opt.ip = argv[1];
+        first = 2;
+    }
 
-    for (int i = 2; i < argc; ++i) {
+    for (int i = first; i < argc; ++i) {
         std::string a = argv[i];
 
         // ------------------------------
@@ -70,9 +97,95 @@ CliOptions parse_args(int argc, char** argv) {
             if (opt.ttl < 1) opt.ttl = 1;
             opt.ping.ttl = opt.ttl;
 
+        } else if (a == "--targets" && i + 1 < argc) {
+            opt.targets_path = argv[++i];
+
+        } else if (a == "--outage-log" && i + 1 < argc) {
+            opt.outage_log = argv[++i];
+
+        } else if (a == "--availability" && i + 1 < argc) {
+            opt.availability_log = argv[++i];
+
+        } else if (a == "--window" && i + 1 < argc) {
+            opt.window_s = std::stoi(argv[++i]);
+            if (opt.window_s < 0) opt.window_s = 0;
+
+        } else if (a == "--flood" || a == "-f") {
+            opt.flood = true;
+
+        } else if (a == "--duration" && i + 1 < argc) {
+            opt.duration_s = std::stoi(argv[++i]);
+            if (opt.duration_s < 0) opt.duration_s = 0;
+
+        } else if (a == "--matrix" && i + 1 < argc) {
+            opt.matrix_sources = argv[++i];
+
+        } else if (a == "--matrix-out" && i + 1 < argc) {
+            opt.matrix_out = argv[++i];
+
+        } else if (a == "--workers" && i + 1 < argc) {
+            std::string w = argv[++i];
+            opt.workers = (w == "auto") ? 0 : std::max(1, std::stoi(w));
+
+        } else if (a == "--agent" && i + 1 < argc) {
+            opt.agent_port = std::clamp(std::stoi(argv[++i]), 0, 65535);
+
+        } else if (a == "--bind" && i + 1 < argc) {
+            opt.agent_bind = argv[++i];
+
+        } else if (a == "--agents" && i + 1 < argc) {
+            opt.agents = argv[++i];
+
+        } else if (a == "--pcap" && i + 1 < argc) {
+            opt.pcap_path = argv[++i];
+
+        } else if (a == "--replay" && i + 1 < argc) {
+            opt.replay_path = argv[++i];
+
+        } else if (a == "--sweep" && i + 1 < argc) {
+            opt.sweep_range = argv[++i];
+
+        } else if (a == "--checkpoint" && i + 1 < argc) {
+            opt.checkpoint_path = argv[++i];
+
+        } else if (a == "--rate" && i + 1 < argc) {
+            opt.rate_pps = std::max(0, std::stoi(argv[++i]));
+
+        } else if (a == "--rescan" && i + 1 < argc) {
+            opt.rescan_path = argv[++i];
+
+        } else if (a == "--background-rate" && i + 1 < argc) {
+            opt.background_pps = std::max(0, std::stoi(argv[++i]));
+
+        } else if (a == "--exclude" && i + 1 < argc) {
+            opt.exclude_path = argv[++i];
+
+        } else if (a == "--prefix-groups" && i + 1 < argc) {
+            opt.prefix_groups = argv[++i];
+
+        } else if (a == "--txtime") {
+            opt.txtime = true;
+
+        } else if (a == "--tsc") {
+            opt.tsc = true;
+
+        } else if (a == "--collect") {
+            opt.collect = true;
+
+        } else if (a == "--warmup" && i + 1 < argc) {
+            opt.ping.warmup = std::stoi(argv[++i]);
+            if (opt.ping.warmup < 0) opt.ping.warmup = 0;
+
+        } else if (a == "--deadline" && i + 1 < argc) {
+            opt.deadline_ms = std::stoi(argv[++i]);
+            if (opt.deadline_ms < 0) opt.deadline_ms = 0;
+
         } else if (a == "--timestamp") {
             opt.timestamp = true;
 
+        } else if (a == "--anomaly") {
+            opt.anomaly = true;
+
         // ------------------------------
         // Output color handling
         // ------------------------------
@@ -11,7 +11,28 @@
  * after parsing.
  */
 struct CliOptions {
-    std::string ip;               // Target IP (mandatory)
+    std::string ip;               // Target IP (mandatory unless --targets)
+    std::string targets_path;     // Target list file (multi-target monitor)
+    std::string outage_log;       // Outage transition log written by the monitor
+    std::string availability_log; // Outage log to report availability from
+    int window_s{0};              // Availability window, seconds back from now (0 = all)
+    int duration_s{10};           // Flood sending phase length
+    int deadline_ms{0};           // One-shot batch budget for --targets (0 = monitor)
+    std::string matrix_sources;   // Comma-separated sources for the reachability matrix
+    std::string matrix_out;       // Binary matrix output path
+    int workers{-1};              // Monitor worker processes (-1 = single process, 0 = per NUMA node)
+    int agent_port{-1};           // Serve as a probe agent on this TCP port (-1 = off)
+    std::string agent_bind{"127.0.0.1"}; // Address the agent listens on
+    std::string agents;           // Comma-separated host:port agents to coordinate
+    std::string pcap_path;        // pcapng capture of every engine packet
+    std::string replay_path;      // pcapng capture to rebuild statistics from
+    std::string sweep_range;      // CIDR block to sweep (one probe per address)
+    std::string checkpoint_path;  // Sweep checkpoint, resumed from when present
+    int rate_pps{10000};          // Sweep send rate
+    std::string rescan_path;      // Previous sweep state or responder list to rescan
+    int background_pps{1000};     // Rescan rate for hosts that were silent before
+    std::string exclude_path;     // Prefixes never probed (sweeps and target lists)
+    std::string prefix_groups;    // "<cidr> <group>" file mapping targets to groups
 
     cping::PingOptions ping;      // Lower-level ping parameters
 
@@ -19,6 +40,11 @@ struct CliOptions {
     bool summary{false};          // Only show summary at the end
     bool continuous{false};       // Run until CTRL+C
     bool timestamp{false};        // Prefix per-line output with timestamp
+    bool anomaly{false};          // Online RTT/jitter/loss anomaly detection
+    bool flood{false};            // AIMD flood / throughput mode
+    bool txtime{false};           // Kernel (SO_TXTIME) departure times for paced sends
+    bool tsc{false};              // Calibrated TSC for engine timestamps
+    bool collect{false};          // Gather every responder (broadcast / multicast)
 
     int interval_ms{1000};        // Continuous mode interval
     int count{-1};                // Number of probes (default infinite in continuous)
@@ -0,0 +1,177 @@
+/**
+ * TscClock calibration and CPU suitability checks.
+ */
+
+#include "cping/clock.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+  #include <cpuid.h>
+#endif
+
+namespace cping {
+
+namespace {
+
+constexpr double  kReanchorNs = 1e9;    // Re-anchor period
+constexpr double  kMaxSlew    = 1e-3;   // Largest rate change used to absorb an offset
+constexpr int64_t kStepNs     = 1000000;// Further behind than this: step forward instead
+
+// Writers (calibrate, re-anchor) are serialised; the origin is the first
+// calibration sample, the long baseline the rate is refined over
+std::mutex g_write;
+uint64_t   g_origin_ticks = 0;
+int64_t    g_origin_ns    = 0;
+
+bool plausible(double ns_per_tick) {
+    // Anything outside 100 MHz .. 10 GHz is a broken counter, not a CPU
+    return ns_per_tick >= 0.1 && ns_per_tick <= 10.0;
+}
+
+uint64_t to_mult(double ns_per_tick) {
+    return static_cast<uint64_t>(std::llround(ns_per_tick * 4294967296.0));
+}
+
+bool has_invariant_tsc() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int r[4] = {};
+    __cpuid(r, 0x80000000);
+    if (static_cast<unsigned>(r[0]) < 0x80000007u)
+        return false;
+    __cpuid(r, 0x80000007);
+    return (r[3] & (1 << 8)) != 0;                  // EDX.InvariantTSC
+#elif defined(__x86_64__) || defined(__i386__)
+    unsigned a, b, c, d;
+    if (!__get_cpuid(0x80000007u, &a, &b, &c, &d))
+        return false;
+    return (d & (1u << 8)) != 0;                    // EDX.InvariantTSC
+#else
+    return false;
+#endif
+}
+
+/**
+ * The kernel demotes the TSC from its clocksource when it sees it drift
+ * or jump (unsynchronised sockets, unstable hypervisor TSC), so "tsc"
+ * there means the counter is trustworthy across CPUs.
+ */
+bool os_trusts_tsc() {
+#if defined(__linux__)
+    std::ifstream f("/sys/devices/system/clocksource/clocksource0/current_clocksource");
+    std::string src;
+    return (f >> src) && src == "tsc";
+#else
+    return true;
+#endif
+}
+
+/**
+ * One (ticks, steady ns) pair: the steady_clock read bracketed by the
+ * closest pair of TSC reads out of a few tries, so a preemption in the
+ * middle of a sample cannot skew the rate.
+ */
+void sample(uint64_t& ticks, int64_t& ns) {
+    uint64_t best = std::numeric_limits<uint64_t>::max();
+    for (int i = 0; i < 32; ++i) {
+        const uint64_t t0 = TscClock::ticks();
+        const auto     n  = std::chrono::steady_clock::now().time_since_epoch().count();
+        const uint64_t t1 = TscClock::ticks();
+        if (t1 - t0 < best) {
+            best  = t1 - t0;
+            ticks = t0 + (t1 - t0) / 2;
+            ns    = n;
+        }
+    }
+}
+
+} // namespace
+
+
+bool TscClock::suitable() {
+    return has_invariant_tsc() && os_trusts_tsc();
+}
+
+void TscClock::publish(const Params& p) noexcept {
+    const uint32_t s = seq_.load(std::memory_order_relaxed);
+    seq_.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    base_ticks_.store(p.base_ticks, std::memory_order_relaxed);
+    base_ns_.store(p.base_ns, std::memory_order_relaxed);
+    mult_.store(p.mult, std::memory_order_relaxed);
+    period_ticks_.store(p.period_ticks, std::memory_order_relaxed);
+    seq_.store(s + 2, std::memory_order_release);
+}
+
+void TscClock::reanchor() noexcept {
+    // One thread re-anchors; the others keep the current parameters
+    std::unique_lock<std::mutex> lk(g_write, std::try_to_lock);
+    if (!lk.owns_lock() || !active())
+        return;
+
+    uint64_t t = 0;
+    int64_t  n = 0;
+    sample(t, n);
+
+    Params p = params();
+    if (t <= p.base_ticks || t - p.base_ticks <= p.period_ticks)
+        return;                                     // Someone else just did
+
+    // Rate over the whole run since calibration: its error shrinks as
+    // the baseline grows
+    const double rate = double(n - g_origin_ns) / double(t - g_origin_ticks);
+    const double ns_per_tick = plausible(rate) ? rate : double(p.mult) / 4294967296.0;
+
+    // Continue from where the clock is now and absorb the offset to
+    // steady_clock over the next period; only a clock far behind steps
+    const rep     at     = convert(t, p).time_since_epoch().count();
+    const int64_t offset = n - at;
+    p.base_ticks = t;
+    p.base_ns    = offset > kStepNs ? static_cast<rep>(n) : at;
+
+    const double slew = offset > kStepNs ? 0.0
+                      : std::clamp(double(offset) / kReanchorNs, -kMaxSlew, kMaxSlew);
+    p.mult = to_mult(ns_per_tick * (1.0 + slew));
+    publish(p);
+}
+
+bool TscClock::calibrate(std::chrono::milliseconds window) {
+    std::lock_guard<std::mutex> lk(g_write);
+    disable();
+    if (!suitable())
+        return false;
+
+    uint64_t t0 = 0, t1 = 0;
+    int64_t  n0 = 0, n1 = 0;
+    sample(t0, n0);
+    std::this_thread::sleep_for(window);
+    sample(t1, n1);
+
+    if (t1 <= t0 || n1 <= n0)
+        return false;
+
+    const double ns_per_tick = double(n1 - n0) / double(t1 - t0);
+    if (!plausible(ns_per_tick))
+        return false;
+
+    g_origin_ticks = t0;
+    g_origin_ns    = n0;
+    publish({ t1, static_cast<rep>(n1), to_mult(ns_per_tick),
+              static_cast<uint64_t>(kReanchorNs / ns_per_tick) });
+    active_.store(true, std::memory_order_release);
+    return true;
+}
+
+double TscClock::frequency_hz() noexcept {
+    if (!active())
+        return 0.0;
+    return 4294967296.0 / double(params().mult) * 1e9;
+}
+
+} // namespace cping
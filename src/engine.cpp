@@ -4,8 +4,9 @@
  * Responsibilities:
  * - Open a raw ICMP socket + WinPcap capture
  * - Spawn a listener thread that dispatches ICMP Echo Replies to waiting probes
- * - Correlate replies using (id, seq) pairs stored in a promise/future map
- * - Provide a fast async probe API (ping_once_engine)
+ * - Correlate replies using (id, seq) pairs stored in the shared waiter table
+ * - Bound probes on the wire with per-priority admission control
+ * - Provide a fast async probe API (submit_probe / ping_once_engine)
  *
  * This engine is optional: the higher-level ping implementation will fall
  * back to raw-socket + pcap (ping_once_win) when the engine is disabled.
@@ -16,16 +17,22 @@
 #include "win/win_icmp.hpp"
 #include "win/win_route.hpp"
 #include "cping/util.hpp"
+#include "engine_core.hpp"
 
+#include <algorithm>
 #include <cstring>
 #include <atomic>
 #include <future>
+#include <memory>
 #include <mutex>
 #include <thread>
-#include <unordered_map>
+#include <vector>
 
 namespace cping {
 
+using detail::Clock;
+using detail::Key;
+
 // ============================================================================
 // Global engine state
 // ============================================================================
@@ -35,42 +42,46 @@ static SOCKET g_sock = INVALID_SOCKET;
 static std::thread g_listener;
 static std::atomic<bool> g_running{false};
 
-// Key used to correlate echo replies with outstanding promises
-struct Key { uint16_t id; uint16_t seq; };
-
-struct KeyHash {
-    size_t operator()(const Key& k) const noexcept {
-        return (size_t(k.id) << 16) ^ k.seq;
-    }
-};
-struct KeyEq {
-    bool operator()(const Key& a, const Key& b) const noexcept {
-        return a.id == b.id && a.seq == b.seq;
-    }
-};
-
-// Map (id,seq) → promise<Probe>
-static std::unordered_map<
-    Key,
-    std::promise<PingProbeResult>,
-    KeyHash,
-    KeyEq
-> g_waiters;
+// Outstanding probes + send slots (shared with the Linux engine)
+static AdmissionControl g_admission;
+static detail::WaiterTable g_waiters{g_admission};
+static detail::CaptureTap g_capture;
+static detail::Pacer g_pacer;
 
-static std::mutex g_mtx;
+// TSC timestamps requested (calibrated by init_engine)
+static std::atomic<bool> g_tsc_want{false};
 
 // Global sequence generator (per process)
 static std::atomic<uint16_t> g_seq{1};
 
+// Slack past a probe's timeout before a blocking caller stops waiting
+static constexpr int kResultGraceMs = 1000;
+
+// Winsock has no per-packet TTL: an override is set, sent with and undone
+// under this lock, so sends from the pacer and callers cannot mix them.
+// Multicast goes back to its default of 1 hop.
+static std::mutex g_send_mtx;
+static int g_default_ttl = 128;
+static constexpr int kMulticastTtl = 1;
+
+
+// ============================================================================
+// Capture (pcap already sees whole IPv4 packets and stamps them)
+// ============================================================================
+void set_engine_capture(PcapngWriter* writer) {
+    g_capture.set(writer);
+}
+
 
 // ============================================================================
 // Listener thread
 // ============================================================================
 /**
  * Captures inbound ICMP Echo Replies via WinPcap and dispatches them
- * to the corresponding waiting promise, if present.
+ * to the corresponding waiter, if present, and expires probes whose
+ * deadline has passed.
  *
- * RTT is calculated by the caller (which knows the send timestamp).
+ * RTT is derived by the waiter table from the registered send time.
  * Here we only capture TTL and confirm that the reply matches id/seq.
  */
 static void listener_loop() {
@@ -83,6 +94,9 @@ static void listener_loop() {
         pcap_pkthdr* h = nullptr;
         const u_char* data = nullptr;
 
+        // Capture timeout is 1 ms, so deadlines are checked continuously
+        g_waiters.expire(Clock::now());
+
         int r = pcap_next_ex(cap, &h, &data);
         if (r == 0)   continue; // timeout
         if (r == -2) break;     // breakloop()
@@ -100,6 +114,15 @@ static void listener_loop() {
             continue;
 
         auto* icmph = reinterpret_cast<const IcmpHeader*>(data + ETHER_LEN + ihl);
+
+        // Our own requests are captured on the send path
+        if (g_capture.active() && icmph->type != 8) {
+            uint64_t ts_ns = uint64_t(h->ts.tv_sec) * 1'000'000'000u
+                           + uint64_t(h->ts.tv_usec) * 1000u;
+            g_capture.ipv4(CaptureDirection::Inbound, ts_ns,
+                           data + ETHER_LEN, h->caplen - ETHER_LEN);
+        }
+
         if (icmph->type != 0) continue;  // 0 = Echo Reply
 
         Key k{ ntohs(icmph->id), ntohs(icmph->seq) };
@@ -107,19 +130,12 @@ static void listener_loop() {
         PingProbeResult probe{};
         probe.success = true;
         probe.ttl     = static_cast<int>(iphdr->ttl);
-        probe.rtt_ms  = 0; // caller computes actual RTT
-
-        // Try to resolve promise
-        {
-            std::lock_guard<std::mutex> lk(g_mtx);
-            auto it = g_waiters.find(k);
-            if (it != g_waiters.end()) {
-                std::promise<PingProbeResult> tmp = std::move(it->second);
-                g_waiters.erase(it);
-                try { tmp.set_value(probe); } catch (...) {}
-            }
-        }
+
+        // Try to resolve waiter (RTT filled in by the table)
+        g_waiters.complete(k, probe, Clock::now(), Address::v4(ntohl(iphdr->saddr)));
     }
+
+    g_waiters.fail_all("Engine listener stopped");
 }
 
 
@@ -138,6 +154,10 @@ bool init_engine(const std::string& if_name) {
     if (g_running.load())
         return true; // already initialized
 
+    // Before any engine thread reads the clock
+    if (!g_tsc_want.load() || !TscClock::calibrate())
+        TscClock::disable();
+
     char errbuf[PCAP_ERRBUF_SIZE]{};
     pcap_if_t* alldevs = nullptr;
 
@@ -188,7 +208,19 @@ bool init_engine(const std::string& if_name) {
     if (g_sock == INVALID_SOCKET)
         return false;
 
+    // Restored after every TTL override
+    int ttl_len = sizeof(g_default_ttl);
+    getsockopt(g_sock, IPPROTO_IP, IP_TTL,
+               reinterpret_cast<char*>(&g_default_ttl), &ttl_len);
+
+    // Broadcast destinations for collecting probes
+    BOOL bcast = TRUE;
+    setsockopt(g_sock, SOL_SOCKET, SO_BROADCAST,
+               reinterpret_cast<const char*>(&bcast), sizeof(bcast));
+
+    g_admission.reset();
     g_running = true;
+    g_pacer.start();
     g_listener = std::thread(listener_loop);
 
     return true;
@@ -201,6 +233,12 @@ bool init_engine(const std::string& if_name) {
 void shutdown_engine() {
     g_running = false;
 
+    // Reject queued submissions; blocked submitters return immediately
+    g_admission.abort_all();
+
+    // Deferred probes never leave; their waiters are failed below
+    g_pacer.stop();
+
     // Signal capture loop to stop
     if (g_cap.h)
         pcap_breakloop(g_cap.h);
@@ -222,82 +260,81 @@ void shutdown_engine() {
         g_sock = INVALID_SOCKET;
     }
 
-    // Resolve all outstanding promises with empty result
-    {
-        std::lock_guard<std::mutex> lk(g_mtx);
-        for (auto& kv : g_waiters) {
-            try {
-                auto fut = kv.second.get_future();
-                if (fut.valid())
-                    kv.second.set_value(PingProbeResult{});
-            } catch (...) {}
-        }
-        g_waiters.clear();
-    }
+    // Resolve all outstanding probes
+    g_waiters.fail_all("Engine shut down");
 }
 
 
 // ============================================================================
-// Engine probe
+// Engine send path
 // ============================================================================
 /**
- * Performs a single ICMP probe using the global engine.
- *
- * Workflow:
- * - Create (id,seq) pair
- * - Insert promise into waiter map
- * - Send raw ICMP Echo Request
- * - Wait for listener thread to resolve the future
+ * sendto() one built Echo Request; fails the waiter on error.
  */
-PingProbeResult ping_once_engine(const std::string& ip,
-                                 int timeout_ms,
-                                 int payload_size,
-                                 int ttl)
+static void transmit(const Key& k, const in_addr& dst, int ttl,
+                     const std::vector<unsigned char>& packet)
 {
-    PingProbeResult probe{};
+    sockaddr_in dstsa{};
+    dstsa.sin_family = AF_INET;
+    dstsa.sin_addr   = dst;
 
-    // Validate IPv4
-    in_addr dst{};
-    if (InetPtonA(AF_INET, ip.c_str(), &dst) != 1) {
-        probe.error_msg = "Invalid IP";
-        return probe;
+    std::lock_guard<std::mutex> lk(g_send_mtx);
+
+    // Optional TTL override (multicast has its own, default 1)
+    const bool multicast = (ntohl(dst.s_addr) & 0xF0000000u) == 0xE0000000u;
+    if (ttl > 0) {
+        setsockopt(
+            g_sock,
+            IPPROTO_IP,
+            multicast ? IP_MULTICAST_TTL : IP_TTL,
+            reinterpret_cast<const char*>(&ttl),
+            sizeof(ttl)
+        );
     }
 
-    // Fast-path for local addresses
-    if (is_local_ipv4_addr(dst)) {
-        long rtt_ms = 0;
-        int ttl_local = -1;
+    const uint64_t ts_send = g_capture.active() ? detail::wall_clock_ns() : 0;
 
-        if (icmp_ping_local(dst, timeout_ms, rtt_ms, ttl_local)) {
-            probe.success = true;
-            probe.rtt_ms  = rtt_ms;
-            probe.ttl     = ttl_local;
-        } else {
-            probe.error_msg = "Local ICMP failed";
-        }
+    int sent = sendto(
+        g_sock,
+        reinterpret_cast<const char*>(packet.data()),
+        static_cast<int>(packet.size()),
+        0,
+        reinterpret_cast<const sockaddr*>(&dstsa),
+        sizeof(dstsa)
+    );
 
-        return probe;
+    if (ttl > 0) {
+        const int restore = multicast ? kMulticastTtl : g_default_ttl;
+        setsockopt(g_sock, IPPROTO_IP, multicast ? IP_MULTICAST_TTL : IP_TTL,
+                   reinterpret_cast<const char*>(&restore), sizeof(restore));
     }
 
-    if (g_sock == INVALID_SOCKET) {
-        probe.error_msg = "Engine socket not available";
-        return probe;
+    if (sent == SOCKET_ERROR) {
+        g_waiters.fail(k, "sendto failed");
+        return;
     }
 
-    // Allocate id/seq and waiter entry
+    if (ts_send)
+        g_capture.icmp(CaptureDirection::Outbound, ts_send, 0, dst.s_addr,
+                       ttl, packet.data(), packet.size());
+}
+
+/**
+ * Puts one admitted probe on the wire. The caller already holds a send
+ * slot; it is given back through the waiter table on every outcome.
+ * A future `depart` is handed to the pacer thread (no SO_TXTIME here).
+ * A set `on_collect` registers a collecting probe instead of `on_done`.
+ */
+static void send_echo(const in_addr& dst, int timeout_ms, int payload_size,
+                      int ttl, uint64_t tag, ProbeCallback on_done,
+                      CollectCallback on_collect,
+                      std::stop_token stop, Clock::time_point depart)
+{
     uint16_t id  = static_cast<uint16_t>(GetCurrentProcessId() & 0xFFFF);
     uint16_t seq = g_seq.fetch_add(1, std::memory_order_relaxed);
 
     Key k{ id, seq };
 
-    std::promise<PingProbeResult> pr;
-    auto fut = pr.get_future();
-
-    {
-        std::lock_guard<std::mutex> lk(g_mtx);
-        g_waiters.emplace(k, std::move(pr));
-    }
-
     // Craft payload (timestamp + extra bytes)
     uint64_t ticks = GetTickCount64();
     std::vector<unsigned char> payload(sizeof(ticks) + payload_size, 0);
@@ -317,60 +354,249 @@ PingProbeResult ping_once_engine(const std::string& ip,
     reinterpret_cast<IcmpHeader*>(packet.data())->checksum =
         checksum16(packet.data(), packet.size());
 
-    sockaddr_in dstsa{};
-    dstsa.sin_family = AF_INET;
-    dstsa.sin_addr   = dst;
+    const bool deferred = depart > Clock::now();
+
+    // Register before sending: the reply may beat sendto() back
+    const Clock::time_point t_send = deferred ? depart : Clock::time_point{};
+    if (on_collect)
+        g_waiters.add_collect(k, timeout_ms, tag, std::move(on_collect), stop, t_send);
+    else
+        g_waiters.add(k, timeout_ms, tag, std::move(on_done), stop, t_send);
+
+    // Cancelled before it left: the waiter is already completed
+    if (stop.stop_requested())
+        return;
+
+    if (deferred) {
+        g_pacer.schedule(depart, [k, dst, ttl, packet = std::move(packet), stop] {
+            if (!stop.stop_requested())
+                transmit(k, dst, ttl, packet);
+        });
+        return;
+    }
 
-    // Optional TTL override
-    if (ttl > 0) {
-        setsockopt(
-            g_sock,
-            IPPROTO_IP,
-            IP_TTL,
-            reinterpret_cast<const char*>(&ttl),
-            sizeof(ttl)
-        );
+    transmit(k, dst, ttl, packet);
+}
+
+
+/**
+ * Submits a probe through the admission controller (see engine.hpp);
+ * shared by submit_probe() and submit_collect(), exactly one of the
+ * callbacks is set.
+ */
+static bool submit_echo(const ProbeRequest& req, ProbeCallback on_done,
+                        CollectCallback on_collect, AdmitMode mode)
+{
+    if (!g_running.load() || g_sock == INVALID_SOCKET)
+        return false;
+
+    // Per-packet source selection needs IP_PKTINFO; the raw-socket path
+    // here has no equivalent
+    if (!req.source.empty() || req.if_index != 0)
+        return false;
+
+    in_addr dst{};
+    if (!req.addr.empty()) {
+        if (!req.addr.is_v4())
+            return false;
+        dst.s_addr = req.addr.v4_net();
+    } else if (InetPtonA(AF_INET, req.ip.c_str(), &dst) != 1) {
+        return false;
     }
 
-    // Send
-    auto t_send = std::chrono::high_resolution_clock::now();
+    const int timeout_ms   = req.timeout_ms;
+    const int payload_size = req.payload_size > 0 ? req.payload_size : 0;
+    const int ttl          = req.ttl;
+    const uint64_t tag     = req.tag;
+    const std::stop_token stop = req.stop;
+    const Clock::time_point depart = req.send_at;
+
+    switch (mode) {
+    case AdmitMode::Try:
+        if (!g_admission.try_acquire(req.priority))
+            return false;
+        break;
+
+    case AdmitMode::Block:
+        if (!g_admission.acquire(req.priority, stop))
+            return false;
+        break;
+
+    case AdmitMode::Callback:
+        g_admission.acquire_async(req.priority,
+            [=, cb = std::move(on_done), ccb = std::move(on_collect)](bool admitted) mutable {
+                if (!admitted || stop.stop_requested()) {
+                    const char* why = admitted ? "Cancelled" : "Engine shut down";
+                    try {
+                        if (ccb) {
+                            CollectResult res;
+                            res.error_msg = why;
+                            ccb(res, tag);
+                        } else {
+                            PingProbeResult probe{};
+                            probe.error_msg = why;
+                            cb(probe, tag);
+                        }
+                    } catch (...) {}
+                    if (admitted) g_admission.release();
+                    return;
+                }
+                send_echo(dst, timeout_ms, payload_size, ttl, tag,
+                          std::move(cb), std::move(ccb), stop, depart);
+            });
+        return true;
+    }
 
-    int sent = sendto(
-        g_sock,
-        reinterpret_cast<const char*>(packet.data()),
-        static_cast<int>(packet.size()),
-        0,
-        reinterpret_cast<const sockaddr*>(&dstsa),
-        sizeof(dstsa)
-    );
+    send_echo(dst, timeout_ms, payload_size, ttl, tag,
+              std::move(on_done), std::move(on_collect), stop, depart);
+    return true;
+}
 
-    if (sent == SOCKET_ERROR) {
-        std::lock_guard<std::mutex> lk(g_mtx);
-        g_waiters.erase(k);
-        probe.error_msg = "sendto failed";
+bool submit_probe(const ProbeRequest& req, ProbeCallback on_done, AdmitMode mode) {
+    return submit_echo(req, std::move(on_done), {}, mode);
+}
+
+bool submit_collect(const ProbeRequest& req, CollectCallback on_done, AdmitMode mode) {
+    return submit_echo(req, {}, std::move(on_done), mode);
+}
+
+
+void set_max_inflight(int max_probes) {
+    g_admission.set_limit(max_probes);
+}
+
+int engine_inflight() {
+    return g_admission.in_flight();
+}
+
+
+// ============================================================================
+// Engine probe
+// ============================================================================
+/**
+ * Performs a single ICMP probe using the global engine.
+ *
+ * Workflow:
+ * - Wait for a send slot in the requested priority class
+ * - Register (id,seq) in the waiter table and send the Echo Request
+ * - Wait for the listener thread to complete the probe
+ */
+PingProbeResult ping_once_engine(const std::string& ip,
+                                 int timeout_ms,
+                                 int payload_size,
+                                 int ttl,
+                                 ProbePriority priority,
+                                 std::stop_token stop)
+{
+    auto addr = Address::parse(ip);
+    return ping_once_engine(addr ? *addr : Address{}, timeout_ms, payload_size,
+                            ttl, priority, stop);
+}
+
+PingProbeResult ping_once_engine(const Address& addr,
+                                 int timeout_ms,
+                                 int payload_size,
+                                 int ttl,
+                                 ProbePriority priority,
+                                 std::stop_token stop)
+{
+    PingProbeResult probe{};
+
+    // Validate IPv4
+    if (!addr.is_v4()) {
+        probe.error_msg = "Invalid IP";
         return probe;
     }
 
-    // Wait for reply
-    if (fut.wait_for(std::chrono::milliseconds(timeout_ms)) == std::future_status::ready) {
-        probe = fut.get();
+    in_addr dst{};
+    dst.s_addr = addr.v4_net();
 
-        auto t_recv = std::chrono::high_resolution_clock::now();
-        probe.rtt_ms = static_cast<long>(
-            std::chrono::duration_cast<std::chrono::milliseconds>(t_recv - t_send).count()
-        );
+    // Fast-path for local addresses
+    if (is_local_ipv4_addr(dst)) {
+        long rtt_ms = 0;
+        int ttl_local = -1;
+
+        if (icmp_ping_local(dst, timeout_ms, rtt_ms, ttl_local)) {
+            probe.success = true;
+            probe.rtt_ms  = rtt_ms;
+            probe.ttl     = ttl_local;
+        } else {
+            probe.error_msg = "Local ICMP failed";
+        }
 
         return probe;
     }
 
-    // Timeout: remove waiter
-    {
-        std::lock_guard<std::mutex> lk(g_mtx);
-        g_waiters.erase(k);
+    if (g_sock == INVALID_SOCKET) {
+        probe.error_msg = "Engine socket not available";
+        return probe;
+    }
+
+    // Shared with the callback: it may still fire after a bounded wait gave up
+    auto pr = std::make_shared<std::promise<PingProbeResult>>();
+    auto fut = pr->get_future();
+
+    ProbeRequest req;
+    req.addr         = addr;
+    req.timeout_ms   = timeout_ms;
+    req.payload_size = payload_size;
+    req.ttl          = ttl;
+    req.priority     = priority;
+    req.stop         = stop;
+
+    bool accepted = submit_probe(req,
+        [pr](const PingProbeResult& r, uint64_t) { pr->set_value(r); },
+        AdmitMode::Block);
+
+    if (!accepted) {
+        probe.error_msg = stop.stop_requested() ? "Cancelled" : "Engine not running";
+        return probe;
     }
 
-    probe.error_msg = "Timeout";
-    return probe;
+    // The listener completes every probe (reply, timeout or shutdown); the
+    // bound only guards against a completion that never comes
+    const auto limit = std::chrono::milliseconds(std::max(timeout_ms, 0) + kResultGraceMs);
+    if (fut.wait_for(limit) != std::future_status::ready) {
+        probe.error_msg = "Timeout";
+        return probe;
+    }
+    return fut.get();
+}
+
+CollectResult ping_collect_engine(const Address& addr, int timeout_ms, int payload_size,
+                                  int ttl, std::stop_token stop)
+{
+    // Shared with the callback, which may still run after a timed-out wait
+    auto pr  = std::make_shared<std::promise<CollectResult>>();
+    auto fut = pr->get_future();
+
+    ProbeRequest req;
+    req.addr         = addr;
+    req.timeout_ms   = timeout_ms;
+    req.payload_size = payload_size;
+    req.ttl          = ttl;
+    req.stop         = stop;
+
+    bool accepted = submit_collect(req,
+        [pr](const CollectResult& r, uint64_t) { pr->set_value(r); },
+        AdmitMode::Block);
+
+    if (!accepted) {
+        CollectResult res;
+        res.error_msg = !addr.is_v4() ? "Invalid IP"
+                      : stop.stop_requested() ? "Cancelled" : "Engine not running";
+        return res;
+    }
+
+    // Ends at the deadline (or on cancel / shutdown); the grace only
+    // guards against a completion that never comes
+    const auto limit = std::chrono::milliseconds(std::max(timeout_ms, 0) + kResultGraceMs);
+    if (fut.wait_for(limit) != std::future_status::ready) {
+        CollectResult res;
+        res.error_msg = "Timeout";
+        return res;
+    }
+    return fut.get();
 }
 
 
@@ -381,4 +607,25 @@ bool engine_available() {
     return g_running.load();
 }
 
+bool set_engine_tsc(bool on) {
+    g_tsc_want = on;
+    return on && TscClock::suitable();
+}
+
+bool set_engine_txtime(bool) {
+    return false;   // No kernel departure scheduling; send_at uses the pacer
+}
+
+bool engine_txtime() {
+    return false;
+}
+
+EngineStats engine_stats() {
+    EngineStats st;
+    pcap_stat ps{};
+    if (g_cap.h && pcap_stats(g_cap.h, &ps) == 0)
+        st.rx_dropped = ps.ps_drop;
+    return st;
+}
+
 } // namespace cping
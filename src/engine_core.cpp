@@ -0,0 +1,324 @@
+/**
+ * Shared waiter table for the ICMP engines.
+ *
+ * Deadlines are kept in a min-heap with lazy deletion: entries whose probe
+ * already completed are skipped when they reach the top, so replies never
+ * have to search the heap.
+ *
+ * Cancellation: a waiter may own a std::stop_callback that fails it. A
+ * Waiter is therefore never destroyed while mtx_ is held, since
+ * destroying a stop_callback waits for a concurrently running callback,
+ * which itself needs mtx_.
+ */
+
+#include "engine_core.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+
+namespace cping::detail {
+
+void WaiterTable::add(const Key& k, int timeout_ms, uint64_t tag,
+                      ProbeCallback on_done, std::stop_token stop,
+                      Clock::time_point t_send)
+{
+    Waiter w;
+    w.t_send   = t_send != Clock::time_point{} ? t_send : Clock::now();
+    w.deadline = w.t_send + std::chrono::milliseconds(timeout_ms > 0 ? timeout_ms : 0);
+    w.tag      = tag;
+    w.on_done  = std::move(on_done);
+    insert(k, std::move(w), std::move(stop));
+}
+
+void WaiterTable::add_collect(const Key& k, int timeout_ms, uint64_t tag,
+                              CollectCallback on_done, std::stop_token stop,
+                              Clock::time_point t_send)
+{
+    Waiter w;
+    w.t_send     = t_send != Clock::time_point{} ? t_send : Clock::now();
+    w.deadline   = w.t_send + std::chrono::milliseconds(timeout_ms > 0 ? timeout_ms : 0);
+    w.tag        = tag;
+    w.on_collect = std::move(on_done);
+    insert(k, std::move(w), std::move(stop));
+}
+
+void WaiterTable::insert(const Key& k, Waiter w, std::stop_token stop) {
+    Waiter replaced;
+    bool superseded = false;
+    uint64_t serial;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        serial = w.serial = ++next_serial_;
+        deadlines_.emplace(w.deadline, k);
+
+        auto it = waiters_.find(k);
+        if (it != waiters_.end()) {
+            replaced = std::move(it->second);
+            it->second = std::move(w);
+            superseded = true;
+        } else {
+            waiters_.emplace(k, std::move(w));
+        }
+    }
+
+    // The sequence space wrapped onto a probe still outstanding: it can no
+    // longer be told apart from the new one, so it completes here (and
+    // hands back its slot) rather than never
+    if (superseded) {
+        PingProbeResult probe{};
+        probe.error_msg = "Superseded";
+        finish(replaced, probe);
+    }
+
+    if (!stop.stop_possible())
+        return;
+
+    // Registered outside the lock: the callback runs inline if the token
+    // is already stopped, and fail() takes mtx_ itself
+    auto cb = std::make_unique<StopCallback>(stop, std::function<void()>(
+        [this, k] { fail(k, "Cancelled"); }));
+
+    std::lock_guard<std::mutex> lk(mtx_);
+    auto it = waiters_.find(k);
+    if (it != waiters_.end() && it->second.serial == serial)
+        it->second.on_stop = std::move(cb);
+    // else: already completed; cb is destroyed after the lock is released
+}
+
+bool WaiterTable::complete(const Key& k, PingProbeResult probe,
+                           Clock::time_point t_recv, const Address& from)
+{
+    Waiter w;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        auto it = waiters_.find(k);
+        if (it == waiters_.end())
+            return false;
+
+        // Collecting: note the responder once and stay open until the deadline
+        if (it->second.on_collect) {
+            auto& rs = it->second.responders;
+            if (std::none_of(rs.begin(), rs.end(),
+                             [&](const EchoResponder& r) { return r.addr == from; })) {
+                auto rtt = std::max(t_recv - it->second.t_send, Clock::duration::zero());
+                rs.push_back(EchoResponder{ from, static_cast<long>(
+                    std::chrono::duration_cast<std::chrono::microseconds>(rtt).count()),
+                    probe.ttl });
+            }
+            return true;
+        }
+
+        w = std::move(it->second);
+        waiters_.erase(it);
+    }
+
+    // A reply can only precede t_send if the kernel ignored a departure time
+    auto rtt = std::max(t_recv - w.t_send, Clock::duration::zero());
+    probe.rtt_ms = static_cast<long>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(rtt).count());
+    probe.rtt_us = static_cast<long>(
+        std::chrono::duration_cast<std::chrono::microseconds>(rtt).count());
+
+    finish(w, probe);
+    return true;
+}
+
+bool WaiterTable::fail(const Key& k, const char* why) {
+    Waiter w;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        auto it = waiters_.find(k);
+        if (it == waiters_.end())
+            return false;
+        w = std::move(it->second);
+        waiters_.erase(it);
+    }
+
+    PingProbeResult probe{};
+    probe.error_msg = why;
+    finish(w, probe);
+    return true;
+}
+
+void WaiterTable::expire(Clock::time_point now) {
+    std::vector<Waiter> expired;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        while (!deadlines_.empty() && deadlines_.top().first <= now) {
+            auto [deadline, k] = deadlines_.top();
+            deadlines_.pop();
+
+            // Skip stale heap entries (probe already completed or key reused)
+            auto it = waiters_.find(k);
+            if (it == waiters_.end() || it->second.deadline != deadline)
+                continue;
+
+            expired.push_back(std::move(it->second));
+            waiters_.erase(it);
+        }
+    }
+
+    PingProbeResult probe{};
+    probe.error_msg = "Timeout";
+    for (auto& w : expired) {
+        CPING_TRACE2(timeout, w.tag,
+                     std::chrono::duration_cast<std::chrono::microseconds>(now - w.t_send).count());
+        finish(w, probe);
+    }
+}
+
+void WaiterTable::fail_all(const char* why) {
+    std::vector<Waiter> pending;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        pending.reserve(waiters_.size());
+        for (auto& kv : waiters_)
+            pending.push_back(std::move(kv.second));
+        waiters_.clear();
+        deadlines_ = {};
+    }
+
+    PingProbeResult probe{};
+    probe.error_msg = why;
+    for (auto& w : pending)
+        finish(w, probe);
+}
+
+int WaiterTable::next_timeout_ms(Clock::time_point now, int cap_ms) const {
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (deadlines_.empty())
+        return cap_ms;
+
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    deadlines_.top().first - now).count();
+    if (left < 0) return 0;
+    return left < cap_ms ? static_cast<int>(left) : cap_ms;
+}
+
+size_t WaiterTable::size() const {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return waiters_.size();
+}
+
+/**
+ * Deliver the result and hand the slot back. Never called with mtx_ held:
+ * the callback may submit new probes and release() may send queued ones.
+ */
+void WaiterTable::finish(Waiter& w, const PingProbeResult& probe) {
+    if (w.on_collect) {
+        // The deadline is how a collecting probe normally ends
+        CollectResult res;
+        res.responders = std::move(w.responders);
+        if (res.responders.empty() || probe.error_msg != "Timeout")
+            res.error_msg = probe.error_msg;
+        try { w.on_collect(res, w.tag); } catch (...) {}
+    } else if (w.on_done) {
+        try { w.on_done(probe, w.tag); } catch (...) {}
+    }
+    adm_.release();
+}
+
+
+// ============================================================================
+// Capture tap
+// ============================================================================
+void CaptureTap::set(PcapngWriter* w) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    w_ = w;
+    on_.store(w != nullptr, std::memory_order_relaxed);
+}
+
+void CaptureTap::icmp(CaptureDirection dir, uint64_t ts_ns, uint32_t src_net,
+                      uint32_t dst_net, int ttl, const void* data, size_t len)
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (w_)
+        w_->write_icmp(dir, ts_ns, src_net, dst_net, ttl,
+                       static_cast<const uint8_t*>(data), len);
+}
+
+void CaptureTap::ipv4(CaptureDirection dir, uint64_t ts_ns, const void* data, size_t len) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (w_)
+        w_->write_ipv4(dir, ts_ns, static_cast<const uint8_t*>(data), len);
+}
+
+// ============================================================================
+// Pacer
+// ============================================================================
+
+// Final stretch before a departure that is spun instead of slept
+static constexpr auto kPacerSpin = std::chrono::microseconds(200);
+
+void Pacer::start() {
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (thread_.joinable())
+        return;
+    stop_ = false;
+    thread_ = std::thread([this] { run(); });
+}
+
+void Pacer::stop() {
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable())
+        thread_.join();
+
+    std::vector<Task> dropped;
+    std::lock_guard<std::mutex> lk(mtx_);
+    dropped.swap(heap_);
+}
+
+void Pacer::schedule(Clock::time_point at, std::function<void()> fn) {
+    bool earliest;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        heap_.push_back(Task{ at, next_order_++, std::move(fn) });
+        std::push_heap(heap_.begin(), heap_.end(), Later{});
+        earliest = heap_.front().order == next_order_ - 1;
+    }
+    if (earliest)
+        cv_.notify_one();
+}
+
+void Pacer::run() {
+    std::unique_lock<std::mutex> lk(mtx_);
+    while (!stop_) {
+        if (heap_.empty()) {
+            cv_.wait(lk);
+            continue;
+        }
+
+        const auto at  = heap_.front().at;
+        const auto now = Clock::now();
+        if (now + kPacerSpin < at) {
+            cv_.wait_until(lk, at - kPacerSpin);
+            continue;                       // an earlier task may have arrived
+        }
+        if (now < at) {
+            lk.unlock();
+            while (Clock::now() < at)
+                std::this_thread::yield();
+            lk.lock();
+            continue;
+        }
+
+        std::pop_heap(heap_.begin(), heap_.end(), Later{});
+        Task t = std::move(heap_.back());
+        heap_.pop_back();
+
+        lk.unlock();
+        try { t.fn(); } catch (...) {}
+        lk.lock();
+    }
+}
+
+uint64_t wall_clock_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+} // namespace cping::detail
@@ -0,0 +1,199 @@
+#pragma once
+/**
+ * Platform-neutral core shared by the Windows and Linux engines.
+ *
+ * Both backends correlate Echo Replies by (id, seq) and differ only in how
+ * packets are sent and captured. Everything else — the waiter table,
+ * reply deadlines and slot accounting — lives here.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <stop_token>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "cping/admission.hpp"
+#include "cping/capture.hpp"
+#include "cping/clock.hpp"
+#include "cping/engine.hpp"
+
+namespace cping::detail {
+
+// Send, receive and deadline timestamps; the TSC once set_engine_tsc()
+// is on, otherwise steady_clock (same time_point type either way)
+using Clock = TscClock;
+
+// Key used to correlate echo replies with outstanding probes
+struct Key { uint16_t id; uint16_t seq; };
+
+struct KeyHash {
+    size_t operator()(const Key& k) const noexcept {
+        return (size_t(k.id) << 16) ^ k.seq;
+    }
+};
+struct KeyEq {
+    bool operator()(const Key& a, const Key& b) const noexcept {
+        return a.id == b.id && a.seq == b.seq;
+    }
+};
+
+/**
+ * Outstanding probes keyed by (id, seq).
+ *
+ * Each completion (reply, timeout, failure) invokes the probe callback
+ * outside the table lock and returns the probe's slot to the admission
+ * controller, which may start the next queued probe on the same thread.
+ */
+class WaiterTable {
+public:
+    explicit WaiterTable(AdmissionControl& adm) : adm_(adm) {}
+
+    /**
+     * Register a probe about to be sent. RTT and deadline count from
+     * `t_send`, or from now when it is left empty (a probe scheduled for
+     * later departure passes its departure time). A stop request on
+     * `stop` fails the probe with "Cancelled" (inline if the token is
+     * already stopped). A probe still registered under the same key
+     * (sequence wrap) completes at once with "Superseded".
+     */
+    void add(const Key& k, int timeout_ms, uint64_t tag, ProbeCallback on_done,
+             std::stop_token stop = {}, Clock::time_point t_send = {});
+
+    /**
+     * Register a collecting probe (submit_collect): replies only add
+     * responders, and it completes at its deadline (or on failure) with
+     * everything gathered.
+     */
+    void add_collect(const Key& k, int timeout_ms, uint64_t tag, CollectCallback on_done,
+                     std::stop_token stop = {}, Clock::time_point t_send = {});
+
+    /**
+     * Reply from `from` received: fill in RTT and complete, or add a
+     * responder to a collecting probe. False if unknown/late.
+     */
+    bool complete(const Key& k, PingProbeResult probe, Clock::time_point t_recv,
+                  const Address& from = {});
+
+    /** Complete a registered probe with an error (e.g. send failure). */
+    bool fail(const Key& k, const char* why);
+
+    /** Time out every probe whose deadline has passed. */
+    void expire(Clock::time_point now);
+
+    /** Fail all outstanding probes (engine shutdown / listener exit). */
+    void fail_all(const char* why);
+
+    /** Milliseconds until the earliest deadline, clamped to [0, cap_ms]. */
+    int next_timeout_ms(Clock::time_point now, int cap_ms) const;
+
+    size_t size() const;
+
+private:
+    using StopCallback = std::stop_callback<std::function<void()>>;
+
+    struct Waiter {
+        Clock::time_point t_send;
+        Clock::time_point deadline;
+        uint64_t tag{0};
+        uint64_t serial{0};                   // Tells key reuses apart
+        ProbeCallback on_done;
+        CollectCallback on_collect;           // Set for collecting probes
+        std::vector<EchoResponder> responders;
+        std::unique_ptr<StopCallback> on_stop;
+    };
+
+    void insert(const Key& k, Waiter w, std::stop_token stop);
+
+    using Deadline = std::pair<Clock::time_point, Key>;
+    struct Later {
+        bool operator()(const Deadline& a, const Deadline& b) const noexcept {
+            return a.first > b.first;
+        }
+    };
+
+    void finish(Waiter& w, const PingProbeResult& probe);
+
+    AdmissionControl& adm_;
+    mutable std::mutex mtx_;
+    std::unordered_map<Key, Waiter, KeyHash, KeyEq> waiters_;
+    std::priority_queue<Deadline, std::vector<Deadline>, Later> deadlines_;
+    uint64_t next_serial_{0};
+};
+
+/**
+ * Engine side of set_engine_capture(). Costs one relaxed load per packet
+ * while no writer is attached; the lock only keeps the writer from being
+ * detached while a packet is being queued.
+ */
+class CaptureTap {
+public:
+    void set(PcapngWriter* w);
+
+    bool active() const noexcept { return on_.load(std::memory_order_relaxed); }
+
+    void icmp(CaptureDirection dir, uint64_t ts_ns, uint32_t src_net, uint32_t dst_net,
+              int ttl, const void* data, size_t len);
+
+    void ipv4(CaptureDirection dir, uint64_t ts_ns, const void* data, size_t len);
+
+private:
+    std::mutex mtx_;
+    PcapngWriter* w_{nullptr};
+    std::atomic<bool> on_{false};
+};
+
+/**
+ * Userspace departure scheduler: runs each task at its time point on one
+ * background thread. The thread sleeps until shortly before the earliest
+ * task and spins the rest of the way, so departures land within a few
+ * microseconds instead of the scheduler's sleep granularity.
+ *
+ * Used for ProbeRequest::send_at whenever the kernel cannot schedule the
+ * packet itself. Tasks still pending at stop() are dropped.
+ */
+class Pacer {
+public:
+    ~Pacer() { stop(); }
+
+    void start();
+    void stop();
+
+    /** Run `fn` on the pacer thread at `at` (right away if already due). */
+    void schedule(Clock::time_point at, std::function<void()> fn);
+
+private:
+    struct Task {
+        Clock::time_point at;
+        uint64_t order;                         // FIFO among equal times
+        std::function<void()> fn;
+    };
+    struct Later {
+        bool operator()(const Task& a, const Task& b) const noexcept {
+            return a.at != b.at ? a.at > b.at : a.order > b.order;
+        }
+    };
+
+    void run();
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::vector<Task> heap_;
+    uint64_t next_order_{0};
+    bool stop_{false};
+    std::thread thread_;
+};
+
+/** Wall-clock time in nanoseconds (capture timestamps are UNIX time). */
+uint64_t wall_clock_ns();
+
+} // namespace cping::detail
@@ -7,34 +7,47 @@
  *  - Uses a datagram ICMP socket (SOCK_DGRAM + IPPROTO_ICMP)
  *  - Listener thread consumes replies via recvmsg(), extracting TTL
  *    from ancillary data (IP_RECVTTL)
- *  - Correlates replies to outstanding promises via (id, seq)
+ *  - Correlates replies to outstanding probes via (id, seq)
+ *  - Bounds probes on the wire with per-priority admission control
  *  - Mirrors the Windows engine design for full cross-platform consistency
  */
 
 #include "cping/engine.hpp"
 #include "cping/util.hpp"
 #include "cping/ip.hpp"
+#include "engine_core.hpp"
+#include "trace.hpp"
 
 #include <cstring>
+#include <algorithm>
 #include <atomic>
 #include <future>
+#include <memory>
 #include <mutex>
 #include <thread>
-#include <unordered_map>
+#include <fstream>
+#include <vector>
 
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <netinet/ip.h>
 #include <netinet/ip_icmp.h>
+#include <poll.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 #include <errno.h>
 #include <ifaddrs.h>
 #include <net/if.h>
+#include <linux/net_tstamp.h>
+#include <linux/sock_diag.h>
 
 namespace cping {
 
+using detail::Clock;
+using detail::Key;
+
 // ============================================================================
 // Global engine state (mirrors Windows implementation)
 // ============================================================================
@@ -42,58 +55,200 @@ static int g_sock = -1;
 static std::thread g_listener;
 static std::atomic<bool> g_running{false};
 
-struct Key { uint16_t id; uint16_t seq; };
-struct KeyHash {
-    size_t operator()(const Key& k) const noexcept {
-        return (size_t(k.id) << 16) ^ k.seq;
-    }
-};
-struct KeyEq {
-    bool operator()(const Key& a, const Key& b) const noexcept {
-        return a.id == b.id && a.seq == b.seq;
-    }
-};
-
-static std::unordered_map<
-    Key,
-    std::promise<PingProbeResult>,
-    KeyHash,
-    KeyEq
-> g_waiters;
+// Echo identifier of the engine socket. Datagram ICMP sockets rewrite the
+// id field with the socket's local "port", so replies carry this value
+// rather than whatever was written into the request.
+static uint16_t g_ident = 0;
 
-static std::mutex g_mtx;
+static AdmissionControl g_admission;
+static detail::CaptureTap g_capture;
+static detail::WaiterTable g_waiters{g_admission};
+static detail::Pacer g_pacer;
 static std::atomic<uint16_t> g_seq{1};
 
+// Upper bound on a listener wait, so deadlines are honoured even when a
+// shorter timeout is registered while poll() is already sleeping.
+static constexpr int kListenerTickMs = 10;
+
+// Receive slice of the blocking local fast path when it can be cancelled
+static constexpr int kCancelSliceMs = 20;
+
+// Slack past a probe's timeout before a blocking caller stops waiting
+static constexpr int kResultGraceMs = 1000;
+
+// SO_TXTIME departure scheduling: requested by the caller / active on g_sock
+static std::atomic<bool> g_txtime_want{false};
+static std::atomic<bool> g_txtime{false};
+
+// TSC timestamps requested (calibrated by init_engine)
+static std::atomic<bool> g_tsc_want{false};
+
+// Minimum spacing of the listener's drop counter reads
+static constexpr auto kDropSampleEvery = std::chrono::milliseconds(50);
+
+// Receive-queue overflow accounting (SO_MEMINFO) and buffer auto-growth
+static std::atomic<uint32_t> g_drops_seen{0};    // Last kernel sk_drops value
+static std::atomic<uint64_t> g_rx_dropped{0};
+static std::atomic<int> g_rcvbuf{0};
+static std::atomic<int> g_rcvbuf_grows{0};
+static int g_rcvbuf_max = 0;                     // net.core.rmem_max
+
+// How long the cached set of local addresses is trusted
+static constexpr auto kLocalAddrTtl = std::chrono::seconds(1);
+
 
 // ============================================================================
 // Helper: detect if IP belongs to local machine
+// The interface list is snapshotted and reused for kLocalAddrTtl, so a
+// probe costs a short scan instead of a getifaddrs() netlink round trip
 // ============================================================================
 static bool is_local_ipv4_addr_linux(const in_addr& addr) {
-    struct ifaddrs* ifa = nullptr;
-    if (getifaddrs(&ifa) != 0 || !ifa)
-        return false;
+    static std::mutex mtx;
+    static std::vector<uint32_t> local;
+    static Clock::time_point refreshed{};
 
-    bool found = false;
+    std::lock_guard<std::mutex> lk(mtx);
 
-    for (auto* p = ifa; p; p = p->ifa_next) {
-        if (!p->ifa_addr || p->ifa_addr->sa_family != AF_INET)
-            continue;
+    const auto now = Clock::now();
+    if (refreshed == Clock::time_point{} || now - refreshed >= kLocalAddrTtl) {
+        struct ifaddrs* ifa = nullptr;
+        if (getifaddrs(&ifa) != 0 || !ifa)
+            return false;
 
-        auto* sa = reinterpret_cast<sockaddr_in*>(p->ifa_addr);
-        if (sa->sin_addr.s_addr == addr.s_addr) {
-            found = true;
-            break;
+        local.clear();
+        for (auto* p = ifa; p; p = p->ifa_next) {
+            if (!p->ifa_addr || p->ifa_addr->sa_family != AF_INET)
+                continue;
+            local.push_back(reinterpret_cast<sockaddr_in*>(p->ifa_addr)->sin_addr.s_addr);
         }
+
+        freeifaddrs(ifa);
+        refreshed = now;
     }
 
-    freeifaddrs(ifa);
-    return found;
+    return std::find(local.begin(), local.end(), addr.s_addr) != local.end();
+}
+
+
+// ============================================================================
+// Capture support: kernel receive timestamps and the local address of
+// each reply (for the synthesized IPv4 header), only while capturing
+// ============================================================================
+static void set_capture_sockopts(int s, bool on) {
+    int v = on ? 1 : 0;
+    ::setsockopt(s, SOL_SOCKET, SO_TIMESTAMPNS, &v, sizeof(v));
+    ::setsockopt(s, IPPROTO_IP, IP_PKTINFO, &v, sizeof(v));
+}
+
+void set_engine_capture(PcapngWriter* writer) {
+    g_capture.set(writer);
+    if (g_sock >= 0)
+        set_capture_sockopts(g_sock, writer != nullptr);
+}
+
+
+// ============================================================================
+// Departure scheduling (SO_TXTIME, CLOCK_MONOTONIC = steady_clock)
+// ============================================================================
+/**
+ * Allow SCM_TXTIME on `s`. The kernel has no way to turn the option off
+ * again; disabling only stops the engine from attaching transmit times.
+ */
+static bool enable_txtime(int s) {
+    sock_txtime cfg{};
+    cfg.clockid = CLOCK_MONOTONIC;
+    cfg.flags   = 0;
+    return ::setsockopt(s, SOL_SOCKET, SO_TXTIME, &cfg, sizeof(cfg)) == 0;
+}
+
+bool set_engine_txtime(bool on) {
+    g_txtime_want = on;
+    if (!on) {
+        g_txtime = false;
+        return false;
+    }
+
+    if (g_sock >= 0) {
+        g_txtime = enable_txtime(g_sock);
+        return g_txtime.load();
+    }
+
+    // Not running yet: probe kernel support on a throwaway socket
+    int t = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (t < 0)
+        return false;
+    bool ok = enable_txtime(t);
+    ::close(t);
+    return ok;
+}
+
+bool set_engine_tsc(bool on) {
+    g_tsc_want = on;
+    return on && TscClock::suitable();
+}
+
+bool engine_txtime() {
+    return g_txtime.load();
+}
+
+
+// ============================================================================
+// Receive buffer
+// ============================================================================
+static int current_rcvbuf(int s) {
+    int v = 0;
+    socklen_t len = sizeof(v);
+    return ::getsockopt(s, SOL_SOCKET, SO_RCVBUF, &v, &len) == 0 ? v : 0;
+}
+
+/**
+ * Fold the kernel's cumulative drop counter (sk_drops, wraps at 2^32)
+ * into g_rx_dropped. Datagram ICMP sockets never attach SO_RXQ_OVFL
+ * ancillary data, so the counter is read with SO_MEMINFO instead.
+ *
+ * @return true if new drops were seen since the previous sample.
+ */
+static bool sample_drops(int s) {
+    uint32_t mi[SK_MEMINFO_VARS] = {};
+    socklen_t len = sizeof(mi);
+    if (::getsockopt(s, SOL_SOCKET, SO_MEMINFO, mi, &len) != 0 ||
+        len <= SK_MEMINFO_DROPS * sizeof(uint32_t))
+        return false;
+
+    const uint32_t now = mi[SK_MEMINFO_DROPS];
+    uint32_t seen = g_drops_seen.load(std::memory_order_relaxed);
+    do {
+        // A concurrent sampler already accounted for this value (or later)
+        if (static_cast<int32_t>(now - seen) <= 0)
+            return false;
+    } while (!g_drops_seen.compare_exchange_weak(seen, now, std::memory_order_relaxed));
+
+    g_rx_dropped.fetch_add(uint32_t(now - seen), std::memory_order_relaxed);
+    return true;
+}
+
+/**
+ * Double the receive buffer after a drop, up to rmem_max. The kernel
+ * reports twice the requested size (bookkeeping overhead), so the next
+ * request is the reported value.
+ */
+static void grow_rcvbuf(int s) {
+    const int cur = g_rcvbuf.load(std::memory_order_relaxed);
+    if (cur / 2 >= g_rcvbuf_max)
+        return;
+
+    int want = std::min(cur, g_rcvbuf_max);
+    if (::setsockopt(s, SOL_SOCKET, SO_RCVBUF, &want, sizeof(want)) == 0) {
+        g_rcvbuf.store(current_rcvbuf(s), std::memory_order_relaxed);
+        g_rcvbuf_grows.fetch_add(1, std::memory_order_relaxed);
+    }
 }
 
 
 // ============================================================================
 // Listener thread
-// Consumes ICMP Echo Replies and resolves the corresponding promises
+// Consumes ICMP Echo Replies, completes the matching waiters and expires
+// probes whose deadline has passed
 // ============================================================================
 static void listener_loop() {
     int s = g_sock;
@@ -110,64 +265,109 @@ static void listener_loop() {
     msg.msg_namelen = sizeof(src);
     msg.msg_iov = &iov;
     msg.msg_iovlen = 1;
-    msg.msg_control = cbuf;
-    msg.msg_controllen = sizeof(cbuf);
 
-    while (g_running.load()) {
-        ssize_t n = ::recvmsg(s, &msg, 0);
+    pollfd pfd{ s, POLLIN, 0 };
+    bool alive = true;
+    auto next_drop_sample = Clock::now();
 
-        if (n < 0) {
-            if (errno == EINTR) continue;
-            if (errno == EAGAIN || errno == EWOULDBLOCK) continue;
-            break; // fatal error or shutdown
-        }
-        if (n == 0)
-            break; // socket shutdown
-
-        if (n < (ssize_t)sizeof(icmphdr))
-            continue;
-
-        auto* ricmp = reinterpret_cast<const icmphdr*>(recv_buf);
-        if (ricmp->type != ICMP_ECHOREPLY)
-            continue;
-
-        Key k{ ntohs(ricmp->un.echo.id),
-               ntohs(ricmp->un.echo.sequence) };
-
-        // Extract TTL from ancillary data
-        int ttl_val = -1;
-        for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
-             cmsg;
-             cmsg = CMSG_NXTHDR(&msg, cmsg))
-        {
-            if (cmsg->cmsg_level == IPPROTO_IP &&
-                cmsg->cmsg_type == IP_TTL)
-            {
-                std::memcpy(&ttl_val, CMSG_DATA(cmsg), sizeof(ttl_val));
+    while (alive && g_running.load()) {
+        int wait_ms = g_waiters.next_timeout_ms(Clock::now(), kListenerTickMs);
+        int pr = ::poll(&pfd, 1, wait_ms);
+
+        if (pr < 0 && errno != EINTR)
+            break;
+
+        // Drain everything queued on the socket before checking deadlines
+        int drained = 0;
+        while (pr > 0) {
+            msg.msg_namelen = sizeof(src);
+            msg.msg_control = cbuf;
+            msg.msg_controllen = sizeof(cbuf);
+
+            ssize_t n = ::recvmsg(s, &msg, MSG_DONTWAIT);
+
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                alive = false; // fatal error or shutdown
                 break;
             }
-        }
+            if (n == 0) {
+                alive = false; // socket shutdown
+                break;
+            }
+
+            ++drained;
+            auto t_recv = Clock::now();
+
+            // Extract TTL (and, when capturing, timestamp / local address)
+            int ttl_val = -1;
+            timespec ts_kernel{};
+            in_addr local_addr{};
+            for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+                 cmsg;
+                 cmsg = CMSG_NXTHDR(&msg, cmsg))
+            {
+                if (cmsg->cmsg_level == IPPROTO_IP &&
+                    cmsg->cmsg_type == IP_TTL)
+                {
+                    std::memcpy(&ttl_val, CMSG_DATA(cmsg), sizeof(ttl_val));
+                } else if (cmsg->cmsg_level == SOL_SOCKET &&
+                           cmsg->cmsg_type == SCM_TIMESTAMPNS)
+                {
+                    std::memcpy(&ts_kernel, CMSG_DATA(cmsg), sizeof(ts_kernel));
+                } else if (cmsg->cmsg_level == IPPROTO_IP &&
+                           cmsg->cmsg_type == IP_PKTINFO)
+                {
+                    in_pktinfo pi;
+                    std::memcpy(&pi, CMSG_DATA(cmsg), sizeof(pi));
+                    local_addr = pi.ipi_addr;
+                }
+            }
 
-        PingProbeResult probe{};
-        probe.success = true;
-        probe.ttl     = (ttl_val >= 0) ? ttl_val : -1;
-        probe.rtt_ms  = 0;  // caller computes RTT
-
-        // Resolve waiter, if present
-        {
-            std::lock_guard<std::mutex> lk(g_mtx);
-            auto it = g_waiters.find(k);
-            if (it != g_waiters.end()) {
-                std::promise<PingProbeResult> tmp = std::move(it->second);
-                g_waiters.erase(it);
-                try { tmp.set_value(probe); } catch (...) {}
+            // Every ICMP message is captured, not only the echo replies
+            if (g_capture.active()) {
+                uint64_t ts_ns = ts_kernel.tv_sec
+                    ? uint64_t(ts_kernel.tv_sec) * 1'000'000'000u + uint64_t(ts_kernel.tv_nsec)
+                    : detail::wall_clock_ns();
+                g_capture.icmp(CaptureDirection::Inbound, ts_ns, src.sin_addr.s_addr,
+                               local_addr.s_addr, ttl_val, recv_buf, static_cast<size_t>(n));
             }
+
+            if (n < (ssize_t)sizeof(icmphdr))
+                continue;
+
+            auto* ricmp = reinterpret_cast<const icmphdr*>(recv_buf);
+            if (ricmp->type != ICMP_ECHOREPLY)
+                continue;
+
+            Key k{ ntohs(ricmp->un.echo.id),
+                   ntohs(ricmp->un.echo.sequence) };
+
+            PingProbeResult probe{};
+            probe.success = true;
+            probe.ttl     = (ttl_val >= 0) ? ttl_val : -1;
+
+            // Resolve waiter, if present (RTT filled in by the table)
+            bool matched = g_waiters.complete(k, probe, t_recv,
+                                              Address::v4(ntohl(src.sin_addr.s_addr)));
+            CPING_TRACE4(reply, k.id, k.seq, probe.ttl, matched ? 1 : 0);
         }
 
-        // Reset control buffer
-        msg.msg_control = cbuf;
-        msg.msg_controllen = sizeof(cbuf);
+        CPING_TRACE2(batch, drained, wait_ms);
+
+        // Drops only happen while replies arrive, so idle wakeups skip the read
+        if (drained > 0 && Clock::now() >= next_drop_sample) {
+            next_drop_sample = Clock::now() + kDropSampleEvery;
+            if (sample_drops(s))
+                grow_rcvbuf(s);
+        }
+
+        g_waiters.expire(Clock::now());
     }
+
+    // Nobody will answer the remaining probes any more
+    g_waiters.fail_all("Engine listener stopped");
 }
 
 
@@ -178,6 +378,10 @@ bool init_engine(const std::string& if_name) {
     if (g_running.load())
         return true;
 
+    // Before any engine thread reads the clock
+    if (!g_tsc_want.load() || !TscClock::calibrate())
+        TscClock::disable();
+
     // ICMP datagram socket (no IP header exposure)
     int s = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_ICMP);
     if (s < 0)
@@ -197,13 +401,46 @@ bool init_engine(const std::string& if_name) {
     int ttl_def = 64;
     ::setsockopt(s, IPPROTO_IP, IP_TTL, &ttl_def, sizeof(ttl_def));
 
+    // Broadcast destinations for collecting probes (EACCES otherwise)
+    ::setsockopt(s, SOL_SOCKET, SO_BROADCAST, &one, sizeof(one));
+
+    // Bind to obtain the kernel-assigned echo identifier up front
+    sockaddr_in local{};
+    local.sin_family = AF_INET;
+    socklen_t local_len = sizeof(local);
+
+    if (::bind(s, reinterpret_cast<sockaddr*>(&local), sizeof(local)) < 0 ||
+        ::getsockname(s, reinterpret_cast<sockaddr*>(&local), &local_len) < 0)
+    {
+        ::close(s);
+        return false;
+    }
+
+    if (g_capture.active())
+        set_capture_sockopts(s, true);
+
+    g_txtime = g_txtime_want.load() && enable_txtime(s);
+
+    std::ifstream rmem("/proc/sys/net/core/rmem_max");
+    if (!(rmem >> g_rcvbuf_max))
+        g_rcvbuf_max = 0;
+
+    g_drops_seen = 0;
+    g_rx_dropped = 0;
+    g_rcvbuf_grows = 0;
+    g_rcvbuf = current_rcvbuf(s);
+
+    g_ident = ntohs(local.sin_port);
     g_sock = s;
+    g_admission.reset();
     g_running = true;
 
     try {
+        g_pacer.start();
         g_listener = std::thread(listener_loop);
     } catch (...) {
         g_running = false;
+        g_pacer.stop();
         ::close(g_sock);
         g_sock = -1;
         return false;
@@ -216,6 +453,12 @@ bool init_engine(const std::string& if_name) {
 void shutdown_engine() {
     g_running = false;
 
+    // Reject queued submissions; blocked submitters return immediately
+    g_admission.abort_all();
+
+    // Deferred probes never leave; their waiters are failed below
+    g_pacer.stop();
+
     // Wake listener thread
     if (g_sock >= 0)
         ::shutdown(g_sock, SHUT_RD);
@@ -230,13 +473,292 @@ void shutdown_engine() {
     }
 
     // Resolve pending waiters
-    {
-        std::lock_guard<std::mutex> lk(g_mtx);
-        for (auto& kv : g_waiters) {
-            try { kv.second.set_value(PingProbeResult{}); } catch (...) {}
+    g_waiters.fail_all("Engine shut down");
+}
+
+
+// ============================================================================
+// Engine send path
+// ============================================================================
+/**
+ * One built Echo Request, ready to be handed to the kernel.
+ */
+struct Outgoing {
+    std::vector<unsigned char> packet;
+    sockaddr_in dst{};
+    in_addr src{};                          // 0 = routing decides
+    unsigned if_index{0};
+    int ttl{-1};
+    Key k{};
+    uint64_t txtime_ns{0};                  // SCM_TXTIME, 0 = now
+};
+
+/**
+ * sendto(), or sendmsg() when the packet carries IP_PKTINFO, a TTL
+ * override or a transmit time. Fails the waiter on error.
+ *
+ * The TTL goes along as IP_TTL ancillary data: it applies to this packet
+ * only, so concurrent sends on the shared socket cannot pick up each
+ * other's override. It also takes precedence over the multicast TTL,
+ * which therefore stays at its default of 1 for probes without one.
+ */
+static void transmit(const Outgoing& o) {
+    const bool ttl_cmsg = o.ttl > 0;
+
+    ssize_t sent;
+    uint64_t ts_send = 0;
+    if (g_capture.active()) {
+        ts_send = detail::wall_clock_ns();
+        if (o.txtime_ns) {
+            // Stamped with the departure the qdisc was asked for
+            const auto now_ns = static_cast<uint64_t>(std::chrono::duration_cast<
+                std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count());
+            if (o.txtime_ns > now_ns)
+                ts_send += o.txtime_ns - now_ns;
+        }
+    }
+
+    const bool pktinfo = o.src.s_addr != 0 || o.if_index != 0;
+
+    if (!pktinfo && !ttl_cmsg && !o.txtime_ns) {
+        sent = ::sendto(g_sock,
+                        o.packet.data(),
+                        o.packet.size(),
+                        0,
+                        reinterpret_cast<const sockaddr*>(&o.dst),
+                        sizeof(o.dst));
+    } else {
+        alignas(cmsghdr) char cbuf[CMSG_SPACE(sizeof(in_pktinfo)) +
+                                   CMSG_SPACE(sizeof(int)) +
+                                   CMSG_SPACE(sizeof(uint64_t))]{};
+        iovec iov{ const_cast<unsigned char*>(o.packet.data()), o.packet.size() };
+
+        msghdr msg{};
+        msg.msg_name       = const_cast<sockaddr_in*>(&o.dst);
+        msg.msg_namelen    = sizeof(o.dst);
+        msg.msg_iov        = &iov;
+        msg.msg_iovlen     = 1;
+        msg.msg_control    = cbuf;
+        msg.msg_controllen = sizeof(cbuf);
+
+        cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+        size_t used = 0;
+
+        if (pktinfo) {
+            cm->cmsg_level = IPPROTO_IP;
+            cm->cmsg_type  = IP_PKTINFO;
+            cm->cmsg_len   = CMSG_LEN(sizeof(in_pktinfo));
+
+            in_pktinfo pi{};
+            pi.ipi_ifindex  = static_cast<int>(o.if_index);
+            pi.ipi_spec_dst = o.src;
+            std::memcpy(CMSG_DATA(cm), &pi, sizeof(pi));
+
+            used += CMSG_SPACE(sizeof(in_pktinfo));
+            cm = CMSG_NXTHDR(&msg, cm);
+        }
+
+        if (ttl_cmsg) {
+            cm->cmsg_level = IPPROTO_IP;
+            cm->cmsg_type  = IP_TTL;
+            cm->cmsg_len   = CMSG_LEN(sizeof(int));
+            std::memcpy(CMSG_DATA(cm), &o.ttl, sizeof(o.ttl));
+
+            used += CMSG_SPACE(sizeof(int));
+            cm = CMSG_NXTHDR(&msg, cm);
+        }
+
+        if (o.txtime_ns) {
+            cm->cmsg_level = SOL_SOCKET;
+            cm->cmsg_type  = SCM_TXTIME;
+            cm->cmsg_len   = CMSG_LEN(sizeof(uint64_t));
+            std::memcpy(CMSG_DATA(cm), &o.txtime_ns, sizeof(o.txtime_ns));
+
+            used += CMSG_SPACE(sizeof(uint64_t));
         }
-        g_waiters.clear();
+
+        msg.msg_controllen = used;
+        sent = ::sendmsg(g_sock, &msg, 0);
+    }
+
+    CPING_TRACE4(send, o.k.seq, o.dst.sin_addr.s_addr, o.packet.size(), sent);
+
+    if (sent < 0) {
+        g_waiters.fail(o.k, "sendto() failed");
+        return;
+    }
+
+    if (ts_send)
+        g_capture.icmp(CaptureDirection::Outbound, ts_send, o.src.s_addr,
+                       o.dst.sin_addr.s_addr, o.ttl, o.packet.data(), o.packet.size());
+}
+
+/**
+ * Puts one admitted probe on the wire. The caller already holds a send
+ * slot; it is given back through the waiter table on every outcome.
+ *
+ * A non-zero `src` or `if_index` is passed as IP_PKTINFO ancillary data,
+ * which picks source address / egress interface for this packet only.
+ * A future `depart` becomes an SCM_TXTIME transmit time when kernel
+ * scheduling is on, and a pacer task otherwise. A set `on_collect`
+ * registers a collecting probe instead of `on_done`.
+ */
+static void send_echo(const in_addr& dst, const in_addr& src, unsigned if_index,
+                      int timeout_ms, int payload_size,
+                      int ttl, uint64_t tag, ProbeCallback on_done,
+                      CollectCallback on_collect,
+                      std::stop_token stop, Clock::time_point depart)
+{
+    uint16_t seq = g_seq.fetch_add(1, std::memory_order_relaxed);
+
+    Outgoing o;
+    o.k        = Key{ g_ident, seq };
+    o.src      = src;
+    o.if_index = if_index;
+    o.ttl      = ttl;
+    o.dst.sin_family = AF_INET;
+    o.dst.sin_addr   = dst;
+
+    // Build ICMP Echo Request
+    o.packet.assign(sizeof(icmphdr) + sizeof(uint64_t) + payload_size, 0);
+
+    auto* hdr = reinterpret_cast<icmphdr*>(o.packet.data());
+    hdr->type = ICMP_ECHO;
+    hdr->code = 0;
+    hdr->un.echo.id = htons(g_ident);
+    hdr->un.echo.sequence = htons(seq);
+
+    uint64_t ticks =
+        (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+            Clock::now().time_since_epoch())
+            .count();
+
+    std::memcpy(o.packet.data() + sizeof(icmphdr), &ticks, sizeof(ticks));
+
+    hdr->checksum = 0;
+    hdr->checksum = checksum16(o.packet.data(), o.packet.size());
+
+    const bool deferred = depart > Clock::now();
+
+    // Register before sending: the reply may beat sendto() back
+    const Clock::time_point t_send = deferred ? depart : Clock::time_point{};
+    if (on_collect)
+        g_waiters.add_collect(o.k, timeout_ms, tag, std::move(on_collect), stop, t_send);
+    else
+        g_waiters.add(o.k, timeout_ms, tag, std::move(on_done), stop, t_send);
+
+    // Cancelled before it left: the waiter is already completed
+    if (stop.stop_requested())
+        return;
+
+    if (deferred && !g_txtime.load(std::memory_order_relaxed)) {
+        g_pacer.schedule(depart, [o = std::move(o), stop] {
+            if (!stop.stop_requested())
+                transmit(o);
+        });
+        return;
+    }
+
+    if (deferred)
+        o.txtime_ns = static_cast<uint64_t>(std::chrono::duration_cast<
+            std::chrono::nanoseconds>(depart.time_since_epoch()).count());
+
+    transmit(o);
+}
+
+
+/**
+ * Admission and dispatch shared by submit_probe() and submit_collect();
+ * exactly one of the callbacks is set.
+ */
+static bool submit_echo(const ProbeRequest& req, ProbeCallback on_done,
+                        CollectCallback on_collect, AdmitMode mode)
+{
+    if (!g_running.load() || g_sock < 0)
+        return false;
+
+    in_addr dst{};
+    if (!req.addr.empty()) {
+        if (!req.addr.is_v4())
+            return false;
+        dst.s_addr = req.addr.v4_net();
+    } else if (inet_pton(AF_INET, req.ip.c_str(), &dst) != 1) {
+        return false;
+    }
+
+    in_addr src{};
+    if (!req.source.empty()) {
+        if (!req.source.is_v4())
+            return false;
+        src.s_addr = req.source.v4_net();
+    }
+    const unsigned if_index = req.if_index;
+
+    const int timeout_ms   = req.timeout_ms;
+    const int payload_size = req.payload_size > 0 ? req.payload_size : 0;
+    const int ttl          = req.ttl;
+    const uint64_t tag     = req.tag;
+    const std::stop_token stop = req.stop;
+    const Clock::time_point depart = req.send_at;
+
+    CPING_TRACE3(submit, tag, static_cast<int>(req.priority), static_cast<int>(mode));
+
+    switch (mode) {
+    case AdmitMode::Try:
+        if (!g_admission.try_acquire(req.priority))
+            return false;
+        break;
+
+    case AdmitMode::Block:
+        if (!g_admission.acquire(req.priority, stop))
+            return false;
+        break;
+
+    case AdmitMode::Callback:
+        g_admission.acquire_async(req.priority,
+            [=, cb = std::move(on_done), ccb = std::move(on_collect)](bool admitted) mutable {
+                if (!admitted || stop.stop_requested()) {
+                    const char* why = admitted ? "Cancelled" : "Engine shut down";
+                    try {
+                        if (ccb) {
+                            CollectResult res;
+                            res.error_msg = why;
+                            ccb(res, tag);
+                        } else {
+                            PingProbeResult probe{};
+                            probe.error_msg = why;
+                            cb(probe, tag);
+                        }
+                    } catch (...) {}
+                    if (admitted) g_admission.release();
+                    return;
+                }
+                send_echo(dst, src, if_index, timeout_ms, payload_size, ttl, tag,
+                          std::move(cb), std::move(ccb), stop, depart);
+            });
+        return true;
     }
+
+    send_echo(dst, src, if_index, timeout_ms, payload_size, ttl, tag,
+              std::move(on_done), std::move(on_collect), stop, depart);
+    return true;
+}
+
+bool submit_probe(const ProbeRequest& req, ProbeCallback on_done, AdmitMode mode) {
+    return submit_echo(req, std::move(on_done), {}, mode);
+}
+
+bool submit_collect(const ProbeRequest& req, CollectCallback on_done, AdmitMode mode) {
+    return submit_echo(req, {}, std::move(on_done), mode);
+}
+
+
+void set_max_inflight(int max_probes) {
+    g_admission.set_limit(max_probes);
+}
+
+int engine_inflight() {
+    return g_admission.in_flight();
 }
 
 
@@ -246,17 +768,32 @@ void shutdown_engine() {
 PingProbeResult ping_once_engine(const std::string& ip,
                                  int timeout_ms,
                                  int payload_size,
-                                 int ttl)
+                                 int ttl,
+                                 ProbePriority priority,
+                                 std::stop_token stop)
+{
+    auto addr = Address::parse(ip);
+    return ping_once_engine(addr ? *addr : Address{}, timeout_ms, payload_size,
+                            ttl, priority, stop);
+}
+
+PingProbeResult ping_once_engine(const Address& addr,
+                                 int timeout_ms,
+                                 int payload_size,
+                                 int ttl,
+                                 ProbePriority priority,
+                                 std::stop_token stop)
 {
     PingProbeResult probe{};
 
-    // Parse IPv4
-    in_addr dst{};
-    if (inet_pton(AF_INET, ip.c_str(), &dst) != 1) {
+    if (!addr.is_v4()) {
         probe.error_msg = "Invalid IP";
         return probe;
     }
 
+    in_addr dst{};
+    dst.s_addr = addr.v4_net();
+
     // Fast-path self-ping
     if (is_local_ipv4_addr_linux(dst)) {
         // (Kept exactly as your implementation — it's perfect)
@@ -277,12 +814,17 @@ PingProbeResult ping_once_engine(const std::string& ip,
         ::setsockopt(s, IPPROTO_IP, IP_RECVTTL, &one, sizeof(one));
         if (ttl > 0) ::setsockopt(s, IPPROTO_IP, IP_TTL, &ttl, sizeof(ttl));
 
-        // Timeout
+        // Timeout (sliced when cancellable, so a stop request is seen)
+        const int slice_ms = stop.stop_possible()
+            ? std::min(timeout_ms, kCancelSliceMs) : timeout_ms;
         timeval tv{};
-        tv.tv_sec  = timeout_ms / 1000;
-        tv.tv_usec = (timeout_ms % 1000) * 1000;
+        tv.tv_sec  = slice_ms / 1000;
+        tv.tv_usec = (slice_ms % 1000) * 1000;
         ::setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
 
+        const auto deadline = std::chrono::steady_clock::now()
+                            + std::chrono::milliseconds(timeout_ms);
+
         sockaddr_in dstsa{};
         dstsa.sin_family = AF_INET;
         dstsa.sin_addr   = dst;
@@ -313,7 +855,7 @@ PingProbeResult ping_once_engine(const std::string& ip,
         hdr->checksum = 0;
         hdr->checksum = checksum16(packet.data(), packet.size());
 
-        auto t_send = std::chrono::high_resolution_clock::now();
+        auto t_send = Clock::now();
 
         if (::send(s, packet.data(), packet.size(), 0) < 0) {
             ::close(s);
@@ -339,10 +881,17 @@ PingProbeResult ping_once_engine(const std::string& ip,
             ssize_t n = ::recvmsg(s, &msg, 0);
 
             if (n < 0) {
-                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                    if (stop.stop_requested()) {
+                        probe.error_msg = "Cancelled";
+                        break;
+                    }
+                    if (std::chrono::steady_clock::now() < deadline)
+                        continue;
                     probe.error_msg = "Timeout";
-                else
+                } else {
                     probe.error_msg = "recvmsg() failed";
+                }
                 break;
             }
 
@@ -357,7 +906,7 @@ PingProbeResult ping_once_engine(const std::string& ip,
                 ntohs(ricmp->un.echo.sequence) != seq)
                 continue;
 
-            auto t_recv = std::chrono::high_resolution_clock::now();
+            auto t_recv = Clock::now();
             probe.rtt_ms = (long)std::chrono::duration_cast<std::chrono::milliseconds>(
                                t_recv - t_send)
                                .count();
@@ -391,86 +940,71 @@ PingProbeResult ping_once_engine(const std::string& ip,
         return probe;
     }
 
-    uint16_t id  = static_cast<uint16_t>(::getpid() & 0xFFFF);
-    uint16_t seq = g_seq.fetch_add(1, std::memory_order_relaxed);
-    Key k{ id, seq };
+    // Shared with the callback: it may still fire after a bounded wait gave up
+    auto pr = std::make_shared<std::promise<PingProbeResult>>();
+    auto fut = pr->get_future();
 
-    std::promise<PingProbeResult> pr;
-    auto fut = pr.get_future();
+    ProbeRequest req;
+    req.addr         = addr;
+    req.timeout_ms   = timeout_ms;
+    req.payload_size = payload_size;
+    req.ttl          = ttl;
+    req.priority     = priority;
+    req.stop         = stop;
 
-    {
-        std::lock_guard<std::mutex> lk(g_mtx);
-        g_waiters.emplace(k, std::move(pr));
-    }
+    bool accepted = submit_probe(req,
+        [pr](const PingProbeResult& r, uint64_t) { pr->set_value(r); },
+        AdmitMode::Block);
 
-    // Build ICMP Echo Request
-    std::vector<unsigned char> packet(sizeof(icmphdr) + sizeof(uint64_t) + payload_size, 0);
-
-    auto* hdr = reinterpret_cast<icmphdr*>(packet.data());
-    hdr->type = ICMP_ECHO;
-    hdr->code = 0;
-    hdr->un.echo.id = htons(id);
-    hdr->un.echo.sequence = htons(seq);
-
-    uint64_t ticks =
-        (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
-            std::chrono::steady_clock::now().time_since_epoch())
-            .count();
-
-    std::memcpy(packet.data() + sizeof(icmphdr), &ticks, sizeof(ticks));
-
-    hdr->checksum = 0;
-    hdr->checksum = checksum16(packet.data(), packet.size());
-
-    // Optional TTL override
-    if (ttl > 0) {
-        ::setsockopt(g_sock, IPPROTO_IP, IP_TTL, &ttl, sizeof(ttl));
-    }
-
-    sockaddr_in dstsa{};
-    dstsa.sin_family = AF_INET;
-    dstsa.sin_addr   = dst;
-
-    auto t_send = std::chrono::high_resolution_clock::now();
-
-    ssize_t sent =
-        ::sendto(g_sock,
-                 packet.data(),
-                 packet.size(),
-                 0,
-                 reinterpret_cast<sockaddr*>(&dstsa),
-                 sizeof(dstsa));
-
-    if (sent < 0) {
-        std::lock_guard<std::mutex> lk(g_mtx);
-        g_waiters.erase(k);
-        probe.error_msg = "sendto() failed";
+    if (!accepted) {
+        probe.error_msg = stop.stop_requested() ? "Cancelled" : "Engine not running";
         return probe;
     }
 
-    // Await response
-    if (fut.wait_for(std::chrono::milliseconds(timeout_ms)) ==
-        std::future_status::ready)
-    {
-        probe = fut.get();
-
-        auto t_recv = std::chrono::high_resolution_clock::now();
-        probe.rtt_ms =
-            (long)std::chrono::duration_cast<std::chrono::milliseconds>(
-                t_recv - t_send)
-                .count();
-
+    // The listener completes every probe (reply, timeout or shutdown); the
+    // bound only guards against a completion that never comes
+    const auto limit = std::chrono::milliseconds(std::max(timeout_ms, 0) + kResultGraceMs);
+    if (fut.wait_for(limit) != std::future_status::ready) {
+        probe.error_msg = "Timeout";
         return probe;
     }
+    return fut.get();
+}
 
-    // Timeout: cleanup
-    {
-        std::lock_guard<std::mutex> lk(g_mtx);
-        g_waiters.erase(k);
+CollectResult ping_collect_engine(const Address& addr, int timeout_ms, int payload_size,
+                                  int ttl, std::stop_token stop)
+{
+    // Shared with the callback, which may still run after a timed-out wait
+    auto pr  = std::make_shared<std::promise<CollectResult>>();
+    auto fut = pr->get_future();
+
+    ProbeRequest req;
+    req.addr         = addr;
+    req.timeout_ms   = timeout_ms;
+    req.payload_size = payload_size;
+    req.ttl          = ttl;
+    req.stop         = stop;
+
+    bool accepted = submit_collect(req,
+        [pr](const CollectResult& r, uint64_t) { pr->set_value(r); },
+        AdmitMode::Block);
+
+    if (!accepted) {
+        CollectResult res;
+        res.error_msg = !addr.is_v4() ? "Invalid IP"
+                      : stop.stop_requested() ? "Cancelled" : "Engine not running";
+        return res;
     }
 
-    probe.error_msg = "Timeout";
-    return probe;
+    // Ends at the deadline (or on cancel / shutdown); the grace only
+    // guards against a completion that never comes
+    const auto limit = std::chrono::milliseconds(std::max(timeout_ms, 0) + kResultGraceMs);
+    if (fut.wait_for(limit) != std::future_status::ready) {
+        CollectResult res;
+        res.error_msg = "Timeout";
+        return res;
+    }
+    return fut.get();
 }
 
 
@@ -481,6 +1015,18 @@ bool engine_available() {
     return g_running.load();
 }
 
+EngineStats engine_stats() {
+    // Catch drops the listener has not sampled yet
+    if (g_sock >= 0)
+        sample_drops(g_sock);
+
+    EngineStats st;
+    st.rx_dropped   = g_rx_dropped.load();
+    st.rcvbuf_bytes = g_rcvbuf.load();
+    st.rcvbuf_grows = g_rcvbuf_grows.load();
+    return st;
+}
+
 } // namespace cping
 
 #endif // __linux__
@@ -2,6 +2,8 @@
 #include <fstream>
 #include <algorithm>
 #include <cmath>
+#include <cstdio>
+#include <string_view>
 
 using namespace cping;
 
@@ -12,7 +14,7 @@ using namespace cping;
  * of the human-readable summary printer.
  */
 static void compute_stats_from_probes(
-    const std::vector<PingProbeResult>& probes,
+    const ProbeLog& probes,
     int& received, long& min_rtt, long& max_rtt,
     long& sum_rtt, double& avg,
     double& median, double& stddev, double& jitter)
@@ -22,7 +24,7 @@ static void compute_stats_from_probes(
     max_rtt = std::numeric_limits<long>::min();
     sum_rtt = 0;
 
-    std::vector<long> rtts;
+    std::pmr::vector<long> rtts(probes.get_allocator());
     rtts.reserve(probes.size());
 
     for (const auto& p : probes) {
@@ -73,7 +75,7 @@ static void compute_stats_from_probes(
  */
 static void compute_stats_from_series(
     int received, long min_rtt, long max_rtt,
-    long sum_rtt, const std::vector<long>& rtts,
+    long sum_rtt, std::span<const long> rtts,
     double& avg, double& median,
     double& stddev, double& jitter)
 {
@@ -89,7 +91,7 @@ static void compute_stats_from_series(
 
     median = 0.0;
     if (!rtts.empty()) {
-        auto sorted = rtts;
+        std::vector<long> sorted(rtts.begin(), rtts.end());
         std::sort(sorted.begin(), sorted.end());
         median = (sorted.size() % 2 == 0)
             ? (sorted[sorted.size() / 2 - 1] + sorted[sorted.size() / 2]) / 2.0
@@ -127,13 +129,62 @@ static void write_csv_row(
 }
 
 
+/**
+ * Quote a CSV field when it holds a separator, quote or line break
+ * (RFC 4180: embedded quotes are doubled).
+ */
+static void write_csv_field(std::ofstream& f, std::string_view s) {
+    if (s.find_first_of(",\"\r\n") == std::string_view::npos) {
+        f << s;
+        return;
+    }
+    f << '"';
+    for (char c : s) {
+        if (c == '"') f << '"';
+        f << c;
+    }
+    f << '"';
+}
+
+
+// ------------------------------------------------------------
+// JSON Support
+// ------------------------------------------------------------
+
+/**
+ * Write `s` as a JSON string literal: quotes, backslashes and control
+ * characters are escaped; other bytes pass through unchanged.
+ */
+static void write_json_string(std::ofstream& f, std::string_view s) {
+    f << '"';
+    for (char c : s) {
+        switch (c) {
+        case '"':  f << "\\\""; break;
+        case '\\': f << "\\\\"; break;
+        case '\n': f << "\\n";  break;
+        case '\r': f << "\\r";  break;
+        case '\t': f << "\\t";  break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(c));
+                f << buf;
+            } else {
+                f << c;
+            }
+        }
+    }
+    f << '"';
+}
+
+
 // ------------------------------------------------------------
 // Summary export — single run (non continuous)
 // ------------------------------------------------------------
 
 bool export_summary(const std::string& path, ExportFormat fmt,
                     const std::string& ip, int sent,
-                    const std::vector<PingProbeResult>& probes,
+                    const ProbeLog& probes,
                     bool append)
 {
     int received = 0;
@@ -158,8 +209,9 @@ bool export_summary(const std::string& path, ExportFormat fmt,
     }
 
     // JSON output
-    f << "{"
-      << "\"host\":\"" << ip << "\","
+    f << "{\"host\":";
+    write_json_string(f, ip);
+    f << ","
       << "\"sent\":" << sent << ","
       << "\"received\":" << received << ","
       << "\"loss\":" << loss << ","
@@ -183,7 +235,7 @@ bool export_summary(const std::string& path, ExportFormat fmt,
 bool export_summary_continuous(const std::string& path, ExportFormat fmt,
                                const std::string& ip, int sent, int received,
                                long minv, long maxv, long sum,
-                               const std::vector<long>& rtts,
+                               std::span<const long> rtts,
                                bool append)
 {
     int loss = sent > 0 ? (100 - (received * 100 / sent)) : 100;
@@ -204,8 +256,9 @@ bool export_summary_continuous(const std::string& path, ExportFormat fmt,
     }
 
     // JSON output
-    f << "{"
-      << "\"host\":\"" << ip << "\","
+    f << "{\"host\":";
+    write_json_string(f, ip);
+    f << ","
       << "\"sent\":" << sent << ","
       << "\"received\":" << received << ","
       << "\"loss\":" << loss << ","
@@ -250,3 +303,52 @@ bool export_probes_csv(const std::string& path,
     }
     return true;
 }
+
+
+// ------------------------------------------------------------
+// Group rollups (multi-target monitor)
+// ------------------------------------------------------------
+
+bool export_groups(const std::string& path, ExportFormat fmt,
+                   const std::vector<GroupSummary>& groups,
+                   bool append)
+{
+    std::ofstream f(path, std::ios::out |
+                            (append ? std::ios::app : std::ios::trunc));
+    if (!f) return false;
+
+    if (fmt == ExportFormat::CSV) {
+        if (!append)
+            f << "group,members,sent,received,loss,min_us,avg_us,p50_us,p90_us,p99_us,max_us\n";
+
+        for (const auto& g : groups) {
+            write_csv_field(f, g.name);
+            f << "," << g.members << "," << g.sent << ","
+              << g.received << "," << g.loss_pct << ","
+              << g.min_us << "," << g.mean_us << "," << g.p50_us << ","
+              << g.p90_us << "," << g.p99_us << "," << g.max_us << "\n";
+        }
+        return true;
+    }
+
+    // JSON output (one object per line)
+    for (const auto& g : groups) {
+        f << "{\"group\":";
+        write_json_string(f, g.name);
+        f << ","
+          << "\"members\":" << g.members << ","
+          << "\"sent\":" << g.sent << ","
+          << "\"received\":" << g.received << ","
+          << "\"loss\":" << g.loss_pct << ","
+          << "\"rtt_us\":{"
+            << "\"min\":" << g.min_us << ","
+            << "\"avg\":" << g.mean_us << ","
+            << "\"p50\":" << g.p50_us << ","
+            << "\"p90\":" << g.p90_us << ","
+            << "\"p99\":" << g.p99_us << ","
+            << "\"max\":" << g.max_us
+          << "}"
+          << "}\n";
+    }
+    return true;
+}
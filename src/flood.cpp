@@ -0,0 +1,181 @@
+/**
+ * Flood mode: AIMD window of outstanding probes over the async engine.
+ */
+
+#include "cping/flood.hpp"
+#include "cping/engine.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+namespace cping {
+
+namespace {
+
+/**
+ * Window state shared with the completion callbacks. Held by shared_ptr
+ * so a probe completing after run_flood() gave up waiting stays safe.
+ */
+struct FloodState {
+    std::mutex mtx;
+    std::condition_variable cv;
+
+    double   cwnd{1};
+    double   ssthresh{1e9};
+    int      min_window{1};
+    int      max_window{1};
+    double   decrease{0.5};
+    int      peak{0};
+
+    int      inflight{0};
+    uint64_t sent{0};
+    uint64_t received{0};
+    uint64_t lost{0};
+    uint64_t recover_seq{0};    // Losses of probes sent before this are one event
+
+    LatencyHistogram latency;
+
+    void on_done(const PingProbeResult& probe, uint64_t seq) {
+        std::lock_guard<std::mutex> lk(mtx);
+        --inflight;
+
+        if (probe.success) {
+            ++received;
+            long us = probe.rtt_us >= 0 ? probe.rtt_us : probe.rtt_ms * 1000L;
+            latency.record(static_cast<uint64_t>(us > 0 ? us : 0));
+
+            cwnd += (cwnd < ssthresh) ? 1.0 : 1.0 / cwnd;
+        } else {
+            ++lost;
+            if (seq >= recover_seq) {
+                ssthresh    = std::max<double>(min_window, cwnd * decrease);
+                cwnd        = ssthresh;
+                recover_seq = sent;
+            }
+        }
+
+        cwnd = std::clamp<double>(cwnd, min_window, max_window);
+        peak = std::max(peak, static_cast<int>(cwnd));
+        cv.notify_one();
+    }
+};
+
+} // namespace
+
+
+FloodStats run_flood(const FloodOptions& opt, const std::atomic<bool>* keep_running) {
+    FloodStats stats;
+
+    // Parsed once: the send loop only copies 17-byte addresses. A target
+    // the engine cannot probe would fail every send and read as loss.
+    std::vector<Address> targets;
+    targets.reserve(opt.targets.size());
+    for (const auto& ip : opt.targets) {
+        auto a = Address::parse(ip);
+        if (a && a->is_v4())
+            targets.push_back(*a);
+        else
+            ++stats.invalid_targets;
+    }
+
+    if (targets.empty() || !engine_available())
+        return stats;
+
+    auto st = std::make_shared<FloodState>();
+    st->min_window = std::max(1, opt.min_window);
+    st->max_window = std::max(st->min_window, opt.max_window);
+    st->decrease   = std::clamp(opt.decrease, 0.05, 0.95);
+    st->cwnd       = std::clamp(opt.initial_window, st->min_window, st->max_window);
+    st->peak       = static_cast<int>(st->cwnd);
+
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    const auto end   = opt.duration_ms > 0
+        ? start + std::chrono::milliseconds(opt.duration_ms)
+        : Clock::time_point::max();
+
+    ProbeRequest req;
+    req.timeout_ms   = opt.timeout_ms;
+    req.payload_size = opt.payload_size;
+    req.priority     = opt.priority;
+
+    size_t next_target = 0;
+
+    // ---------------------------------------------------------------------
+    // Sending phase: fill the window, wait for room, repeat
+    // ---------------------------------------------------------------------
+    for (;;) {
+        if (keep_running && !keep_running->load())
+            break;
+        if (Clock::now() >= end)
+            break;
+
+        uint64_t seq;
+        {
+            std::unique_lock<std::mutex> lk(st->mtx);
+            if (opt.max_probes && st->sent >= opt.max_probes)
+                break;
+
+            // Bounded wait so duration / keep_running are honoured
+            st->cv.wait_for(lk, std::chrono::milliseconds(10), [&] {
+                return st->inflight < static_cast<int>(st->cwnd);
+            });
+            if (st->inflight >= static_cast<int>(st->cwnd))
+                continue;
+
+            seq = st->sent++;
+            ++st->inflight;
+        }
+
+        req.addr = targets[next_target];
+        req.tag  = seq;
+        if (++next_target == targets.size()) next_target = 0;
+
+        bool accepted = submit_probe(req,
+            [st](const PingProbeResult& probe, uint64_t tag) {
+                st->on_done(probe, tag);
+            },
+            AdmitMode::Block);
+
+        if (!accepted) {
+            PingProbeResult probe{};
+            probe.error_msg = "Probe not accepted";
+            st->on_done(probe, seq);
+            if (!engine_available())
+                break;
+        }
+    }
+
+    const auto send_end = Clock::now();
+
+    // ---------------------------------------------------------------------
+    // Drain: every accepted probe completes by its deadline
+    // ---------------------------------------------------------------------
+    {
+        std::unique_lock<std::mutex> lk(st->mtx);
+        st->cv.wait_for(lk, std::chrono::milliseconds(opt.timeout_ms + 100),
+                        [&] { return st->inflight == 0; });
+
+        stats.sent         = st->sent;
+        stats.received     = st->received;
+        stats.lost         = st->lost;
+        stats.final_window = static_cast<int>(st->cwnd);
+        stats.peak_window  = st->peak;
+        stats.latency      = st->latency;
+    }
+
+    stats.elapsed_s = std::chrono::duration<double>(send_end - start).count();
+    if (stats.elapsed_s > 0) {
+        stats.send_pps  = stats.sent / stats.elapsed_s;
+        stats.reply_pps = stats.received / stats.elapsed_s;
+    }
+    if (stats.sent)
+        stats.loss_pct = 100.0 * double(stats.sent - stats.received) / double(stats.sent);
+
+    return stats;
+}
+
+} // namespace cping
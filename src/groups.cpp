@@ -0,0 +1,213 @@
+/**
+ * Group rollups over a TargetTable.
+ *
+ * Each completion touches only the target's membership slots and the
+ * matching accumulators; no per-target history is retained here.
+ */
+
+#include "cping/groups.hpp"
+#include "cping/prefix_trie.hpp"
+
+#include <sstream>
+
+namespace cping {
+
+// ============================================================================
+// Load-time mapping
+// ============================================================================
+GroupId GroupIndex::group(const std::string& name) {
+    std::lock_guard<std::mutex> lk(mtx_);
+
+    auto it = by_name_.find(name);
+    if (it != by_name_.end())
+        return it->second;
+
+    GroupId id = static_cast<GroupId>(groups_.size());
+    groups_.push_back(Accumulator{});
+    groups_.back().name = name;
+    by_name_.emplace(name, id);
+    return id;
+}
+
+bool GroupIndex::assign(TargetId target, GroupId g) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (g >= groups_.size())
+        return false;
+
+    const size_t base = size_t(target) * kMaxMemberships;
+    if (membership_.size() < base + kMaxMemberships)
+        membership_.resize(base + kMaxMemberships, kNoGroup);
+
+    for (int i = 0; i < kMaxMemberships; ++i) {
+        GroupId& slot = membership_[base + i];
+        if (slot == g) return true;          // already a member
+        if (slot == kNoGroup) {
+            slot = g;
+            ++groups_[g].members;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string GroupIndex::prefix_name(const TargetTable& table, TargetId target) {
+    const auto& a = table.raw_address(target);
+    std::ostringstream os;
+
+    if (table.is_v4(target)) {
+        os << int(a[12]) << '.' << int(a[13]) << '.' << int(a[14]) << ".0/24";
+    } else {
+        os << std::hex;
+        for (int i = 0; i < 8; i += 2)
+            os << ((a[i] << 8) | a[i + 1]) << ':';
+        os << ":/64";
+    }
+    return os.str();
+}
+
+void GroupIndex::assign_prefixes(const TargetTable& table) {
+    for (TargetId t = 0; t < table.size(); ++t)
+        assign(t, group(prefix_name(table, t)));
+}
+
+void GroupIndex::assign_matches(const TargetTable& table, const PrefixTrie& trie) {
+    for (TargetId t = 0; t < table.size(); ++t) {
+        const uint32_t g = trie.lookup(table.addr(t));
+        if (g != PrefixTrie::kNoValue)
+            assign(t, g);
+    }
+}
+
+
+// ============================================================================
+// Completion path
+// ============================================================================
+void GroupIndex::record(TargetId target, const PingProbeResult& probe) {
+    const size_t base = size_t(target) * kMaxMemberships;
+
+    long us = probe.rtt_us >= 0 ? probe.rtt_us
+            : probe.rtt_ms >= 0 ? probe.rtt_ms * 1000L
+            : 0;
+
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (membership_.size() < base + kMaxMemberships)
+        return;                              // target not in any group
+
+    for (int i = 0; i < kMaxMemberships; ++i) {
+        GroupId g = membership_[base + i];
+        if (g == kNoGroup) break;
+
+        auto& acc = groups_[g];
+        ++acc.sent;
+        if (probe.success) {
+            ++acc.received;
+            acc.hist.record(static_cast<uint64_t>(us > 0 ? us : 0));
+        }
+    }
+}
+
+
+void GroupIndex::merge(GroupId g, uint64_t sent, uint64_t received,
+                       const LatencyHistogram& hist)
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (g >= groups_.size())
+        return;
+
+    auto& acc = groups_[g];
+    acc.sent     += sent;
+    acc.received += received;
+    acc.hist.merge(hist);
+}
+
+
+// ============================================================================
+// Rollup reads (O(groups))
+// ============================================================================
+GroupSummary GroupIndex::summarize(const Accumulator& acc) const {
+    GroupSummary s;
+    s.name     = acc.name;
+    s.members  = acc.members;
+    s.sent     = acc.sent;
+    s.received = acc.received;
+    s.loss_pct = acc.sent ? 100.0 * double(acc.sent - acc.received) / double(acc.sent) : 0.0;
+    s.min_us   = acc.hist.min_us();
+    s.mean_us  = acc.hist.mean_us();
+    s.p50_us   = acc.hist.percentile_us(50);
+    s.p90_us   = acc.hist.percentile_us(90);
+    s.p99_us   = acc.hist.percentile_us(99);
+    s.max_us   = acc.hist.max_us();
+    return s;
+}
+
+size_t GroupIndex::group_count() const {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return groups_.size();
+}
+
+GroupSummary GroupIndex::summary(GroupId g) const {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return g < groups_.size() ? summarize(groups_[g]) : GroupSummary{};
+}
+
+std::vector<GroupSummary> GroupIndex::summaries() const {
+    std::lock_guard<std::mutex> lk(mtx_);
+    std::vector<GroupSummary> out;
+    out.reserve(groups_.size());
+    for (const auto& acc : groups_)
+        out.push_back(summarize(acc));
+    return out;
+}
+
+LatencyHistogram GroupIndex::histogram(GroupId g) const {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return g < groups_.size() ? groups_[g].hist : LatencyHistogram{};
+}
+
+
+// ============================================================================
+// Target list loader
+// ============================================================================
+size_t load_target_list(std::istream& in, TargetTable& table, GroupIndex* groups,
+                        const PrefixTrie* exclude, size_t* unsupported)
+{
+    size_t added = 0;
+    std::string line;
+
+    while (std::getline(in, line)) {
+        auto hash = line.find('#');
+        if (hash != std::string::npos)
+            line.erase(hash);
+
+        std::istringstream fields(line);
+        std::string ip;
+        if (!(fields >> ip))
+            continue;
+
+        auto addr = Address::parse(ip);
+        if (!addr || (exclude && exclude->contains(*addr)))
+            continue;
+        if (!addr->is_v4()) {
+            if (unsupported) ++*unsupported;
+            continue;
+        }
+
+        TargetId id = table.add(*addr);
+        if (id == kInvalidTarget)
+            continue;
+        ++added;
+
+        if (!groups)
+            continue;
+
+        groups->assign(id, groups->group(GroupIndex::prefix_name(table, id)));
+
+        std::string label;
+        while (fields >> label)
+            groups->assign(id, groups->group(label));
+    }
+
+    return added;
+}
+
+} // namespace cping
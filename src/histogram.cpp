@@ -0,0 +1,139 @@
+/**
+ * Log-linear RTT histogram.
+ *
+ * Bucket index layout (kSubBits = 3):
+ *   idx  0..7    -> values 0..7 us (exact)
+ *   idx  8..15   -> [8, 16)   in steps of 1 us
+ *   idx 16..23   -> [16, 32)  in steps of 2 us
+ *   ...          -> each octave split into 8 equal sub-buckets
+ */
+
+#include "cping/histogram.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace cping {
+
+int LatencyHistogram::bucket_of(uint64_t us) {
+    if (us > kMaxValueUs) us = kMaxValueUs;
+    if (us < static_cast<uint64_t>(kSubBuckets))
+        return static_cast<int>(us);
+
+    const int e   = std::bit_width(us) - 1;                 // floor(log2(us))
+    const int sub = static_cast<int>((us >> (e - kSubBits)) & (kSubBuckets - 1));
+    return kSubBuckets + (e - kSubBits) * kSubBuckets + sub;
+}
+
+uint64_t LatencyHistogram::bucket_lower(int idx) {
+    if (idx < kSubBuckets)
+        return static_cast<uint64_t>(idx);
+
+    const int e   = kSubBits + (idx - kSubBuckets) / kSubBuckets;
+    const int sub = (idx - kSubBuckets) % kSubBuckets;
+    return static_cast<uint64_t>(kSubBuckets + sub) << (e - kSubBits);
+}
+
+uint64_t LatencyHistogram::bucket_width(int idx) {
+    if (idx < kSubBuckets)
+        return 1;
+    const int e = kSubBits + (idx - kSubBuckets) / kSubBuckets;
+    return uint64_t(1) << (e - kSubBits);
+}
+
+void LatencyHistogram::record(uint64_t us, uint32_t n) {
+    if (n == 0) return;
+    if (us > kMaxValueUs) us = kMaxValueUs;
+
+    counts_[bucket_of(us)] += n;
+
+    if (count_ == 0) {
+        min_ = max_ = us;
+    } else {
+        min_ = std::min(min_, us);
+        max_ = std::max(max_, us);
+    }
+    count_ += n;
+    sum_   += us * n;
+}
+
+void LatencyHistogram::record_corrected(uint64_t us, uint64_t expected_interval_us) {
+    record(us);
+    if (expected_interval_us == 0 || us <= expected_interval_us)
+        return;
+
+    if (us > kMaxValueUs) us = kMaxValueUs;
+    for (uint64_t missing = us - expected_interval_us;
+         missing >= expected_interval_us;
+         missing -= expected_interval_us)
+    {
+        record(missing);
+    }
+}
+
+void LatencyHistogram::add_bucket(int idx, uint32_t n) {
+    if (idx < 0 || idx >= kBuckets || n == 0) return;
+
+    // Bucket-only data: bound min/max by the bucket edges
+    const uint64_t lo = bucket_lower(idx);
+    const uint64_t hi = lo + bucket_width(idx) - 1;
+
+    counts_[idx] += n;
+    if (count_ == 0) {
+        min_ = lo;
+        max_ = hi;
+    } else {
+        min_ = std::min(min_, lo);
+        max_ = std::max(max_, hi);
+    }
+    count_ += n;
+    sum_   += (lo + bucket_width(idx) / 2) * n;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    if (other.count_ == 0) return;
+
+    for (int i = 0; i < kBuckets; ++i)
+        counts_[i] += other.counts_[i];
+
+    if (count_ == 0) {
+        min_ = other.min_;
+        max_ = other.max_;
+    } else {
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+    }
+    count_ += other.count_;
+    sum_   += other.sum_;
+}
+
+void LatencyHistogram::clear() {
+    counts_.fill(0);
+    count_ = sum_ = min_ = max_ = 0;
+}
+
+double LatencyHistogram::mean_us() const {
+    return count_ ? static_cast<double>(sum_) / count_ : 0.0;
+}
+
+uint64_t LatencyHistogram::percentile_us(double p) const {
+    if (count_ == 0) return 0;
+
+    p = std::clamp(p, 0.0, 100.0);
+
+    // Rank of the requested sample (1-based, nearest-rank method)
+    uint64_t rank = static_cast<uint64_t>(p / 100.0 * count_ + 0.5);
+    rank = std::clamp<uint64_t>(rank, 1, count_);
+
+    uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+        seen += counts_[i];
+        if (seen >= rank) {
+            uint64_t mid = bucket_lower(i) + bucket_width(i) / 2;
+            return std::clamp(mid, min_, max_);
+        }
+    }
+    return max_;
+}
+
+} // namespace cping
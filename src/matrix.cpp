@@ -0,0 +1,329 @@
+/**
+ * Reachability matrix: sources x targets over one engine socket.
+ */
+
+#include "cping/matrix.hpp"
+#include "cping/engine.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <istream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+
+#if !defined(_WIN32)
+  #include <net/if.h>
+#endif
+
+namespace cping {
+
+namespace {
+
+constexpr uint32_t kNoReply = std::numeric_limits<uint32_t>::max();
+
+// Binary format bounds: a header claiming more is corrupt, not a fabric
+constexpr uint64_t kCellBytes  = 7 * sizeof(uint32_t);
+constexpr uint64_t kMaxLabels  = 1u << 24;         // Sources + targets
+constexpr uint64_t kMaxCells   = 1u << 26;         // ~1.8 GB in memory
+
+/**
+ * Per-probe RTT slots filled by the completion callbacks. Held by
+ * shared_ptr so the callbacks never outlive it.
+ */
+struct MatrixState {
+    std::mutex mtx;
+    std::condition_variable cv;
+    size_t outstanding{0};
+    std::vector<uint32_t> rtt_us;       // [cell * probes + round], kNoReply if lost
+
+    void on_done(const PingProbeResult& probe, uint64_t slot) {
+        uint32_t us = kNoReply;
+        if (probe.success) {
+            long v = probe.rtt_us >= 0 ? probe.rtt_us : probe.rtt_ms * 1000L;
+            us = static_cast<uint32_t>(std::clamp<long>(v, 0, kNoReply - 1));
+        }
+
+        std::lock_guard<std::mutex> lk(mtx);
+        rtt_us[slot] = us;
+        if (--outstanding == 0)
+            cv.notify_all();
+    }
+};
+
+/** Nearest-rank percentile of an ascending sample set. */
+uint32_t rank(const uint32_t* sorted, size_t n, double p) {
+    size_t r = static_cast<size_t>(p / 100.0 * n + 0.5);
+    r = std::clamp<size_t>(r, 1, n);
+    return sorted[r - 1];
+}
+
+// Little-endian integer I/O for the binary format
+void put_u16(std::ostream& out, uint16_t v) {
+    char b[2] = { char(v & 0xFF), char(v >> 8) };
+    out.write(b, 2);
+}
+
+void put_u32(std::ostream& out, uint32_t v) {
+    char b[4] = { char(v & 0xFF), char((v >> 8) & 0xFF),
+                  char((v >> 16) & 0xFF), char(v >> 24) };
+    out.write(b, 4);
+}
+
+bool get_u16(std::istream& in, uint16_t& v) {
+    unsigned char b[2];
+    if (!in.read(reinterpret_cast<char*>(b), 2)) return false;
+    v = static_cast<uint16_t>(b[0] | (b[1] << 8));
+    return true;
+}
+
+bool get_u32(std::istream& in, uint32_t& v) {
+    unsigned char b[4];
+    if (!in.read(reinterpret_cast<char*>(b), 4)) return false;
+    v = uint32_t(b[0]) | (uint32_t(b[1]) << 8) | (uint32_t(b[2]) << 16) | (uint32_t(b[3]) << 24);
+    return true;
+}
+
+void put_label(std::ostream& out, const std::string& s) {
+    const uint16_t n = static_cast<uint16_t>(std::min<size_t>(s.size(), 0xFFFF));
+    put_u16(out, n);
+    out.write(s.data(), n);
+}
+
+bool get_label(std::istream& in, std::string& s) {
+    uint16_t n;
+    if (!get_u16(in, n)) return false;
+    s.resize(n);
+    return n == 0 || static_cast<bool>(in.read(s.data(), n));
+}
+
+/** Bytes left in a seekable stream, -1 when it cannot tell. */
+int64_t bytes_left(std::istream& in) {
+    const auto here = in.tellg();
+    if (here < 0 || !in.seekg(0, std::ios::end)) {
+        in.clear();
+        return -1;
+    }
+    const auto end = in.tellg();
+    in.seekg(here);
+    return end < here ? -1 : static_cast<int64_t>(end - here);
+}
+
+} // namespace
+
+
+// ============================================================================
+// Sources
+// ============================================================================
+bool parse_matrix_source(const std::string& spec, MatrixSource& out) {
+    out = MatrixSource{};
+    out.label = spec;
+
+    if (auto a = Address::parse(spec)) {
+        if (!a->is_v4()) return false;
+        out.addr = *a;
+        return true;
+    }
+
+#if defined(_WIN32)
+    return false;       // Per-packet source selection is Linux-only
+#else
+    out.if_index = ::if_nametoindex(spec.c_str());
+    return out.if_index != 0;
+#endif
+}
+
+
+// ============================================================================
+// Run
+// ============================================================================
+ReachabilityMatrix run_matrix(const std::vector<MatrixSource>& sources,
+                              const std::vector<Address>& targets,
+                              const MatrixOptions& opt,
+                              const std::atomic<bool>* keep_running)
+{
+    ReachabilityMatrix m;
+    for (const auto& s : sources) m.sources.push_back(s.label);
+    for (const auto& t : targets) m.targets.push_back(t.to_string());
+    m.cells.resize(sources.size() * targets.size());
+
+    const int probes = std::max(1, opt.probes);
+    if (m.cells.empty() || !engine_available())
+        return m;
+
+    auto st = std::make_shared<MatrixState>();
+    st->rtt_us.assign(m.cells.size() * probes, kNoReply);
+
+    using Clock = std::chrono::steady_clock;
+    const auto step = opt.rate_pps > 0
+        ? std::chrono::duration_cast<Clock::duration>(std::chrono::seconds(1)) / opt.rate_pps
+        : Clock::duration::zero();
+    auto next = Clock::now();
+
+    ProbeRequest req;
+    req.timeout_ms   = opt.timeout_ms;
+    req.payload_size = opt.payload_size;
+    req.ttl          = opt.ttl;
+    req.priority     = opt.priority;
+
+    // ---------------------------------------------------------------------
+    // Sending phase: round by round, every pair once per round
+    // ---------------------------------------------------------------------
+    bool stopped = false;
+    for (int round = 0; round < probes && !stopped; ++round) {
+        for (size_t s = 0; s < sources.size() && !stopped; ++s) {
+            req.source   = sources[s].addr;
+            req.if_index = sources[s].if_index;
+
+            for (size_t t = 0; t < targets.size(); ++t) {
+                if (keep_running && !keep_running->load()) {
+                    stopped = true;
+                    break;
+                }
+
+                // Pace in >= 1 ms batches rather than sleeping per packet
+                if (step != Clock::duration::zero()) {
+                    if (next - Clock::now() >= std::chrono::milliseconds(1))
+                        std::this_thread::sleep_until(next);
+                    next += step;
+                }
+
+                const size_t cell = s * targets.size() + t;
+                const size_t slot = cell * probes + round;
+                ++m.cells[cell].sent;
+
+                req.addr = targets[t];
+                req.tag  = slot;
+
+                {
+                    std::lock_guard<std::mutex> lk(st->mtx);
+                    ++st->outstanding;
+                }
+
+                bool accepted = submit_probe(req,
+                    [st](const PingProbeResult& probe, uint64_t tag) {
+                        st->on_done(probe, tag);
+                    },
+                    AdmitMode::Block);
+
+                // Rejected (bad source, engine stopping): counts as lost
+                if (!accepted)
+                    st->on_done(PingProbeResult{}, slot);
+            }
+        }
+    }
+
+    // Every accepted probe completes: reply, timeout or engine shutdown
+    {
+        std::unique_lock<std::mutex> lk(st->mtx);
+        st->cv.wait(lk, [&] { return st->outstanding == 0; });
+    }
+
+    // ---------------------------------------------------------------------
+    // Per-cell statistics
+    // ---------------------------------------------------------------------
+    std::vector<uint32_t> ok;
+    ok.reserve(probes);
+
+    for (size_t c = 0; c < m.cells.size(); ++c) {
+        ok.clear();
+        for (int r = 0; r < probes; ++r) {
+            uint32_t us = st->rtt_us[c * probes + r];
+            if (us != kNoReply) ok.push_back(us);
+        }
+
+        MatrixCell& cell = m.cells[c];
+        cell.received = static_cast<uint32_t>(ok.size());
+        if (ok.empty()) continue;
+
+        std::sort(ok.begin(), ok.end());
+        cell.min_us = ok.front();
+        cell.max_us = ok.back();
+        cell.p50_us = rank(ok.data(), ok.size(), 50);
+        cell.p90_us = rank(ok.data(), ok.size(), 90);
+        cell.p99_us = rank(ok.data(), ok.size(), 99);
+    }
+
+    return m;
+}
+
+
+// ============================================================================
+// Output
+// ============================================================================
+bool write_matrix_csv(const ReachabilityMatrix& m, std::ostream& out) {
+    out << "source,target,sent,received,loss_pct,min_us,p50_us,p90_us,p99_us,max_us\n";
+
+    for (size_t s = 0; s < m.sources.size(); ++s) {
+        for (size_t t = 0; t < m.targets.size(); ++t) {
+            const MatrixCell& c = m.at(s, t);
+            out << m.sources[s] << ',' << m.targets[t] << ','
+                << c.sent << ',' << c.received << ',' << c.loss_pct() << ','
+                << c.min_us << ',' << c.p50_us << ',' << c.p90_us << ','
+                << c.p99_us << ',' << c.max_us << '\n';
+        }
+    }
+    return static_cast<bool>(out);
+}
+
+bool write_matrix_binary(const ReachabilityMatrix& m, std::ostream& out) {
+    out.write("CPMX", 4);
+    put_u16(out, 1);
+    put_u16(out, 0);
+    put_u32(out, static_cast<uint32_t>(m.sources.size()));
+    put_u32(out, static_cast<uint32_t>(m.targets.size()));
+
+    for (const auto& s : m.sources) put_label(out, s);
+    for (const auto& t : m.targets) put_label(out, t);
+
+    for (const auto& c : m.cells) {
+        put_u32(out, c.sent);
+        put_u32(out, c.received);
+        put_u32(out, c.min_us);
+        put_u32(out, c.p50_us);
+        put_u32(out, c.p90_us);
+        put_u32(out, c.p99_us);
+        put_u32(out, c.max_us);
+    }
+    return static_cast<bool>(out);
+}
+
+bool read_matrix_binary(std::istream& in, ReachabilityMatrix& m) {
+    m = ReachabilityMatrix{};
+
+    char magic[4];
+    uint16_t version, reserved;
+    uint32_t ns, nt;
+    if (!in.read(magic, 4) || std::string(magic, 4) != "CPMX") return false;
+    if (!get_u16(in, version) || version != 1 || !get_u16(in, reserved)) return false;
+    if (!get_u32(in, ns) || !get_u32(in, nt)) return false;
+
+    // Validate the claimed shape before allocating for it: both counts
+    // are below 2^32, so their product cannot overflow 64 bits
+    const uint64_t cells = uint64_t(ns) * nt;
+    if (uint64_t(ns) + nt > kMaxLabels || cells > kMaxCells) return false;
+
+    const int64_t left = bytes_left(in);
+    if (left >= 0 && uint64_t(left) < (uint64_t(ns) + nt) * 2 + cells * kCellBytes)
+        return false;
+
+    m.sources.resize(ns);
+    m.targets.resize(nt);
+    for (auto& s : m.sources) if (!get_label(in, s)) return false;
+    for (auto& t : m.targets) if (!get_label(in, t)) return false;
+
+    m.cells.resize(static_cast<size_t>(cells));
+    for (auto& c : m.cells) {
+        if (!get_u32(in, c.sent) || !get_u32(in, c.received) ||
+            !get_u32(in, c.min_us) || !get_u32(in, c.p50_us) ||
+            !get_u32(in, c.p90_us) || !get_u32(in, c.p99_us) ||
+            !get_u32(in, c.max_us))
+            return false;
+    }
+    return true;
+}
+
+} // namespace cping
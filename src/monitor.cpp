@@ -0,0 +1,146 @@
+/**
+ * Multi-target monitor: TargetTable scheduling driven through the
+ * asynchronous engine API.
+ *
+ * The scheduler thread only touches the table's scheduling columns and
+ * completions only the result columns (see target_table.hpp). Completions
+ * arrive on the listener thread, on whichever thread freed an admission
+ * slot, or inline in tick() for rejected probes; done_mtx_ serialises
+ * them, so results and hooks never run concurrently.
+ */
+
+#include "cping/monitor.hpp"
+#include "cping/engine.hpp"
+
+#include <algorithm>
+#include <thread>
+
+namespace cping {
+
+// Upper bound on a scheduler sleep, so run_for() stays responsive
+static constexpr int64_t kMaxIdleUs = 50'000;
+
+Monitor::Monitor(TargetTable& table, MonitorOptions opt)
+    : table_(table), opt_(opt)
+{
+    if (opt_.interval_ms < 1) opt_.interval_ms = 1;
+    if (opt_.max_batch == 0)  opt_.max_batch = 1;
+}
+
+int64_t Monitor::now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Monitor::add_hook(ResultHook hook) {
+    hooks_.push_back(std::move(hook));
+}
+
+size_t Monitor::tick() {
+    due_.clear();
+    intended_.clear();
+    skipped_.clear();
+    table_.collect_due(now_us(), int64_t(opt_.interval_ms) * 1000,
+                       due_, opt_.max_batch, &intended_, &skipped_);
+
+    ProbeRequest req;
+    req.timeout_ms   = opt_.timeout_ms;
+    req.payload_size = opt_.payload_size;
+    req.ttl          = opt_.ttl;
+    req.priority     = opt_.priority;
+
+    for (size_t i = 0; i < due_.size(); ++i) {
+        const TargetId id    = due_[i];
+        const int64_t  start = intended_[i];
+        const uint32_t skip  = skipped_[i];
+
+        req.addr = table_.addr(id);
+        req.tag  = id;
+
+        outstanding_.fetch_add(1, std::memory_order_relaxed);
+
+        bool accepted = submit_probe(req,
+            [this, start, skip](const PingProbeResult& probe, uint64_t tag) {
+                on_done(static_cast<TargetId>(tag), probe, start, skip);
+            },
+            AdmitMode::Callback);
+
+        // Rejected up front (engine down, unsupported address): count as lost
+        if (!accepted) {
+            PingProbeResult probe{};
+            probe.error_msg = "Probe not accepted";
+            on_done(id, probe, start, skip);
+        }
+    }
+
+    return due_.size();
+}
+
+void Monitor::run_for(std::chrono::milliseconds duration,
+                      const std::atomic<bool>* keep_running)
+{
+    const int64_t end = now_us() + duration.count() * 1000;
+
+    while (now_us() < end && (!keep_running || keep_running->load())) {
+        tick();
+
+        // Sleep until the next target is due (bounded for responsiveness)
+        int64_t now  = now_us();
+        int64_t wake = std::min({ table_.earliest_due(), end, now + kMaxIdleUs });
+        if (wake > now)
+            std::this_thread::sleep_for(std::chrono::microseconds(wake - now));
+    }
+}
+
+bool Monitor::wait_idle(std::chrono::milliseconds max_wait) {
+    const auto until = std::chrono::steady_clock::now() + max_wait;
+    while (outstanding_.load() > 0) {
+        if (std::chrono::steady_clock::now() >= until)
+            return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+LatencyHistogram Monitor::raw_latency() const {
+    std::lock_guard<std::mutex> lk(hist_mtx_);
+    return raw_;
+}
+
+LatencyHistogram Monitor::corrected_latency() const {
+    std::lock_guard<std::mutex> lk(hist_mtx_);
+    return corrected_;
+}
+
+void Monitor::on_done(TargetId id, const PingProbeResult& probe,
+                      int64_t intended_us, uint32_t skipped)
+{
+    std::lock_guard<std::mutex> done(done_mtx_);
+    table_.record(id, probe);
+
+    if (probe.success) {
+        long rtt = probe.rtt_us >= 0 ? probe.rtt_us : probe.rtt_ms * 1000L;
+        int64_t since_intended = now_us() - intended_us;
+        const int64_t interval = int64_t(opt_.interval_ms) * 1000;
+
+        std::lock_guard<std::mutex> lk(hist_mtx_);
+        raw_.record(static_cast<uint64_t>(rtt > 0 ? rtt : 0));
+
+        // Measured from the intended send time, the delay is already in the
+        // sample; only slots the table dropped on re-anchor need back-fill
+        corrected_.record(static_cast<uint64_t>(since_intended > 0 ? since_intended : 0));
+        for (uint32_t k = 1; k <= skipped; ++k) {
+            int64_t filled = since_intended - int64_t(k) * interval;
+            if (filled <= 0) break;
+            corrected_.record(static_cast<uint64_t>(filled));
+        }
+    }
+
+    for (auto& hook : hooks_)
+        hook(id, probe);
+
+    completed_.fetch_add(1, std::memory_order_relaxed);
+    outstanding_.fetch_sub(1, std::memory_order_release);
+}
+
+} // namespace cping
@@ -0,0 +1,259 @@
+/**
+ * Event-compacted outage log.
+ *
+ * The tracker holds one small slot per target; only state transitions
+ * leave the process, as closed intervals with aggregate stats.
+ */
+
+#include "cping/outage_log.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+
+namespace cping {
+
+const char* to_string(TargetState state) {
+    switch (state) {
+    case TargetState::Unknown:  return "unknown";
+    case TargetState::Up:       return "up";
+    case TargetState::Degraded: return "degraded";
+    case TargetState::Down:     return "down";
+    }
+    return "unknown";
+}
+
+static bool parse_state(const std::string& s, TargetState& out) {
+    if (s == "up")       { out = TargetState::Up;       return true; }
+    if (s == "degraded") { out = TargetState::Degraded; return true; }
+    if (s == "down")     { out = TargetState::Down;     return true; }
+    if (s == "unknown")  { out = TargetState::Unknown;  return true; }
+    return false;
+}
+
+
+// ============================================================================
+// Tracker
+// ============================================================================
+OutageTracker::OutageTracker(const TargetTable& table, OutagePolicy policy,
+                             OutageSink sink)
+    : table_(table), policy_(policy), sink_(std::move(sink)),
+      slots_(table.size())
+{
+    if (policy_.down_after == 0) policy_.down_after = 1;
+    if (policy_.up_after == 0)   policy_.up_after = 1;
+}
+
+int64_t OutageTracker::now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void OutageTracker::observe(TargetId id, const PingProbeResult& probe, int64_t now_ms) {
+    Slot& s = slots_[id];
+    if (s.probes == 0 && s.state == TargetState::Unknown && s.start_ms == 0)
+        s.start_ms = now_ms;
+
+    const float a = static_cast<float>(policy_.alpha);
+
+    ++s.probes;
+    s.loss_rate += a * ((probe.success ? 0.0f : 1.0f) - s.loss_rate);
+
+    if (probe.success) {
+        if (s.ok_run == 0) s.run_start_ms = now_ms;
+        if (s.ok_run < 0xFFFF) ++s.ok_run;
+        s.fail_run = 0;
+
+        long us = probe.rtt_us >= 0 ? probe.rtt_us
+                : probe.rtt_ms >= 0 ? probe.rtt_ms * 1000L
+                : 0;
+        uint32_t r = static_cast<uint32_t>(std::max(0L, us));
+
+        s.rtt_min_us = s.received ? std::min(s.rtt_min_us, r) : r;
+        s.rtt_max_us = std::max(s.rtt_max_us, r);
+        s.rtt_sum_us += r;
+        ++s.received;
+        s.srtt_us = s.srtt_us == 0 ? float(r) : s.srtt_us + a * (float(r) - s.srtt_us);
+    } else {
+        if (s.fail_run == 0) s.run_start_ms = now_ms;
+        if (s.fail_run < 0xFFFF) ++s.fail_run;
+        s.ok_run = 0;
+        ++s.lost;
+    }
+
+    const bool slow = policy_.degraded_rtt_us && s.srtt_us > policy_.degraded_rtt_us;
+    const bool lossy = s.loss_rate >= policy_.degraded_loss;
+
+    switch (s.state) {
+    case TargetState::Unknown:
+        if (s.fail_run >= policy_.down_after)
+            transition(id, s, TargetState::Down, s.run_start_ms, s.fail_run);
+        else if (probe.success)
+            transition(id, s, TargetState::Up, now_ms);
+        break;
+
+    case TargetState::Up:
+        if (s.fail_run >= policy_.down_after)
+            transition(id, s, TargetState::Down, s.run_start_ms, s.fail_run);
+        else if (lossy || slow)
+            transition(id, s, TargetState::Degraded, now_ms);
+        break;
+
+    case TargetState::Degraded:
+        if (s.fail_run >= policy_.down_after)
+            transition(id, s, TargetState::Down, s.run_start_ms, s.fail_run);
+        else if (probe.success && !slow && s.loss_rate < policy_.degraded_loss / 2)
+            transition(id, s, TargetState::Up, now_ms);
+        break;
+
+    case TargetState::Down:
+        if (s.ok_run >= policy_.up_after) {
+            s.loss_rate = 0;   // fresh start after recovery
+            transition(id, s, TargetState::Up, s.run_start_ms);
+        }
+        break;
+    }
+}
+
+OutageRecord OutageTracker::close(TargetId id, const Slot& s, int64_t end_ms) const {
+    OutageRecord r;
+    r.target     = table_.address(id);
+    r.state      = s.state;
+    r.start_ms   = s.start_ms;
+    r.end_ms     = std::max(end_ms, s.start_ms);
+    r.probes     = s.probes;
+    r.lost       = s.lost;
+    r.rtt_min_us = s.rtt_min_us;
+    r.rtt_avg_us = s.received ? static_cast<uint32_t>(s.rtt_sum_us / s.received) : 0;
+    r.rtt_max_us = s.rtt_max_us;
+    return r;
+}
+
+void OutageTracker::transition(TargetId id, Slot& s, TargetState next, int64_t at_ms,
+                               uint32_t carried_losses)
+{
+    if (s.state == next)
+        return;
+
+    // Zero-length intervals (e.g. Unknown -> Up on the first reply) carry
+    // no time: relabel them and keep their probes in the new interval
+    if (at_ms <= s.start_ms) {
+        s.state = next;
+        return;
+    }
+
+    // The losses that confirmed a backdated Down happened inside it
+    carried_losses = std::min({ carried_losses, s.probes, s.lost });
+    s.probes -= carried_losses;
+    s.lost   -= carried_losses;
+
+    if (sink_)
+        sink_(close(id, s, at_ms));
+
+    s.state      = next;
+    s.start_ms   = at_ms;
+    s.probes     = carried_losses;
+    s.lost       = carried_losses;
+    s.received   = 0;
+    s.rtt_sum_us = 0;
+    s.rtt_min_us = 0;
+    s.rtt_max_us = 0;
+}
+
+void OutageTracker::flush(int64_t now_ms) {
+    for (TargetId id = 0; id < slots_.size(); ++id) {
+        Slot& s = slots_[id];
+        if (s.probes == 0)
+            continue;
+
+        if (sink_)
+            sink_(close(id, s, now_ms));
+
+        // Keep the state; the next interval starts now
+        s.start_ms   = now_ms;
+        s.probes     = 0;
+        s.lost       = 0;
+        s.received   = 0;
+        s.rtt_sum_us = 0;
+        s.rtt_min_us = 0;
+        s.rtt_max_us = 0;
+    }
+}
+
+
+// ============================================================================
+// Writer / reader
+// ============================================================================
+OutageLogWriter::OutageLogWriter(const std::string& path, bool append)
+    : out_(path, std::ios::out | (append ? std::ios::app : std::ios::trunc)) {}
+
+void OutageLogWriter::write(const OutageRecord& r) {
+    out_ << r.target << "," << to_string(r.state) << ","
+         << r.start_ms << "," << r.end_ms << ","
+         << r.probes << "," << r.lost << ","
+         << r.rtt_min_us << "," << r.rtt_avg_us << "," << r.rtt_max_us << "\n";
+    out_.flush();   // transitions are rare; keep the log crash-safe
+}
+
+std::vector<OutageRecord> read_outage_log(std::istream& in) {
+    std::vector<OutageRecord> out;
+    std::string line;
+
+    while (std::getline(in, line)) {
+        std::istringstream ls(line);
+        std::string field[9];
+        int n = 0;
+        while (n < 9 && std::getline(ls, field[n], ',')) ++n;
+        if (n != 9) continue;
+
+        OutageRecord r;
+        r.target = field[0];
+        if (!parse_state(field[1], r.state)) continue;
+
+        try {
+            r.start_ms   = std::stoll(field[2]);
+            r.end_ms     = std::stoll(field[3]);
+            r.probes     = static_cast<uint32_t>(std::stoul(field[4]));
+            r.lost       = static_cast<uint32_t>(std::stoul(field[5]));
+            r.rtt_min_us = static_cast<uint32_t>(std::stoul(field[6]));
+            r.rtt_avg_us = static_cast<uint32_t>(std::stoul(field[7]));
+            r.rtt_max_us = static_cast<uint32_t>(std::stoul(field[8]));
+        } catch (...) {
+            continue;
+        }
+        out.push_back(std::move(r));
+    }
+    return out;
+}
+
+AvailabilityReport availability(const std::vector<OutageRecord>& log,
+                                const std::string& target,
+                                int64_t from_ms, int64_t to_ms)
+{
+    AvailabilityReport rep;
+
+    for (const auto& r : log) {
+        if (!target.empty() && r.target != target)
+            continue;
+
+        int64_t overlap = std::min(r.end_ms, to_ms) - std::max(r.start_ms, from_ms);
+        if (overlap <= 0)
+            continue;
+
+        switch (r.state) {
+        case TargetState::Up:       rep.up_ms       += overlap; break;
+        case TargetState::Degraded: rep.degraded_ms += overlap; break;
+        case TargetState::Down:     rep.down_ms     += overlap; break;
+        case TargetState::Unknown:  rep.unknown_ms  += overlap; break;
+        }
+    }
+
+    const int64_t known = rep.up_ms + rep.degraded_ms + rep.down_ms;
+    if (known > 0) {
+        rep.availability_pct = 100.0 * double(rep.up_ms + rep.degraded_ms) / double(known);
+        rep.slo_pct          = 100.0 * double(rep.up_ms) / double(known);
+    }
+    return rep;
+}
+
+} // namespace cping
@@ -6,6 +6,12 @@ namespace cping {
 // Stub for non-Linux builds
 PingResult ping_host(const std::string&, int) { return {}; }
 PingResult ping_host(const std::string&, const PingOptions&) { return {}; }
+PingResult ping_host(const std::string&, const PingOptions&, std::stop_token) { return {}; }
+PingResult ping_host(const std::string&, const PingOptions&, const ProbeVisitor&,
+                     std::stop_token) { return {}; }
+PingResult ping_host(const Address&, const PingOptions&, std::stop_token) { return {}; }
+PingResult ping_host(const Address&, const PingOptions&, const ProbeVisitor&,
+                     std::stop_token) { return {}; }
 
 } // namespace cping
 
@@ -21,11 +27,16 @@ PingResult ping_host(const std::string&, const PingOptions&) { return {}; }
  *
  * It mirrors the Windows version in structure and guarantees that
  * PingResult and PingProbeResult behave identically across platforms.
+ * When the shared engine is running, probes are delegated to it so they
+ * take part in its in-flight cap and priority scheduling.
  */
 
 #include "cping/ping.hpp"
+#include "cping/clock.hpp"
+#include "cping/engine.hpp"
 #include "cping/ip.hpp"
 #include "cping/util.hpp"
+#include "trace.hpp"
 
 #include <chrono>
 #include <cstring>
@@ -45,6 +56,10 @@ PingResult ping_host(const std::string&, const PingOptions&) { return {}; }
 
 namespace cping {
 
+// Receive slice when a probe can be cancelled, so stop requests are seen
+static constexpr int kCancelSliceMs = 20;
+
+
 // ============================================================================
 // Helper: ICMP checksum wrapper
 // ============================================================================
@@ -56,26 +71,28 @@ static uint16_t icmp_checksum(const void* data, size_t len) {
 // ============================================================================
 // Perform a single ICMP Echo attempt on Linux (blocking)
 // ============================================================================
-static PingProbeResult ping_once_linux(const std::string& ip,
+static PingProbeResult ping_once_linux(const Address& addr,
                                        int timeout_ms,
                                        const std::string& if_name_override,
                                        int payload_size,
-                                       int ttl_opt)
+                                       int ttl_opt,
+                                       std::stop_token stop)
 {
     PingProbeResult probe{};
     probe.if_name = if_name_override;
 
     // ---------------------------------------------------------------------
-    // Parse target IPv4
+    // Target IPv4 (pre-parsed)
     // ---------------------------------------------------------------------
-    sockaddr_in dst{};
-    dst.sin_family = AF_INET;
-
-    if (inet_pton(AF_INET, ip.c_str(), &dst.sin_addr) != 1) {
+    if (!addr.is_v4()) {
         probe.error_msg = "Invalid IP address";
         return probe;
     }
 
+    sockaddr_in dst{};
+    dst.sin_family      = AF_INET;
+    dst.sin_addr.s_addr = addr.v4_net();
+
     // ---------------------------------------------------------------------
     // ICMP datagram socket
     // ---------------------------------------------------------------------
@@ -108,10 +125,12 @@ static PingProbeResult ping_once_linux(const std::string& ip,
         ::setsockopt(s, IPPROTO_IP, IP_TTL, &ttl_opt, sizeof(ttl_opt));
     }
 
-    // Timeout
+    // Timeout (sliced when cancellable)
+    const int slice_ms = stop.stop_possible()
+        ? std::min(timeout_ms, kCancelSliceMs) : timeout_ms;
     timeval tv{};
-    tv.tv_sec  = timeout_ms / 1000;
-    tv.tv_usec = (timeout_ms % 1000) * 1000;
+    tv.tv_sec  = slice_ms / 1000;
+    tv.tv_usec = (slice_ms % 1000) * 1000;
     ::setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
 
     // ---------------------------------------------------------------------
@@ -138,9 +157,12 @@ static PingProbeResult ping_once_linux(const std::string& ip,
     // ---------------------------------------------------------------------
     // Send
     // ---------------------------------------------------------------------
-    auto t_send = std::chrono::high_resolution_clock::now();
+    auto t_send = TscClock::now();
+
+    ssize_t sent = ::send(s, packet.data(), packet.size(), 0);
+    CPING_TRACE3(oneshot_send, dst.sin_addr.s_addr, packet.size(), sent);
 
-    if (::send(s, packet.data(), packet.size(), 0) < 0) {
+    if (sent < 0) {
         probe.error_msg = "send() failed";
         ::close(s);
         return probe;
@@ -175,10 +197,17 @@ static PingProbeResult ping_once_linux(const std::string& ip,
         ssize_t n = ::recvmsg(s, &msg, 0);
 
         if (n < 0) {
+            if (stop.stop_requested()) {
+                probe.error_msg = "Cancelled";
+                CPING_TRACE3(oneshot_done, dst.sin_addr.s_addr, 0, -1L);
+                ::close(s);
+                return probe;
+            }
             if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
                 continue;
 
             probe.error_msg = "recvmsg() failed";
+            CPING_TRACE3(oneshot_done, dst.sin_addr.s_addr, 0, -1L);
             ::close(s);
             return probe;
         }
@@ -191,10 +220,13 @@ static PingProbeResult ping_once_linux(const std::string& ip,
             continue;
 
         // RTT
-        auto t_recv = std::chrono::high_resolution_clock::now();
+        auto t_recv = TscClock::now();
         probe.rtt_ms = (long)std::chrono::duration_cast<std::chrono::milliseconds>(
                            t_recv - t_send)
                            .count();
+        probe.rtt_us = (long)std::chrono::duration_cast<std::chrono::microseconds>(
+                           t_recv - t_send)
+                           .count();
 
         // Extract TTL
         int ttl = -1;
@@ -215,12 +247,14 @@ static PingProbeResult ping_once_linux(const std::string& ip,
 
         probe.ttl = (ttl >= 0 ? ttl : -1);
         probe.success = true;
+        CPING_TRACE3(oneshot_done, dst.sin_addr.s_addr, 1, probe.rtt_us);
 
         ::close(s);
         return probe;
     }
 
     probe.error_msg = "No reply received";
+    CPING_TRACE3(oneshot_done, dst.sin_addr.s_addr, 0, -1L);
     ::close(s);
     return probe;
 }
@@ -239,19 +273,94 @@ PingResult ping_host(const std::string& ip, int timeout_ms) {
 
 
 PingResult ping_host(const std::string& ip, const PingOptions& opt) {
+    return ping_host(ip, opt, std::stop_token{});
+}
+
+
+PingResult ping_host(const std::string& ip, const PingOptions& opt,
+                     std::stop_token stop)
+{
+    std::vector<PingProbeResult> probes;
+    probes.reserve(static_cast<size_t>(std::max(1, opt.retries)));
+
+    PingResult result = ping_host(ip, opt,
+        [&probes](const PingProbeResult& probe, int) {
+            probes.push_back(probe);
+            return true;
+        },
+        stop);
+
+    result.probes = std::move(probes);
+    return result;
+}
+
+
+PingResult ping_host(const std::string& ip, const PingOptions& opt,
+                     const ProbeVisitor& on_probe, std::stop_token stop)
+{
+    auto addr = Address::parse(ip);
+    return ping_host(addr ? *addr : Address{}, opt, on_probe, stop);
+}
+
+
+// ============================================================================
+// Public API: pre-parsed target
+// ============================================================================
+PingResult ping_host(const Address& addr, const PingOptions& opt,
+                     std::stop_token stop)
+{
+    std::vector<PingProbeResult> probes;
+    probes.reserve(static_cast<size_t>(std::max(1, opt.retries)));
+
+    PingResult result = ping_host(addr, opt,
+        [&probes](const PingProbeResult& probe, int) {
+            probes.push_back(probe);
+            return true;
+        },
+        stop);
+
+    result.probes = std::move(probes);
+    return result;
+}
+
+
+PingResult ping_host(const Address& addr, const PingOptions& opt,
+                     const ProbeVisitor& on_probe, std::stop_token stop)
+{
     PingResult result{};
     bool any_ok = false;
 
+    // Engine override: share the engine socket and its send slots. The
+    // engine socket is not bound to a device, so an interface pin keeps
+    // the per-probe socket.
+    const bool use_engine = engine_available() && opt.if_name.empty();
+    auto once = [&] {
+        return use_engine
+            ? ping_once_engine(addr, opt.timeout_ms, opt.payload_size,
+                               opt.ttl, opt.priority, stop)
+            : ping_once_linux(addr,
+                              opt.timeout_ms,
+                              opt.if_name,
+                              opt.payload_size,
+                              opt.ttl,
+                              stop);
+    };
+
+    // Warmup: resolve neighbour / route state off the record
+    for (int w = 0; w < opt.warmup && !stop.stop_requested(); ++w) {
+        auto probe = once();
+        if (probe.success) {
+            result.warmup_rtt_us = probe.rtt_us >= 0 ? probe.rtt_us : probe.rtt_ms * 1000L;
+            break;
+        }
+    }
+
     const int attempts = std::max(1, opt.retries);
 
-    for (int i = 0; i < attempts; ++i) {
-        auto probe = ping_once_linux(ip,
-                                     opt.timeout_ms,
-                                     opt.if_name,
-                                     opt.payload_size,
-                                     opt.ttl);
+    for (int i = 0; i < attempts && !stop.stop_requested(); ++i) {
+        auto probe = once();
 
-        result.probes.push_back(probe);
+        const bool more = !on_probe || on_probe(probe, i);
 
         if (probe.success) {
             if (!any_ok || probe.rtt_ms < result.rtt_ms) {
@@ -263,6 +372,9 @@ PingResult ping_host(const std::string& ip, const PingOptions& opt) {
             if (opt.stop_on_first_success)
                 break;
         }
+
+        if (!more)
+            break;
     }
 
     result.reachable = any_ok;
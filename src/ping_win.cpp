@@ -12,6 +12,7 @@
  */
 
 #include "cping/ping.hpp"
+#include "cping/clock.hpp"
 #include "cping/ip.hpp"
 #include "win/win_route.hpp"
 #include "win/win_pcap.hpp"
@@ -43,23 +44,28 @@ static std::atomic<uint16_t> g_seq{1};
  *
  * Matching is performed by embedding a 64-bit tick timestamp in the payload.
  *
- * @param ip               Target IPv4 address as string (x.x.x.x)
+ * @param addr             Pre-parsed target address (IPv4 only)
  * @param timeout_ms       Probe timeout in milliseconds
  * @param if_name_override Manual interface substring (optional)
  * @param payload_size     Extra payload bytes to append after the timestamp
  * @param ttl_opt          Custom TTL, -1 = system default
+ * @param priority         Engine scheduling class (engine path only)
+ * @param stop             Cancels an engine probe in flight; the pcap path
+ *                         only checks it between attempts
  *
  * @return PingProbeResult containing RTT, TTL, error message, etc.
  */
-static PingProbeResult ping_once_win(const std::string& ip,
+static PingProbeResult ping_once_win(const Address& addr,
                                      int timeout_ms,
                                      const std::string& if_name_override,
                                      int payload_size,
-                                     int ttl_opt)
+                                     int ttl_opt,
+                                     ProbePriority priority,
+                                     std::stop_token stop)
 {
     // Engine override: when DLL engine is active, skip raw pcap path
     if (engine_available()) {
-        return ping_once_engine(ip, timeout_ms, payload_size, ttl_opt);
+        return ping_once_engine(addr, timeout_ms, payload_size, ttl_opt, priority, stop);
     }
 
     PingProbeResult probe{};
@@ -68,12 +74,14 @@ static PingProbeResult ping_once_win(const std::string& ip,
     // -----------------------------------------------------------------------
     // Validate target IP
     // -----------------------------------------------------------------------
-    in_addr dst_addr{};
-    if (InetPtonA(AF_INET, ip.c_str(), &dst_addr) != 1) {
+    if (!addr.is_v4()) {
         probe.error_msg = "Invalid IP address";
         return probe;
     }
 
+    in_addr dst_addr{};
+    dst_addr.s_addr = addr.v4_net();
+
     // -----------------------------------------------------------------------
     // Local-host fast path (pure local-loop ICMP)
     // -----------------------------------------------------------------------
@@ -137,7 +145,7 @@ static PingProbeResult ping_once_win(const std::string& ip,
         return probe;
     }
 
-    if (!apply_icmp_filter(cap, ip)) {
+    if (!apply_icmp_filter(cap, addr.to_string())) {
         pcap_freealldevs(alldevs);
         probe.error_msg = "apply_icmp_filter failed";
         return probe;
@@ -158,7 +166,7 @@ static PingProbeResult ping_once_win(const std::string& ip,
     uint16_t id     = static_cast<uint16_t>(GetCurrentProcessId() & 0xFFFF);
     uint16_t seqNow = g_seq.fetch_add(1, std::memory_order_relaxed);
 
-    auto t_send = std::chrono::high_resolution_clock::now();
+    auto t_send = TscClock::now();
 
     if (!send_icmp_echo_raw(dst_addr, id, seqNow, payload.data(), payload.size(), ttl_opt)) {
         pcap_freealldevs(alldevs);
@@ -184,7 +192,7 @@ static PingProbeResult ping_once_win(const std::string& ip,
             std::memcpy(&echoed, payload_rcv, sizeof(uint64_t));
             if (echoed != ticks) return false;  // validate correlation
 
-            auto t_recv = std::chrono::high_resolution_clock::now();
+            auto t_recv = TscClock::now();
 
             probe.rtt_ms = static_cast<long>(
                 std::chrono::duration_cast<std::chrono::milliseconds>(t_recv - t_send).count()
@@ -221,14 +229,84 @@ PingResult ping_host(const std::string& ip, int timeout_ms) {
 // New signature: recommended API
 // ---------------------------------------------------------------------------
 PingResult ping_host(const std::string& ip, const PingOptions& opt) {
+    return ping_host(ip, opt, std::stop_token{});
+}
+
+
+// ---------------------------------------------------------------------------
+// Cancellable signature
+// ---------------------------------------------------------------------------
+PingResult ping_host(const std::string& ip, const PingOptions& opt,
+                     std::stop_token stop)
+{
+    std::vector<PingProbeResult> probes;
+    probes.reserve(static_cast<size_t>(std::max<int>(1, opt.retries)));
+
+    PingResult result = ping_host(ip, opt,
+        [&probes](const PingProbeResult& probe, int) {
+            probes.push_back(probe);
+            return true;
+        },
+        stop);
+
+    result.probes = std::move(probes);
+    return result;
+}
+
+
+// ---------------------------------------------------------------------------
+// Streaming signature: one callback per completed probe
+// ---------------------------------------------------------------------------
+PingResult ping_host(const std::string& ip, const PingOptions& opt,
+                     const ProbeVisitor& on_probe, std::stop_token stop)
+{
+    auto addr = Address::parse(ip);
+    return ping_host(addr ? *addr : Address{}, opt, on_probe, stop);
+}
+
+
+// ---------------------------------------------------------------------------
+// Pre-parsed target signatures
+// ---------------------------------------------------------------------------
+PingResult ping_host(const Address& addr, const PingOptions& opt,
+                     std::stop_token stop)
+{
+    std::vector<PingProbeResult> probes;
+    probes.reserve(static_cast<size_t>(std::max<int>(1, opt.retries)));
+
+    PingResult result = ping_host(addr, opt,
+        [&probes](const PingProbeResult& probe, int) {
+            probes.push_back(probe);
+            return true;
+        },
+        stop);
+
+    result.probes = std::move(probes);
+    return result;
+}
+
+
+PingResult ping_host(const Address& addr, const PingOptions& opt,
+                     const ProbeVisitor& on_probe, std::stop_token stop)
+{
     PingResult result{};
     bool any_ok = false;
 
-    for (int i = 0; i < std::max<int>(1, opt.retries); ++i) {
-        auto probe = ping_once_win(ip, opt.timeout_ms, opt.if_name,
-                                   opt.payload_size, opt.ttl);
+    // Warmup: resolve neighbour / route state off the record
+    for (int w = 0; w < opt.warmup && !stop.stop_requested(); ++w) {
+        auto probe = ping_once_win(addr, opt.timeout_ms, opt.if_name,
+                                   opt.payload_size, opt.ttl, opt.priority, stop);
+        if (probe.success) {
+            result.warmup_rtt_us = probe.rtt_us >= 0 ? probe.rtt_us : probe.rtt_ms * 1000L;
+            break;
+        }
+    }
 
-        result.probes.push_back(probe);
+    for (int i = 0; i < std::max<int>(1, opt.retries) && !stop.stop_requested(); ++i) {
+        auto probe = ping_once_win(addr, opt.timeout_ms, opt.if_name,
+                                   opt.payload_size, opt.ttl, opt.priority, stop);
+
+        const bool more = !on_probe || on_probe(probe, i);
 
         if (probe.success) {
             if (!any_ok || probe.rtt_ms < result.rtt_ms) {
@@ -240,6 +318,9 @@ PingResult ping_host(const std::string& ip, const PingOptions& opt) {
             if (opt.stop_on_first_success)
                 break;
         }
+
+        if (!more)
+            break;
     }
 
     result.reachable = any_ok;
@@ -0,0 +1,229 @@
+/**
+ * Path-compressed radix trie for longest-prefix matches.
+ *
+ * Keys are up to 128 bits held as two big-endian words (IPv4 uses the
+ * top 32 bits of `hi`). Invariant: a child's prefix extends its
+ * parent's by at least one bit, and the bit right after the parent's
+ * length selects the child slot.
+ */
+
+#include "cping/prefix_trie.hpp"
+#include "cping/groups.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <sstream>
+#include <string>
+
+namespace cping {
+
+namespace {
+
+uint64_t load_be64(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v = (v << 8) | p[i];
+    return v;
+}
+
+uint32_t v4_host(const Address& a) {
+    return (uint32_t(a.bytes[12]) << 24) | (uint32_t(a.bytes[13]) << 16) |
+           (uint32_t(a.bytes[14]) << 8)  |  uint32_t(a.bytes[15]);
+}
+
+int bit_at(uint64_t hi, uint64_t lo, int i) {
+    return i < 64 ? int((hi >> (63 - i)) & 1) : int((lo >> (127 - i)) & 1);
+}
+
+/** Clear every bit from position `len` on. */
+void mask_to(uint64_t& hi, uint64_t& lo, int len) {
+    if (len <= 0)        { hi = 0; lo = 0; }
+    else if (len < 64)   { hi &= ~uint64_t(0) << (64 - len); lo = 0; }
+    else if (len == 64)  { lo = 0; }
+    else if (len < 128)  { lo &= ~uint64_t(0) << (128 - len); }
+}
+
+/** Number of leading bits two keys share (128 if equal). */
+int common_bits(uint64_t ahi, uint64_t alo, uint64_t bhi, uint64_t blo) {
+    if (ahi != bhi) return std::countl_zero(ahi ^ bhi);
+    if (alo != blo) return 64 + std::countl_zero(alo ^ blo);
+    return 128;
+}
+
+} // namespace
+
+
+// ============================================================================
+// Build
+// ============================================================================
+PrefixTrie::PrefixTrie() {
+    clear();
+}
+
+void PrefixTrie::clear() {
+    nodes_.assign(2, Node{});
+    prefixes_ = 0;
+}
+
+bool PrefixTrie::insert(const Address& addr, int len, uint32_t value) {
+    if (addr.is_v4()) {
+        if (len < 0 || len > 32) return false;
+        return insert_key(0, uint64_t(v4_host(addr)) << 32, 0, len, value);
+    }
+    if (addr.is_v6()) {
+        if (len < 0 || len > 128) return false;
+        return insert_key(1, load_be64(addr.bytes.data()), load_be64(addr.bytes.data() + 8),
+                          len, value);
+    }
+    return false;
+}
+
+bool PrefixTrie::insert(std::string_view cidr, uint32_t value) {
+    Address a;
+    int len = 0;
+    return parse_prefix(cidr, a, len) && insert(a, len, value);
+}
+
+bool PrefixTrie::insert_key(uint32_t root, uint64_t hi, uint64_t lo, int len, uint32_t value) {
+    mask_to(hi, lo, len);
+
+    auto make = [&](uint64_t h, uint64_t l, int n, uint32_t v) {
+        Node nd;
+        nd.hi = h; nd.lo = l; nd.len = static_cast<uint8_t>(n); nd.value = v;
+        nodes_.push_back(nd);
+        return static_cast<uint32_t>(nodes_.size() - 1);
+    };
+
+    // Indices only: push_back may move the nodes
+    uint32_t at = root;
+    for (;;) {
+        if (nodes_[at].len == len) {
+            if (nodes_[at].value == kNoValue) ++prefixes_;
+            nodes_[at].value = value;
+            return true;
+        }
+
+        const int b = bit_at(hi, lo, nodes_[at].len);
+        const uint32_t c = nodes_[at].child[b];
+        if (c == kNil) {
+            const uint32_t leaf = make(hi, lo, len, value);
+            nodes_[at].child[b] = leaf;
+            ++prefixes_;
+            return true;
+        }
+
+        const Node& m = nodes_[c];
+        const int cp = std::min({ common_bits(m.hi, m.lo, hi, lo), int(m.len), len });
+        if (cp == m.len) {
+            at = c;
+            continue;
+        }
+
+        // The new prefix ends or diverges inside the child's compressed path
+        const int mbit = bit_at(m.hi, m.lo, cp);
+        uint32_t mid;
+        if (cp == len) {
+            mid = make(hi, lo, len, value);
+        } else {
+            uint64_t mh = hi, ml = lo;
+            mask_to(mh, ml, cp);
+            mid = make(mh, ml, cp, kNoValue);
+            nodes_[mid].child[1 - mbit] = make(hi, lo, len, value);
+        }
+        nodes_[mid].child[mbit] = c;
+        nodes_[at].child[b] = mid;
+        ++prefixes_;
+        return true;
+    }
+}
+
+
+// ============================================================================
+// Lookup
+// ============================================================================
+uint32_t PrefixTrie::lookup_key(uint32_t root, uint64_t hi, uint64_t lo, int max_len) const noexcept {
+    uint32_t best = kNoValue;
+    uint32_t at = root;
+
+    while (at != kNil) {
+        const Node& n = nodes_[at];
+        if (common_bits(n.hi, n.lo, hi, lo) < n.len)
+            break;
+        if (n.value != kNoValue)
+            best = n.value;
+        if (n.len >= max_len)
+            break;
+        at = n.child[bit_at(hi, lo, n.len)];
+    }
+    return best;
+}
+
+uint32_t PrefixTrie::lookup_v4(uint32_t host_order) const noexcept {
+    return lookup_key(0, uint64_t(host_order) << 32, 0, 32);
+}
+
+uint32_t PrefixTrie::lookup(const Address& addr) const noexcept {
+    if (addr.is_v4())
+        return lookup_v4(v4_host(addr));
+    if (addr.is_v6())
+        return lookup_key(1, load_be64(addr.bytes.data()), load_be64(addr.bytes.data() + 8), 128);
+    return kNoValue;
+}
+
+
+// ============================================================================
+// Parsing and loading
+// ============================================================================
+bool parse_prefix(std::string_view text, Address& addr, int& len) {
+    const auto slash = text.find('/');
+    auto a = Address::parse(text.substr(0, slash));
+    if (!a)
+        return false;
+
+    const int max_len = a->is_v4() ? 32 : 128;
+    len = max_len;
+    if (slash != std::string_view::npos) {
+        const char* first = text.data() + slash + 1;
+        const char* last  = text.data() + text.size();
+        auto [p, ec] = std::from_chars(first, last, len);
+        if (ec != std::errc{} || p != last || first == last || len < 0 || len > max_len)
+            return false;
+    }
+    addr = *a;
+    return true;
+}
+
+size_t load_prefix_list(std::istream& in, PrefixTrie& trie, GroupIndex* groups) {
+    size_t added = 0;
+    std::string line;
+
+    while (std::getline(in, line)) {
+        auto hash = line.find('#');
+        if (hash != std::string::npos)
+            line.erase(hash);
+
+        std::istringstream fields(line);
+        std::string cidr, label;
+        if (!(fields >> cidr))
+            continue;
+
+        Address a;
+        int len = 0;
+        if (!parse_prefix(cidr, a, len))
+            continue;
+
+        uint32_t value = static_cast<uint32_t>(added);
+        if (groups) {
+            if (!(fields >> label))
+                continue;
+            value = groups->group(label);
+        }
+
+        if (trie.insert(a, len, value))
+            ++added;
+    }
+
+    return added;
+}
+
+} // namespace cping
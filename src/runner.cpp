@@ -2,8 +2,13 @@
  * Runner: orchestrates ping sessions.
  *
  * This module handles:
- * - Continuous ping loop (SIGINT-driven)
+ * - Continuous ping loop (SIGINT-driven, cancels probes in flight)
  * - Single-shot or multi-attempt pings
+ * - Multi-target monitoring with group rollups (--targets)
+ * - Online anomaly detection (--anomaly)
+ * - Outage transition log and availability reports
+ * - Flood mode with an adaptive in-flight window (--flood)
+ * - Deadline-bounded batch checks (--targets with --deadline)
  * - RTT statistics (min/max/avg)
  * - Terminal color formatting
  * - Exporting results to file
@@ -13,31 +18,1003 @@
 
 #include "runner.hpp"
 #include "cping/ping.hpp"
+#include "cping/agent.hpp"
+#include "cping/anomaly.hpp"
+#include "cping/arena.hpp"
+#include "cping/batch.hpp"
+#include "cping/capture.hpp"
+#include "cping/engine.hpp"
+#include "cping/flood.hpp"
+#include "cping/groups.hpp"
+#include "cping/histogram.hpp"
+#include "cping/matrix.hpp"
+#include "cping/monitor.hpp"
+#include "cping/outage_log.hpp"
+#include "cping/prefix_trie.hpp"
+#include "cping/shard.hpp"
+#include "cping/sweep.hpp"
 #include "stats.hpp"
 #include "terminal.hpp"
 #include "export.hpp"
 
 #include <iostream>
+#include <fstream>
 #include <csignal>
+#include <cstdlib>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stop_token>
 #include <chrono>
 #include <thread>
 #include <limits>
 #include <vector>
 #include <algorithm>
+#include <bit>
+#include <memory>
+#include <string_view>
 
 using namespace cping;
 
-// Global flag toggled by CTRL+C
-static bool keep_running = true;
+// Global flag toggled by CTRL+C (lock-free atomic, safe in a signal handler)
+static std::atomic<bool> keep_running{true};
+
+// Cancels probes in flight; fed from keep_running by the interrupt watcher
+static std::stop_source g_stop;
 
 /**
- * SIGINT handler for continuous mode.
+ * SIGINT handler.
  * Simply toggles a shared flag so the loop can exit gracefully.
  */
 void handle_sigint(int) {
-    keep_running = false;
+    keep_running.store(false);
+}
+
+/**
+ * Install the SIGINT handler plus a watcher thread forwarding CTRL+C to
+ * g_stop. request_stop() runs stop callbacks that take engine locks, so
+ * it must not be called from the signal handler itself.
+ */
+static std::jthread watch_interrupts() {
+    std::signal(SIGINT, handle_sigint);
+
+    return std::jthread([](std::stop_token self) {
+        while (!self.stop_requested()) {
+            if (!keep_running.load()) {
+                g_stop.request_stop();
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    });
+}
+
+/**
+ * Warn when the kernel dropped replies on the engine socket: those
+ * probes were reported as timeouts, but the loss was self-inflicted.
+ */
+static void warn_rx_drops() {
+    auto st = engine_stats();
+    if (st.rx_dropped == 0)
+        return;
+
+    std::cerr << term::yellow() << st.rx_dropped
+              << " replies dropped by the local receive queue (counted as timeouts)"
+              << term::reset();
+    if (st.rcvbuf_grows > 0)
+        std::cerr << ", receive buffer grown to " << st.rcvbuf_bytes / 1024 << " KiB";
+    std::cerr << "\n";
+}
+
+/**
+ * Sleep until `t`, waking up early on CTRL+C.
+ */
+static void sleep_until_or_stop(std::chrono::steady_clock::time_point t) {
+    std::mutex m;
+    std::condition_variable_any cv;
+    std::unique_lock<std::mutex> lk(m);
+    cv.wait_until(lk, g_stop.get_token(), t, [] { return false; });
+}
+
+/**
+ * Print one anomaly event line (RTT values converted to ms).
+ */
+static void print_anomaly(const std::string& target, const AnomalyEvent& ev) {
+    std::cout << term::yellow() << "[anomaly] " << to_string(ev.kind)
+              << term::reset() << " " << target << ": ";
+
+    switch (ev.kind) {
+    case AnomalyKind::RttLevelShift:
+        std::cout << "RTT " << ev.baseline / 1000.0 << "ms -> "
+                  << ev.value / 1000.0 << "ms";
+        break;
+    case AnomalyKind::JitterSpike:
+        std::cout << "jump " << ev.value / 1000.0 << "ms (mean jitter "
+                  << ev.baseline / 1000.0 << "ms)";
+        break;
+    case AnomalyKind::LossBurst:
+        std::cout << "loss rate " << static_cast<int>(ev.value * 100)
+                  << "%, " << ev.baseline << " lost in a row";
+        break;
+    }
+    std::cout << "\n";
+}
+
+/**
+ * Load --exclude into `trie` (left empty without the flag).
+ * @return false if the file cannot be read.
+ */
+static bool load_exclusions(const CliOptions& opt, PrefixTrie& trie) {
+    if (opt.exclude_path.empty())
+        return true;
+
+    std::ifstream in(opt.exclude_path);
+    if (!in) {
+        std::cerr << "Cannot open exclusion list: " << opt.exclude_path << "\n";
+        return false;
+    }
+    const size_t n = load_prefix_list(in, trie);
+    if (!opt.quiet)
+        std::cout << "Excluding " << n << " prefix(es)\n";
+    return true;
+}
+
+/**
+ * Load the --targets list with --exclude applied; every mode that reads
+ * a target list goes through here.
+ * @return number of targets loaded (0 also if a file cannot be read).
+ */
+static size_t load_targets(const CliOptions& opt, TargetTable& table,
+                           GroupIndex* groups = nullptr)
+{
+    PrefixTrie exclude;
+    if (!load_exclusions(opt, exclude))
+        return 0;
+
+    std::ifstream in(opt.targets_path);
+    if (!in) {
+        std::cerr << "Cannot open target list: " << opt.targets_path << "\n";
+        return 0;
+    }
+
+    size_t v6 = 0;
+    const size_t n = load_target_list(in, table, groups, &exclude, &v6);
+    if (v6 > 0)
+        std::cerr << term::yellow() << "Skipping " << v6
+                  << " IPv6 target(s): the engine probes IPv4 only" << term::reset() << "\n";
+    return n;
+}
+
+/**
+ * Map the targets to the groups of --prefix-groups (longest match wins).
+ * @return false if the file cannot be read.
+ */
+static bool load_prefix_groups(const CliOptions& opt, const TargetTable& table,
+                               GroupIndex& groups)
+{
+    if (opt.prefix_groups.empty())
+        return true;
+
+    std::ifstream in(opt.prefix_groups);
+    if (!in) {
+        std::cerr << "Cannot open prefix groups: " << opt.prefix_groups << "\n";
+        return false;
+    }
+    PrefixTrie trie;
+    load_prefix_list(in, trie, &groups);
+    groups.assign_matches(table, trie);
+    return true;
+}
+
+/**
+ * Multi-target monitor mode (--targets <file>).
+ *
+ * Loads the target list into a TargetTable, maps every target to its /24
+ * plus any labels from the file, and probes all targets once per interval
+ * through the shared engine. Group rollups are maintained on completion
+ * and printed (and optionally exported) at the end.
+ *
+ * Rounds: --count N, or until CTRL+C with --continuous, else one round.
+ */
+static int run_monitor(const CliOptions& opt) {
+    TargetTable table;
+    GroupIndex groups;
+    size_t n = load_targets(opt, table, &groups);
+    if (n == 0) {
+        std::cerr << "No valid targets in " << opt.targets_path << "\n";
+        return 1;
+    }
+    if (!load_prefix_groups(opt, table, groups))
+        return 1;
+
+    if (!init_engine(opt.ping.if_name)) {
+        std::cerr << "Failed to start the ICMP engine\n";
+        return 1;
+    }
+
+    MonitorOptions mo;
+    mo.interval_ms  = opt.interval_ms;
+    mo.timeout_ms   = opt.ping.timeout_ms;
+    mo.payload_size = opt.ping.payload_size;
+    mo.ttl          = opt.ping.ttl;
+
+    Monitor mon(table, mo);
+    mon.add_hook([&groups](TargetId id, const PingProbeResult& probe) {
+        groups.record(id, probe);
+    });
+
+    // Per-target detector state, indexed by TargetId (40 bytes each)
+    AnomalyDetector detector;
+    std::vector<AnomalyState> anomaly_state;
+    if (opt.anomaly) {
+        anomaly_state.resize(table.size());
+        mon.add_hook([&](TargetId id, const PingProbeResult& probe) {
+            AnomalyEvent ev[AnomalyDetector::kMaxEvents];
+            int n = detector.observe(anomaly_state[id], probe, ev);
+            for (int i = 0; i < n; ++i)
+                print_anomaly(table.address(id), ev[i]);
+        });
+    }
+
+    // Per-target up/down state; only transitions reach the log file
+    std::unique_ptr<OutageLogWriter> outage_writer;
+    std::unique_ptr<OutageTracker> outages;
+    if (!opt.outage_log.empty()) {
+        outage_writer = std::make_unique<OutageLogWriter>(opt.outage_log);
+        if (!outage_writer->ok()) {
+            std::cerr << "Cannot open outage log: " << opt.outage_log << "\n";
+            shutdown_engine();
+            return 1;
+        }
+
+        OutageLogWriter* w = outage_writer.get();
+        outages = std::make_unique<OutageTracker>(
+            table, OutagePolicy{},
+            [w](const OutageRecord& rec) { w->write(rec); });
+
+        OutageTracker* t = outages.get();
+        mon.add_hook([t](TargetId id, const PingProbeResult& probe) {
+            t->observe(id, probe, OutageTracker::now_ms());
+        });
+    }
+
+    const int rounds = (opt.count > 0) ? opt.count : (opt.continuous ? -1 : 1);
+
+    auto watch = watch_interrupts();
+
+    if (!opt.quiet) {
+        std::cout << "Monitoring " << n << " target(s) in "
+                  << groups.group_count() << " group(s), interval="
+                  << opt.interval_ms << "ms\n";
+    }
+
+    for (int r = 0; keep_running && (rounds < 0 || r < rounds); ++r)
+        mon.run_for(std::chrono::milliseconds(opt.interval_ms), &keep_running);
+
+    mon.wait_idle(std::chrono::milliseconds(opt.ping.timeout_ms + 100));
+    warn_rx_drops();
+    shutdown_engine();
+
+    if (outages)
+        outages->flush(OutageTracker::now_ms());
+
+    auto summaries = groups.summaries();
+    print_group_summary(summaries);
+    print_latency_percentiles(mon.raw_latency(), mon.corrected_latency());
+
+    if (!opt.export_path.empty()) {
+        export_groups(opt.export_path, opt.export_format,
+                      summaries, opt.export_append);
+    }
+
+    return 0;
+}
+
+/**
+ * Scale-out monitor mode (--targets <file> --workers <n|auto>).
+ *
+ * Same probing and output as the monitor, but the target list is split
+ * across worker processes with one engine each; their group rollups and
+ * latency histograms are merged before printing / export.
+ */
+static int run_sharded_mode(const CliOptions& opt) {
+    TargetTable table;
+    GroupIndex groups;
+    size_t n = load_targets(opt, table, &groups);
+    if (n == 0) {
+        std::cerr << "No valid targets in " << opt.targets_path << "\n";
+        return 1;
+    }
+    if (!load_prefix_groups(opt, table, groups))
+        return 1;
+
+    ShardOptions so;
+    so.workers = opt.workers;
+    so.rounds  = (opt.count > 0) ? opt.count : (opt.continuous ? -1 : 1);
+    so.if_name = opt.ping.if_name;
+    so.monitor.interval_ms  = opt.interval_ms;
+    so.monitor.timeout_ms   = opt.ping.timeout_ms;
+    so.monitor.payload_size = opt.ping.payload_size;
+    so.monitor.ttl          = opt.ping.ttl;
+
+    // Workers inherit the handler and keep_running; no watcher thread
+    // may exist before they are forked
+    std::signal(SIGINT, handle_sigint);
+
+    ShardedResult res;
+    const bool ok = run_sharded(table, &groups, so, res, &keep_running);
+
+    if (!opt.quiet) {
+        std::cout << "Monitored " << n << " target(s) with "
+                  << res.workers_ok << "/" << res.workers << " worker(s)\n";
+    }
+    if (!ok) {
+        std::cerr << "No worker reported back\n";
+        return 1;
+    }
+
+    auto summaries = groups.summaries();
+    print_group_summary(summaries);
+    print_latency_percentiles(res.raw, res.corrected);
+
+    if (!opt.export_path.empty()) {
+        export_groups(opt.export_path, opt.export_format,
+                      summaries, opt.export_append);
+    }
+
+    return res.workers_ok == res.workers ? 0 : 1;
+}
+
+/** Shared agent secret from CPING_AGENT_SECRET (kept off the command line). */
+static std::string agent_secret() {
+    const char* s = std::getenv("CPING_AGENT_SECRET");
+    return s ? s : "";
+}
+
+/**
+ * Probe agent mode (--agent <port> [--bind <addr>]).
+ *
+ * Listens for a coordinator and runs its jobs on the local engine until
+ * CTRL+C. Binding off loopback needs CPING_AGENT_SECRET.
+ */
+static int run_agent_mode(const CliOptions& opt) {
+    AgentOptions ao;
+    ao.bind   = opt.agent_bind;
+    ao.port   = static_cast<uint16_t>(opt.agent_port);
+    ao.secret = agent_secret();
+
+    ProbeAgent agent(ao);
+    if (!agent.listen()) {
+        std::cerr << "Cannot listen on " << opt.agent_bind << ":" << opt.agent_port;
+        if (ao.secret.empty())
+            std::cerr << " (set CPING_AGENT_SECRET to bind off loopback)";
+        std::cerr << "\n";
+        return 1;
+    }
+    if (!init_engine(opt.ping.if_name)) {
+        std::cerr << "Failed to start the ICMP engine\n";
+        return 1;
+    }
+
+    std::cout << "Probe agent listening on " << opt.agent_bind << ":" << agent.port()
+              << " (CTRL+C to stop)\n";
+
+    auto watch = watch_interrupts();
+    agent.serve(&keep_running);
+    shutdown_engine();
+    return 0;
+}
+
+/**
+ * Coordinator mode (--targets <file> --agents <host:port,...>).
+ *
+ * Sends the target list to every agent as one job (-c rounds, -i
+ * interval, -t timeout) and prints loss and latency per vantage point
+ * and merged over all of them. Returns 0 only if every agent completed.
+ */
+static int run_coordinator_mode(const CliOptions& opt) {
+    TargetTable table;
+    if (load_targets(opt, table) == 0) {
+        std::cerr << "No valid targets in " << opt.targets_path << "\n";
+        return 1;
+    }
+
+    AgentJob job;
+    job.id           = 1;
+    job.rounds       = opt.count > 0 ? opt.count : 1;
+    job.interval_ms  = opt.interval_ms;
+    job.timeout_ms   = opt.ping.timeout_ms;
+    job.payload_size = opt.ping.payload_size;
+    job.ttl          = opt.ping.ttl;
+    job.targets.reserve(table.size());
+    for (TargetId id = 0; id < table.size(); ++id)
+        job.targets.push_back(table.addr(id));
+
+    AgentCoordinator coord;
+    const std::string secret = agent_secret();
+    size_t start = 0;
+    while (start <= opt.agents.size()) {
+        size_t comma = opt.agents.find(',', start);
+        if (comma == std::string::npos) comma = opt.agents.size();
+
+        std::string spec = opt.agents.substr(start, comma - start);
+        size_t colon = spec.rfind(':');
+        if (!spec.empty()) {
+            int port = colon == std::string::npos ? 7227 : std::atoi(spec.c_str() + colon + 1);
+            std::string host = spec.substr(0, colon);
+            if (port <= 0 || port > 65535 || !coord.connect(host, static_cast<uint16_t>(port), secret))
+                std::cerr << "Cannot connect to agent " << spec << "\n";
+        }
+        start = comma + 1;
+    }
+    if (coord.agents() == 0) {
+        std::cerr << "No agent reachable\n";
+        return 1;
+    }
+
+    auto res = coord.run(job);
+
+    auto print = [&](const std::string& name, bool complete, uint64_t sent,
+                     uint64_t received, const LatencyHistogram& h) {
+        const double loss = sent ? 100.0 * double(sent - received) / double(sent) : 0.0;
+        std::cout << (complete && received ? term::green() : term::red()) << name
+                  << term::reset() << ": " << sent << " sent, " << received
+                  << " received, loss " << loss << "%";
+        if (h.count()) {
+            std::cout << ", p50 " << h.percentile_us(50) / 1000.0 << "ms"
+                      << ", p99 " << h.percentile_us(99) / 1000.0 << "ms";
+        }
+        std::cout << (complete ? "" : " (incomplete)") << "\n";
+    };
+
+    size_t complete = 0;
+    for (const auto& v : res.vantage) {
+        if (v.complete) complete++;
+        if (!opt.quiet)
+            print(v.agent, v.complete, v.sent, v.received, v.latency);
+    }
+    print("all", complete == res.vantage.size(), res.sent, res.received, res.global);
+
+    return complete == res.vantage.size() ? 0 : 1;
+}
+
+/**
+ * Flood mode (--flood).
+ *
+ * Probes the target (or every target of --targets) as fast as an AIMD
+ * window of outstanding probes allows, for --duration seconds or -c
+ * probes, then prints achieved rate, loss, window and latency.
+ */
+static int run_flood_mode(const CliOptions& opt) {
+    FloodOptions fo;
+    fo.duration_ms  = opt.duration_s * 1000;
+    fo.max_probes   = opt.count > 0 ? static_cast<uint64_t>(opt.count) : 0;
+    fo.timeout_ms   = opt.ping.timeout_ms;
+    fo.payload_size = opt.ping.payload_size;
+
+    if (!opt.targets_path.empty()) {
+        TargetTable table;
+        if (load_targets(opt, table) == 0) {
+            std::cerr << "No valid targets in " << opt.targets_path << "\n";
+            return 1;
+        }
+        for (TargetId id = 0; id < table.size(); ++id)
+            fo.targets.push_back(table.address(id));
+    } else {
+        fo.targets.push_back(opt.ip);
+    }
+
+    if (!init_engine(opt.ping.if_name)) {
+        std::cerr << "Failed to start the ICMP engine\n";
+        return 1;
+    }
+
+    if (!opt.quiet) {
+        std::cout << "Flooding " << fo.targets.size() << " target(s)";
+        if (fo.duration_ms) std::cout << " for " << opt.duration_s << "s";
+        if (fo.max_probes)  std::cout << ", up to " << fo.max_probes << " probes";
+        std::cout << "\n";
+    }
+
+    auto watch = watch_interrupts();
+    auto stats = run_flood(fo, &keep_running);
+    warn_rx_drops();
+    shutdown_engine();
+
+    print_flood_summary(stats);
+    return stats.received > 0 ? 0 : 1;
+}
+
+/**
+ * Batch health check (--targets <file> --deadline <ms>).
+ *
+ * Probes every target once within the budget and prints one status line
+ * per target; targets without a verdict at the deadline show as pending.
+ * Returns 0 only if every target replied.
+ */
+static int run_batch(const CliOptions& opt) {
+    TargetTable table;
+    if (load_targets(opt, table) == 0) {
+        std::cerr << "No valid targets in " << opt.targets_path << "\n";
+        return 1;
+    }
+
+    std::vector<std::string> targets;
+    targets.reserve(table.size());
+    for (TargetId id = 0; id < table.size(); ++id)
+        targets.push_back(table.address(id));
+
+    if (!init_engine(opt.ping.if_name)) {
+        std::cerr << "Failed to start the ICMP engine\n";
+        return 1;
+    }
+
+    BatchOptions bo;
+    bo.deadline_ms      = opt.deadline_ms;
+    bo.probe_timeout_ms = opt.ping.timeout_ms;
+    bo.payload_size     = opt.ping.payload_size;
+    bo.ttl              = opt.ping.ttl;
+
+    auto results = ping_batch(targets, bo);
+    warn_rx_drops();
+    shutdown_engine();
+
+    int counts[4] = {0, 0, 0, 0};
+    for (const auto& r : results) {
+        counts[static_cast<int>(r.status)]++;
+        if (opt.quiet)
+            continue;
+
+        if (r.status == BatchStatus::Replied) {
+            std::cout << term::green() << r.ip << term::reset()
+                      << " replied RTT=" << r.probe.rtt_ms << "ms\n";
+        } else {
+            std::cout << term::red() << r.ip << term::reset()
+                      << " " << to_string(r.status) << "\n";
+        }
+    }
+
+    std::cout << results.size() << " target(s) in " << opt.deadline_ms << "ms: "
+              << counts[0] << " replied, " << counts[1] << " lost, "
+              << counts[2] << " pending, " << counts[3] << " failed\n";
+
+    return counts[0] == static_cast<int>(results.size()) ? 0 : 1;
+}
+
+/**
+ * Reachability matrix mode (--targets <file> --matrix <src,src,...>).
+ *
+ * Probes every (source, target) pair -c times (default 3) over one
+ * engine and prints one summary line per source. The full matrix goes
+ * to --csv and/or --matrix-out (binary). Returns 0 only if every pair
+ * got at least one reply.
+ */
+static int run_matrix_mode(const CliOptions& opt) {
+    std::vector<MatrixSource> sources;
+    size_t start = 0;
+    while (start <= opt.matrix_sources.size()) {
+        size_t comma = opt.matrix_sources.find(',', start);
+        if (comma == std::string::npos) comma = opt.matrix_sources.size();
+
+        std::string spec = opt.matrix_sources.substr(start, comma - start);
+        if (!spec.empty()) {
+            MatrixSource src;
+            if (!parse_matrix_source(spec, src)) {
+                std::cerr << "Unknown source address or interface: " << spec << "\n";
+                return 1;
+            }
+            sources.push_back(std::move(src));
+        }
+        start = comma + 1;
+    }
+
+    TargetTable table;
+    if (sources.empty() || load_targets(opt, table) == 0) {
+        std::cerr << "Matrix needs at least one source and one valid target\n";
+        return 1;
+    }
+
+    std::vector<Address> targets;
+    targets.reserve(table.size());
+    for (TargetId id = 0; id < table.size(); ++id)
+        targets.push_back(table.addr(id));
+
+    if (!init_engine()) {
+        std::cerr << "Failed to start the ICMP engine\n";
+        return 1;
+    }
+
+    MatrixOptions mo;
+    mo.probes       = opt.count > 0 ? opt.count : 3;
+    mo.timeout_ms   = opt.ping.timeout_ms;
+    mo.payload_size = opt.ping.payload_size;
+    mo.ttl          = opt.ping.ttl;
+
+    auto watch = watch_interrupts();
+    auto t0 = std::chrono::steady_clock::now();
+    auto m = run_matrix(sources, targets, mo, &keep_running);
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - t0).count();
+    warn_rx_drops();
+    shutdown_engine();
+
+    size_t dead_pairs = 0;
+    for (size_t s = 0; s < m.sources.size(); ++s) {
+        uint64_t sent = 0, received = 0;
+        size_t dead = 0;
+        for (size_t t = 0; t < m.targets.size(); ++t) {
+            const auto& c = m.at(s, t);
+            sent     += c.sent;
+            received += c.received;
+            if (c.received == 0) dead++;
+        }
+        dead_pairs += dead;
+
+        if (!opt.quiet) {
+            std::cout << (dead ? term::red() : term::green()) << m.sources[s]
+                      << term::reset() << ": " << m.targets.size() - dead << "/"
+                      << m.targets.size() << " targets reachable, loss "
+                      << (sent ? 100.0 * (sent - received) / sent : 0.0) << "%\n";
+        }
+    }
+
+    std::cout << m.sources.size() << " x " << m.targets.size() << " pairs in "
+              << ms << "ms, " << dead_pairs << " unreachable\n";
+
+    if (!opt.export_path.empty()) {
+        std::ofstream out(opt.export_path);
+        if (!out || !write_matrix_csv(m, out))
+            std::cerr << "Failed to write " << opt.export_path << "\n";
+    }
+    if (!opt.matrix_out.empty()) {
+        std::ofstream out(opt.matrix_out, std::ios::binary);
+        if (!out || !write_matrix_binary(m, out))
+            std::cerr << "Failed to write " << opt.matrix_out << "\n";
+    }
+
+    return dead_pairs == 0 ? 0 : 1;
+}
+
+/**
+ * Range sweep mode (--sweep <cidr>).
+ *
+ * One probe per address in permutation order at --rate. With
+ * --checkpoint the state is saved every few seconds and on exit, and a
+ * later run with the same file continues where the last one stopped.
+ * Prints every responder, then the alive count.
+ */
+static int run_sweep_mode(const CliOptions& opt) {
+    SweepRange range;
+    if (!parse_sweep_range(opt.sweep_range, range)) {
+        std::cerr << "Invalid sweep range (a.b.c.d/len, len >= 8): " << opt.sweep_range << "\n";
+        return 1;
+    }
+
+    SweepState st = new_sweep(range);
+    if (!opt.checkpoint_path.empty()) {
+        std::ifstream in(opt.checkpoint_path, std::ios::binary);
+        if (in) {
+            if (!read_sweep_state(in, st) || !(st.range == range)) {
+                std::cerr << "Checkpoint " << opt.checkpoint_path
+                          << " is unreadable or belongs to another range\n";
+                return 1;
+            }
+            if (!opt.quiet)
+                std::cout << "Resuming at " << st.done << "/" << range.size
+                          << " (" << st.responders.size() << " alive so far)\n";
+        }
+    }
+
+    PrefixTrie exclude;
+    if (!load_exclusions(opt, exclude))
+        return 1;
+
+    if (!init_engine(opt.ping.if_name)) {
+        std::cerr << "Failed to start the ICMP engine\n";
+        return 1;
+    }
+
+    SweepOptions so;
+    so.exclude         = &exclude;
+    so.rate_pps        = opt.rate_pps;
+    so.timeout_ms      = opt.ping.timeout_ms;
+    so.checkpoint_path = opt.checkpoint_path;
+    so.payload_size    = opt.ping.payload_size;
+    so.ttl             = opt.ping.ttl;
+
+    auto watch = watch_interrupts();
+    auto t0 = std::chrono::steady_clock::now();
+    const bool complete = run_sweep(st, so, &keep_running);
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - t0).count();
+    warn_rx_drops();
+    shutdown_engine();
+
+    if (!opt.quiet && !opt.summary) {
+        for (const auto& r : st.responders) {
+            std::cout << Address::v4(st.address(r.offset)).to_string()
+                      << "  rtt=" << r.rtt_us / 1000.0 << "ms ttl=" << int(r.ttl) << "\n";
+        }
+    }
+
+    std::cout << st.responders.size() << "/" << range.size << " addresses alive, "
+              << st.done << " covered in " << ms << "ms\n";
+    if (!complete) {
+        std::cout << term::yellow() << "Sweep interrupted"
+                  << (opt.checkpoint_path.empty() ? "" : "; rerun with the same --checkpoint to resume")
+                  << term::reset() << "\n";
+    }
+    return complete ? 0 : 1;
+}
+
+/**
+ * Incremental rescan mode (--rescan <state|list>).
+ *
+ * The input is a sweep state (a --checkpoint file of a finished sweep)
+ * or a plain list of responders together with --sweep <cidr>. Previous
+ * responders are re-probed at --rate, the rest of the range at
+ * --background-rate, and only changes are printed, as they are found:
+ * "+ addr" for a new host, "- addr" for one that went away. With
+ * --checkpoint the new inventory is written there for the next run.
+ */
+static int run_rescan_mode(const CliOptions& opt) {
+    SweepState prev;
+    std::ifstream in(opt.rescan_path, std::ios::binary);
+    if (!in) {
+        std::cerr << "Cannot open " << opt.rescan_path << "\n";
+        return 1;
+    }
+
+    char magic[4] = {};
+    const bool is_state = in.read(magic, 4) && std::string_view(magic, 4) == "CPSW";
+    in.clear();
+    in.seekg(0);
+
+    SweepRange range;
+    if (!opt.sweep_range.empty() && !parse_sweep_range(opt.sweep_range, range)) {
+        std::cerr << "Invalid sweep range (a.b.c.d/len, len >= 8): " << opt.sweep_range << "\n";
+        return 1;
+    }
+
+    PrefixTrie exclude;
+    if (!load_exclusions(opt, exclude))
+        return 1;
+
+    if (is_state) {
+        if (!read_sweep_state(in, prev) || !prev.complete() ||
+            (!opt.sweep_range.empty() && !(prev.range == range))) {
+            std::cerr << opt.rescan_path
+                      << " is unreadable, unfinished or belongs to another range\n";
+            return 1;
+        }
+    } else {
+        if (opt.sweep_range.empty()) {
+            std::cerr << "A responder list needs --sweep <cidr> for the range\n";
+            return 1;
+        }
+        TargetTable table;
+        load_target_list(in, table, nullptr, &exclude);
+        std::vector<Address> alive;
+        alive.reserve(table.size());
+        for (TargetId id = 0; id < table.size(); ++id)
+            alive.push_back(table.addr(id));
+        prev = sweep_from_list(range, alive);
+    }
+
+    if (!init_engine(opt.ping.if_name)) {
+        std::cerr << "Failed to start the ICMP engine\n";
+        return 1;
+    }
+
+    RescanOptions ro;
+    ro.exclude        = &exclude;
+    ro.rate_pps       = opt.rate_pps;
+    ro.background_pps = opt.background_pps;
+    ro.timeout_ms     = opt.ping.timeout_ms;
+    ro.payload_size   = opt.ping.payload_size;
+    ro.ttl            = opt.ping.ttl;
+
+    auto print_delta = [&](const RescanDelta& d) {
+        if (opt.quiet || opt.summary)
+            return;
+        const std::string addr = Address::v4(prev.address(d.offset)).to_string();
+        if (d.change == RescanChange::NewlyAlive)
+            std::cout << term::green() << "+ " << addr << term::reset()
+                      << "  rtt=" << d.rtt_us / 1000.0 << "ms\n";
+        else
+            std::cout << term::red() << "- " << addr << term::reset() << "\n";
+        std::cout.flush();
+    };
+
+    auto watch = watch_interrupts();
+    auto t0 = std::chrono::steady_clock::now();
+    RescanResult res = run_rescan(prev, ro, print_delta, &keep_running);
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - t0).count();
+    warn_rx_drops();
+    shutdown_engine();
+
+    if (!opt.checkpoint_path.empty() && !save_sweep_state(res.state, opt.checkpoint_path))
+        std::cerr << "Failed to write " << opt.checkpoint_path << "\n";
+
+    size_t up = 0, down = 0, alive = 0;
+    for (const auto& d : res.deltas)
+        (d.change == RescanChange::NewlyAlive ? up : down)++;
+    for (uint64_t w : res.state.bitmap)
+        alive += static_cast<size_t>(std::popcount(w));
+
+    std::cout << up << " new, " << down << " gone, "
+              << alive << "/" << prev.range.size << " alive; "
+              << res.probes << " probes in " << ms << "ms\n";
+    if (!res.complete)
+        std::cout << term::yellow() << "Rescan interrupted; unprobed hosts keep their previous status"
+                  << term::reset() << "\n";
+    return res.complete ? 0 : 1;
+}
+
+/**
+ * Responder collection mode (<ip> --collect).
+ *
+ * Sends -c probes (default 1) to a broadcast or multicast address, -i
+ * apart, and keeps each one open for the full timeout. Every host is
+ * printed the first time it answers; the summary counts distinct
+ * responders over all rounds.
+ */
+static int run_collect_mode(const CliOptions& opt) {
+    auto addr = Address::parse(opt.ip);
+    if (!addr || !addr->is_v4()) {
+        std::cerr << "Invalid IPv4 address: " << opt.ip << "\n";
+        return 1;
+    }
+
+    if (!init_engine(opt.ping.if_name)) {
+        std::cerr << "Failed to start the ICMP engine\n";
+        return 1;
+    }
+
+    auto watch = watch_interrupts();
+    const int rounds = opt.count > 0 ? opt.count : 1;
+    std::vector<Address> seen;
+    int sent = 0;
+
+    for (; sent < rounds && keep_running; ++sent) {
+        if (sent > 0) {
+            sleep_until_or_stop(std::chrono::steady_clock::now() +
+                                std::chrono::milliseconds(opt.interval_ms));
+            if (!keep_running)
+                break;
+        }
+
+        // CTRL+C ends the listening window early with what came in so far
+        CollectResult res = ping_collect_engine(*addr, opt.ping.timeout_ms,
+                                                opt.ping.payload_size, opt.ping.ttl,
+                                                g_stop.get_token());
+        if (!res.error_msg.empty() && res.error_msg != "Timeout" &&
+            res.error_msg != "Cancelled") {
+            std::cerr << "Probe failed: " << res.error_msg << "\n";
+            break;
+        }
+
+        for (const auto& r : res.responders) {
+            if (std::find(seen.begin(), seen.end(), r.addr) != seen.end())
+                continue;
+            seen.push_back(r.addr);
+            if (!opt.quiet && !opt.summary)
+                std::cout << r.addr.to_string() << "  rtt=" << r.rtt_us / 1000.0
+                          << "ms ttl=" << r.ttl << "\n";
+        }
+    }
+    shutdown_engine();
+
+    std::cout << seen.size() << " responder(s) to " << opt.ip << " over "
+              << sent << " probe(s)\n";
+    return seen.empty() ? 1 : 0;
+}
+
+/**
+ * Availability report mode (--availability <outage-log>).
+ *
+ * Reads a log written by --outage-log and prints per-target time in
+ * each state plus availability (up + degraded) and SLO (up only) over
+ * the last --window seconds, or over the whole log.
+ */
+static int run_availability(const CliOptions& opt) {
+    std::ifstream in(opt.availability_log);
+    if (!in) {
+        std::cerr << "Cannot open outage log: " << opt.availability_log << "\n";
+        return 1;
+    }
+
+    auto log = read_outage_log(in);
+    if (log.empty()) {
+        std::cerr << "No records in " << opt.availability_log << "\n";
+        return 1;
+    }
+
+    int64_t to   = OutageTracker::now_ms();
+    int64_t from = 0;
+    if (opt.window_s > 0) {
+        from = to - static_cast<int64_t>(opt.window_s) * 1000;
+    } else {
+        from = to = log.front().start_ms;
+        for (const auto& r : log) {
+            from = std::min(from, r.start_ms);
+            to   = std::max(to, r.end_ms);
+        }
+    }
+
+    std::vector<std::string> targets;
+    for (const auto& r : log) {
+        if (std::find(targets.begin(), targets.end(), r.target) == targets.end())
+            targets.push_back(r.target);
+    }
+
+    std::cout << "Availability over " << (to - from) / 1000.0 << "s\n";
+    for (const auto& t : targets) {
+        auto rep = availability(log, t, from, to);
+        std::cout << t << ": availability " << rep.availability_pct
+                  << "%, slo " << rep.slo_pct << "% (down "
+                  << rep.down_ms / 1000.0 << "s, degraded "
+                  << rep.degraded_ms / 1000.0 << "s)\n";
+    }
+
+    auto all = availability(log, "", from, to);
+    std::cout << "all: availability " << all.availability_pct
+              << "%, slo " << all.slo_pct << "%\n";
+    return 0;
 }
 
+/**
+ * Offline replay mode (--replay <pcapng>).
+ *
+ * Rebuilds the echo exchanges of a capture (written by --pcap, or any
+ * raw-IPv4 pcapng) and prints the regular summary for each target.
+ */
+static int run_replay(const CliOptions& opt) {
+    std::ifstream in(opt.replay_path, std::ios::binary);
+    std::vector<CapturedPacket> packets;
+    if (!in || !read_pcapng(in, packets)) {
+        std::cerr << "Cannot read capture: " << opt.replay_path << "\n";
+        return 1;
+    }
+
+    auto targets = replay_capture(packets);
+    if (targets.empty()) {
+        std::cerr << "No echo requests in " << opt.replay_path << "\n";
+        return 1;
+    }
+
+    for (const auto& t : targets) {
+        ProbeLog log;
+        log.reserve(t.probes.size());
+        for (const auto& p : t.probes)
+            log.emplace_back(p);
+        print_summary(t.target.to_string(), static_cast<int>(log.size()), log);
+    }
+    return 0;
+}
+
+/**
+ * Packet capture of one run (--pcap <path>).
+ *
+ * The writer is attached to the engine for the whole run and detached
+ * before it is closed. Single-target modes start the engine only for
+ * the capture, so they shut it down here as well.
+ */
+struct RunCapture {
+    PcapngWriter writer;
+    bool own_engine{false};
+
+    ~RunCapture() {
+        if (own_engine)
+            shutdown_engine();
+        set_engine_capture(nullptr);
+        writer.close();
+        if (writer.dropped() > 0)
+            std::cerr << writer.dropped() << " packet(s) dropped from the capture\n";
+    }
+};
+
 /**
  * Main execution entry for CLI ping.
  *
@@ -52,11 +1029,87 @@ int run_ping(const CliOptions& opt) {
     term::g_enabled = !opt.no_color;
     term::enable_vt();
 
+    // -------------------------------------------------------------
+    // PACKET CAPTURE / REPLAY
+    // -------------------------------------------------------------
+    if (!opt.replay_path.empty())
+        return run_replay(opt);
+
+    RunCapture capture;
+    if (!opt.pcap_path.empty()) {
+        // Workers are forked: no writer thread may exist at that point
+        if (!opt.targets_path.empty() && opt.workers >= 0) {
+            std::cerr << "--pcap cannot be combined with --workers\n";
+            return 1;
+        }
+        if (!capture.writer.open(opt.pcap_path)) {
+            std::cerr << "Cannot create capture file: " << opt.pcap_path << "\n";
+            return 1;
+        }
+        set_engine_capture(&capture.writer);
+    }
+
+    // Paced sends keep working without it, from the engine's pacer thread
+    if (opt.txtime && !set_engine_txtime(true))
+        std::cerr << term::yellow() << "SO_TXTIME not available, pacing in userspace"
+                  << term::reset() << "\n";
+
+    if (opt.tsc && !set_engine_tsc(true))
+        std::cerr << term::yellow() << "No usable invariant TSC, timestamps stay on steady_clock"
+                  << term::reset() << "\n";
+
+    // -------------------------------------------------------------
+    // FLOOD MODE
+    // -------------------------------------------------------------
+    if (opt.flood)
+        return run_flood_mode(opt);
+
+    // -------------------------------------------------------------
+    // DISTRIBUTED AGENTS
+    // -------------------------------------------------------------
+    if (opt.agent_port >= 0)
+        return run_agent_mode(opt);
+
+    if (!opt.targets_path.empty() && !opt.agents.empty())
+        return run_coordinator_mode(opt);
+
+    // -------------------------------------------------------------
+    // MULTI-TARGET MONITOR MODE
+    // -------------------------------------------------------------
+    if (!opt.rescan_path.empty())
+        return run_rescan_mode(opt);
+
+    if (!opt.sweep_range.empty())
+        return run_sweep_mode(opt);
+
+    if (!opt.targets_path.empty() && !opt.matrix_sources.empty())
+        return run_matrix_mode(opt);
+
+    if (!opt.targets_path.empty() && opt.workers >= 0)
+        return run_sharded_mode(opt);
+
+    if (!opt.targets_path.empty())
+        return opt.deadline_ms > 0 ? run_batch(opt) : run_monitor(opt);
+
+    // -------------------------------------------------------------
+    // AVAILABILITY REPORT
+    // -------------------------------------------------------------
+    if (!opt.availability_log.empty())
+        return run_availability(opt);
+
+    if (opt.collect)
+        return run_collect_mode(opt);
+
+    // Single-target probes only go through the engine (and so into the
+    // capture) while it is running
+    if (capture.writer.is_open())
+        capture.own_engine = init_engine(opt.ping.if_name);
+
     // -------------------------------------------------------------
     // CONTINUOUS MODE
     // -------------------------------------------------------------
     if (opt.continuous) {
-        std::signal(SIGINT, handle_sigint);
+        auto watch = watch_interrupts();
 
         std::cout << "Pinging " << opt.ip
                   << " continuously, interval=" << opt.interval_ms << "ms"
@@ -66,12 +1119,75 @@ int run_ping(const CliOptions& opt) {
         long min_rtt = std::numeric_limits<long>::max();
         long max_rtt = std::numeric_limits<long>::min();
         long sum_rtt = 0;
-        std::vector<long> rtts;
+        // RTT series lives in a run-scoped arena, dropped in one shot
+        RunArena arena;
+        std::pmr::vector<long> rtts(arena.resource());
+
+        AnomalyDetector detector;
+        AnomalyState anomaly_state;
+        int anomalies[3] = {0, 0, 0};
+
+        // Probes run on a fixed grid of intended send times. A stalled
+        // probe (timeout, slow reply) makes the following ones late; their
+        // latency is also measured from the intended time so the tail
+        // reflects what a fixed-rate client would have seen. No slot is
+        // ever skipped (a late loop sends back to back), so the sample
+        // already carries the delay and needs no back-fill.
+        using SteadyClock = std::chrono::steady_clock;
+        const auto interval = std::chrono::milliseconds(opt.interval_ms);
+
+        LatencyHistogram raw_hist;
+        LatencyHistogram corrected_hist;
+
+        // Warmup once, ahead of the grid, so it neither counts as a probe
+        // nor delays the first intended slot
+        PingOptions ping = opt.ping;
+        ping.warmup = 0;
+        long warmup_rtt_us = -1;
+        if (opt.ping.warmup > 0) {
+            PingOptions warm = ping;
+            warm.retries = 1;
+            for (int w = 0; w < opt.ping.warmup && keep_running; ++w) {
+                auto r = ping_host(opt.ip, warm, g_stop.get_token());
+                if (r.reachable && !r.probes.empty()) {
+                    const auto& p = r.probes.front();
+                    warmup_rtt_us = p.rtt_us >= 0 ? p.rtt_us : p.rtt_ms * 1000L;
+                    break;
+                }
+            }
+        }
+        auto next_send = SteadyClock::now();
 
         while (keep_running && (opt.count < 0 || sent < opt.count)) {
             sent++;
 
-            auto res = ping_host(opt.ip, opt.ping);
+            const auto intended = next_send;
+            next_send += interval;
+
+            auto res = ping_host(opt.ip, ping, g_stop.get_token());
+            const auto done = SteadyClock::now();
+
+            // Interrupted mid-probe: that probe never got its chance
+            if (g_stop.stop_requested() && !res.reachable) {
+                sent--;
+                break;
+            }
+
+            if (opt.anomaly) {
+                // Feed the best probe of this attempt (or the failure)
+                PingProbeResult sample{};
+                for (const auto& p : res.probes) {
+                    if (p.success && (!sample.success || p.rtt_us < sample.rtt_us))
+                        sample = p;
+                }
+
+                AnomalyEvent ev[AnomalyDetector::kMaxEvents];
+                int n = detector.observe(anomaly_state, sample, ev);
+                for (int i = 0; i < n; ++i) {
+                    anomalies[static_cast<int>(ev[i].kind)]++;
+                    print_anomaly(opt.ip, ev[i]);
+                }
+            }
 
             if (res.reachable) {
                 received++;
@@ -82,6 +1198,19 @@ int run_ping(const CliOptions& opt) {
                 sum_rtt += res.rtt_ms;
                 rtts.push_back(res.rtt_ms);
 
+                long best_us = -1;
+                for (const auto& p : res.probes) {
+                    if (p.success && p.rtt_us >= 0 && (best_us < 0 || p.rtt_us < best_us))
+                        best_us = p.rtt_us;
+                }
+                if (best_us < 0) best_us = res.rtt_ms * 1000L;
+                auto since_intended = std::chrono::duration_cast<
+                    std::chrono::microseconds>(done - intended).count();
+
+                raw_hist.record(static_cast<uint64_t>(std::max(0L, best_us)));
+                corrected_hist.record(
+                    static_cast<uint64_t>(std::max<int64_t>(0, since_intended)));
+
                 std::cout << term::green() << "Reply from " << opt.ip
                           << term::reset() << " RTT=" << res.rtt_ms
                           << "ms TTL=" << res.ttl << "\n";
@@ -90,16 +1219,24 @@ int run_ping(const CliOptions& opt) {
                           << term::reset() << "\n";
             }
 
-            std::this_thread::sleep_for(
-                std::chrono::milliseconds(opt.interval_ms)
-            );
+            // Behind schedule: send the next probe right away
+            if (next_send > SteadyClock::now())
+                sleep_until_or_stop(next_send);
         }
 
         // Post-loop summary
         print_summary_continuous(
             opt.ip, sent, received,
-            min_rtt, max_rtt, sum_rtt, rtts
+            min_rtt, max_rtt, sum_rtt, rtts, warmup_rtt_us
         );
+        print_latency_percentiles(raw_hist, corrected_hist);
+
+        if (opt.anomaly) {
+            std::cout << "anomalies: "
+                      << anomalies[0] << " rtt shift(s), "
+                      << anomalies[1] << " jitter spike(s), "
+                      << anomalies[2] << " loss burst(s)\n";
+        }
 
         // Optional export
         if (!opt.export_path.empty()) {
@@ -117,38 +1254,33 @@ int run_ping(const CliOptions& opt) {
     // -------------------------------------------------------------
     // NORMAL MODE (single or multi-attempt)
     // -------------------------------------------------------------
-    PingResult res{};
     int total_attempts = (opt.count > 0)
         ? opt.count
         : std::max<int>(1, opt.ping.retries);
 
-    // Run attempts and merge probe data
-    for (int i = 0; i < total_attempts; ++i) {
-        auto attempt = ping_host(opt.ip, opt.ping);
+    auto watch = watch_interrupts();
 
-        // Append all probes from this attempt
-        res.probes.insert(
-            res.probes.end(),
-            attempt.probes.begin(),
-            attempt.probes.end()
-        );
+    // Detailed output streams each probe as it completes; the probe log
+    // itself is only kept when the summary needs it, in an arena sized
+    // for the whole run
+    const bool verbose = !opt.quiet && !opt.summary;
+    const size_t max_probes = opt.summary
+        ? static_cast<size_t>(total_attempts) * std::max(1, opt.ping.retries)
+        : 0;
 
-        // Track best RTT
-        if (attempt.reachable) {
-            if (!res.reachable || attempt.rtt_ms < res.rtt_ms) {
-                res = attempt;
-            }
-        }
-    }
+    RunArena arena(RunArena::bytes_for(max_probes));
+    ProbeLog probes(arena.resource());
+    probes.reserve(max_probes);
 
-    // Optional detailed per-attempt output
-    if (!opt.quiet && !opt.summary) {
+    if (verbose) {
         std::cout << "Pinging " << opt.ip
                   << " with " << total_attempts
                   << " attempt(s), timeout=" << opt.ping.timeout_ms << "ms\n";
+    }
 
-        int idx = 1;
-        for (const auto& probe : res.probes) {
+    int idx = 1;
+    auto on_probe = [&](const PingProbeResult& probe, int) {
+        if (verbose) {
             std::cout << "Attempt " << idx++ << ": ";
             if (probe.success) {
                 std::cout << "Reply, RTT=" << probe.rtt_ms
@@ -157,30 +1289,51 @@ int run_ping(const CliOptions& opt) {
                 std::cout << "Failed (" << probe.error_msg << ")\n";
             }
         }
+        if (opt.summary)
+            probes.emplace_back(probe);
+        return true;
+    };
+
+    // Run attempts, tracking the best RTT (CTRL+C keeps what completed).
+    // Warmup probes go out once, ahead of the first attempt.
+    PingResult best{};
+    PingOptions ping = opt.ping;
+    long warmup_rtt_us = -1;
+
+    for (int i = 0; i < total_attempts && keep_running.load(); ++i) {
+        auto attempt = ping_host(opt.ip, ping, on_probe, g_stop.get_token());
+        if (ping.warmup > 0) {
+            warmup_rtt_us = attempt.warmup_rtt_us;
+            ping.warmup   = 0;
+        }
+
+        if (attempt.reachable && (!best.reachable || attempt.rtt_ms < best.rtt_ms))
+            best = attempt;
     }
 
     // Final outcome
-    if (res.reachable) {
+    if (best.reachable) {
         if (opt.summary) {
             print_summary(
                 opt.ip,
-                static_cast<int>(res.probes.size()),
-                res.probes
+                static_cast<int>(probes.size()),
+                probes,
+                warmup_rtt_us
             );
 
             if (!opt.export_path.empty()) {
                 export_summary(
                     opt.export_path, opt.export_format,
                     opt.ip,
-                    static_cast<int>(res.probes.size()),
-                    res.probes,
+                    static_cast<int>(probes.size()),
+                    probes,
                     opt.export_append
                 );
             }
         } else {
             std::cout << term::green() << "Reply from " << opt.ip
-                      << term::reset() << " RTT=" << res.rtt_ms
-                      << "ms TTL=" << res.ttl << "\n";
+                      << term::reset() << " RTT=" << best.rtt_ms
+                      << "ms TTL=" << best.ttl << "\n";
         }
         return 0;
     }
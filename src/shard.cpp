@@ -0,0 +1,367 @@
+/**
+ * Multi-process scale-out: one engine per worker process.
+ *
+ * Wire format (worker -> coordinator pipe, native layout):
+ *   WireHeader
+ *   count x TargetRecord
+ *   LatencyHistogram raw, LatencyHistogram corrected
+ *   GroupRecord...  terminated by group == kNoGroup
+ */
+
+#include "cping/shard.hpp"
+
+#if defined(_WIN32)
+
+namespace cping {
+
+std::vector<std::vector<int>> shard_cpu_groups(int workers) {
+    return std::vector<std::vector<int>>(workers > 0 ? workers : 1);
+}
+
+bool run_sharded(const TargetTable&, GroupIndex*, const ShardOptions&,
+                 ShardedResult&, const std::atomic<bool>*)
+{
+    return false;       // No fork(); run one Monitor per process instead
+}
+
+} // namespace cping
+
+#else
+
+#include "cping/engine.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <type_traits>
+
+#include <errno.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+  #include <sched.h>
+#endif
+
+namespace cping {
+
+namespace {
+
+constexpr uint32_t kWireMagic = 0x53504330;     // "0CPS"
+constexpr int      kMaxNodes  = 1024;
+
+struct WireHeader {
+    uint32_t magic{kWireMagic};
+    uint32_t begin{0};              // First TargetId of the shard
+    uint32_t count{0};              // Targets in the shard
+    uint32_t reserved{0};
+};
+
+struct GroupRecord {
+    GroupId  group{kNoGroup};
+    uint64_t sent{0};
+    uint64_t received{0};
+    LatencyHistogram hist;
+};
+
+static_assert(std::is_trivially_copyable_v<TargetRecord>);
+static_assert(std::is_trivially_copyable_v<LatencyHistogram>);
+static_assert(std::is_trivially_copyable_v<GroupRecord>);
+
+bool write_all(int fd, const void* data, size_t len) {
+    auto* p = static_cast<const char*>(data);
+    while (len > 0) {
+        ssize_t n = ::write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p   += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool read_all(int fd, void* data, size_t len) {
+    auto* p = static_cast<char*>(data);
+    while (len > 0) {
+        ssize_t n = ::read(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p   += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+/** Parse a sysfs CPU list ("0-3,8,10-11"). */
+std::vector<int> parse_cpu_list(const std::string& s) {
+    std::vector<int> cpus;
+    size_t pos = 0;
+    while (pos < s.size()) {
+        size_t end = s.find(',', pos);
+        if (end == std::string::npos) end = s.size();
+
+        int lo = -1, hi = -1;
+        const std::string part = s.substr(pos, end - pos);
+        if (std::sscanf(part.c_str(), "%d-%d", &lo, &hi) == 2) {
+            for (int c = lo; c <= hi; ++c) cpus.push_back(c);
+        } else if (lo >= 0) {
+            cpus.push_back(lo);
+        }
+        pos = end + 1;
+    }
+    return cpus;
+}
+
+/** CPUs this process may run on, in ascending order. */
+std::vector<int> allowed_cpus() {
+    std::vector<int> cpus;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (::sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; ++c)
+            if (CPU_ISSET(c, &set)) cpus.push_back(c);
+    }
+#endif
+    if (cpus.empty()) {
+        long n = ::sysconf(_SC_NPROCESSORS_ONLN);
+        for (int c = 0; c < (n > 0 ? n : 1); ++c) cpus.push_back(c);
+    }
+    return cpus;
+}
+
+/** Allowed CPUs of each NUMA node that has any (Linux sysfs). */
+std::vector<std::vector<int>> numa_nodes() {
+    std::vector<std::vector<int>> nodes;
+#if defined(__linux__)
+    const auto allowed = allowed_cpus();
+    for (int n = 0; n < kMaxNodes; ++n) {
+        std::ifstream f("/sys/devices/system/node/node" + std::to_string(n) + "/cpulist");
+        if (!f) continue;
+
+        std::string line;
+        std::getline(f, line);
+
+        std::vector<int> cpus;
+        for (int c : parse_cpu_list(line))
+            if (std::binary_search(allowed.begin(), allowed.end(), c))
+                cpus.push_back(c);
+        if (!cpus.empty())
+            nodes.push_back(std::move(cpus));
+    }
+#endif
+    return nodes;
+}
+
+void pin_to(const std::vector<int>& cpus) {
+#if defined(__linux__)
+    if (cpus.empty()) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int c : cpus)
+        if (c >= 0 && c < CPU_SETSIZE) CPU_SET(c, &set);
+    ::sched_setaffinity(0, sizeof(set), &set);
+#else
+    (void)cpus;
+#endif
+}
+
+/**
+ * Worker process body: probe targets [begin, end) and report. Never
+ * returns; leaves with _exit() so no parent state (stdio buffers,
+ * static destructors) is flushed twice.
+ */
+[[noreturn]] void worker_main(const TargetTable& table, GroupIndex* groups,
+                              TargetId begin, TargetId end,
+                              const ShardOptions& opt, const std::vector<int>& cpus,
+                              int fd, const std::atomic<bool>* keep_running)
+{
+    if (opt.pin)
+        pin_to(cpus);
+
+    TargetTable local;
+    local.reserve(end - begin);
+    for (TargetId id = begin; id < end; ++id)
+        local.add(table.addr(id));
+
+    if (!init_engine(opt.if_name))
+        ::_exit(2);
+
+    Monitor mon(local, opt.monitor);
+    if (groups) {
+        mon.add_hook([groups, begin](TargetId id, const PingProbeResult& probe) {
+            groups->record(begin + id, probe);
+        });
+    }
+
+    const auto interval = std::chrono::milliseconds(opt.monitor.interval_ms);
+    for (int r = 0; (!keep_running || keep_running->load()) &&
+                    (opt.rounds < 0 || r < opt.rounds); ++r)
+        mon.run_for(interval, keep_running);
+
+    mon.wait_idle(std::chrono::milliseconds(opt.monitor.timeout_ms + 100));
+    shutdown_engine();
+
+    // -----------------------------------------------------------------
+    // Report
+    // -----------------------------------------------------------------
+    WireHeader h;
+    h.begin = begin;
+    h.count = end - begin;
+    bool ok = write_all(fd, &h, sizeof(h));
+
+    std::vector<TargetRecord> recs(local.size());
+    for (TargetId id = 0; id < local.size(); ++id)
+        recs[id] = { local.sent(id), local.lost(id), local.srtt_us(id), local.rttvar_us(id) };
+    ok = ok && write_all(fd, recs.data(), recs.size() * sizeof(TargetRecord));
+
+    const LatencyHistogram raw = mon.raw_latency();
+    const LatencyHistogram corrected = mon.corrected_latency();
+    ok = ok && write_all(fd, &raw, sizeof(raw)) && write_all(fd, &corrected, sizeof(corrected));
+
+    if (groups) {
+        const size_t n = groups->group_count();
+        for (GroupId g = 0; ok && g < n; ++g) {
+            GroupSummary s = groups->summary(g);
+            if (s.sent == 0) continue;
+
+            GroupRecord rec;
+            rec.group    = g;
+            rec.sent     = s.sent;
+            rec.received = s.received;
+            rec.hist     = groups->histogram(g);
+            ok = write_all(fd, &rec, sizeof(rec));
+        }
+    }
+
+    GroupRecord last;
+    ok = ok && write_all(fd, &last, sizeof(last));
+
+    ::close(fd);
+    ::_exit(ok ? 0 : 3);
+}
+
+/** Read one worker's report into `out` / `groups`. */
+bool collect(int fd, size_t table_size, GroupIndex* groups, ShardedResult& out) {
+    WireHeader h;
+    if (!read_all(fd, &h, sizeof(h)) || h.magic != kWireMagic ||
+        size_t(h.begin) + h.count > table_size)
+        return false;
+
+    if (!read_all(fd, out.targets.data() + h.begin, size_t(h.count) * sizeof(TargetRecord)))
+        return false;
+
+    LatencyHistogram raw, corrected;
+    if (!read_all(fd, &raw, sizeof(raw)) || !read_all(fd, &corrected, sizeof(corrected)))
+        return false;
+    out.raw.merge(raw);
+    out.corrected.merge(corrected);
+
+    for (;;) {
+        GroupRecord rec;
+        if (!read_all(fd, &rec, sizeof(rec)))
+            return false;
+        if (rec.group == kNoGroup)
+            return true;
+        if (groups)
+            groups->merge(rec.group, rec.sent, rec.received, rec.hist);
+    }
+}
+
+} // namespace
+
+
+// ============================================================================
+// CPU layout
+// ============================================================================
+std::vector<std::vector<int>> shard_cpu_groups(int workers) {
+    auto nodes = numa_nodes();
+    if (workers <= 0)
+        workers = nodes.empty() ? 1 : static_cast<int>(nodes.size());
+
+    if (static_cast<int>(nodes.size()) == workers)
+        return nodes;
+
+    // Contiguous core groups over the allowed CPUs
+    const auto cpus = allowed_cpus();
+    const size_t n = cpus.size();
+    std::vector<std::vector<int>> out(workers);
+
+    for (int w = 0; w < workers; ++w) {
+        if (n < static_cast<size_t>(workers)) {
+            out[w].push_back(cpus[w % n]);
+            continue;
+        }
+        for (size_t i = n * w / workers; i < n * (w + 1) / workers; ++i)
+            out[w].push_back(cpus[i]);
+    }
+    return out;
+}
+
+
+// ============================================================================
+// Coordinator
+// ============================================================================
+bool run_sharded(const TargetTable& table, GroupIndex* groups,
+                 const ShardOptions& opt, ShardedResult& out,
+                 const std::atomic<bool>* keep_running)
+{
+    out = ShardedResult{};
+    out.targets.resize(table.size());
+
+    if (table.size() == 0 || engine_available())
+        return false;
+
+    const auto layout = shard_cpu_groups(opt.workers);
+    const size_t k = std::min(layout.size(), table.size());
+
+    struct Worker { pid_t pid; int fd; };
+    std::vector<Worker> workers;
+
+    for (size_t w = 0; w < k; ++w) {
+        const auto begin = static_cast<TargetId>(table.size() * w / k);
+        const auto end   = static_cast<TargetId>(table.size() * (w + 1) / k);
+
+        int p[2];
+        if (::pipe(p) != 0)
+            break;
+
+        pid_t pid = ::fork();
+        if (pid == 0) {
+            ::close(p[0]);
+            for (const auto& other : workers)
+                ::close(other.fd);
+            worker_main(table, groups, begin, end, opt, layout[w], p[1], keep_running);
+        }
+
+        ::close(p[1]);
+        if (pid < 0) {
+            ::close(p[0]);
+            break;
+        }
+        workers.push_back({ pid, p[0] });
+    }
+
+    out.workers = static_cast<int>(workers.size());
+
+    for (const auto& w : workers) {
+        const bool ok = collect(w.fd, table.size(), groups, out);
+        ::close(w.fd);
+
+        int status = 0;
+        while (::waitpid(w.pid, &status, 0) < 0 && errno == EINTR) {}
+
+        if (ok && WIFEXITED(status) && WEXITSTATUS(status) == 0)
+            ++out.workers_ok;
+    }
+
+    return out.workers_ok > 0;
+}
+
+} // namespace cping
+
+#endif // _WIN32
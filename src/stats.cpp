@@ -4,9 +4,20 @@
 #include <limits>
 #include <cmath>
 #include <algorithm>
+#include <iomanip>
 
 using namespace cping;
 
+/**
+ * Warmup probe line, shared by both summary variants.
+ */
+static void print_warmup(long warmup_rtt_us) {
+    if (warmup_rtt_us < 0) return;
+    std::cout << "warmup rtt = " << std::fixed << std::setprecision(3)
+              << warmup_rtt_us / 1000.0 << " ms (excluded)\n"
+              << std::defaultfloat;
+}
+
 /**
  * Print a full summary block for classic (non-continuous) ping mode.
  *
@@ -17,18 +28,18 @@ using namespace cping;
  *  - standard deviation (mdev)
  *  - jitter (temporal variation)
  *
- * The `probes` vector preserves probe order exactly as sent.
+ * The `probes` log preserves probe order exactly as sent.
  */
 void print_summary(const std::string& ip, int sent,
-                   const std::vector<PingProbeResult>& probes)
+                   const ProbeLog& probes, long warmup_rtt_us)
 {
     int received = 0;
     long min_rtt = std::numeric_limits<long>::max();
     long max_rtt = std::numeric_limits<long>::min();
     long sum_rtt = 0;
 
-    // Store RTTs in temporal order
-    std::vector<long> rtts;
+    // Store RTTs in temporal order (same resource as the log)
+    std::pmr::vector<long> rtts(probes.get_allocator());
     rtts.reserve(probes.size());
 
     for (const auto& p : probes) {
@@ -48,6 +59,7 @@ void print_summary(const std::string& ip, int sent,
               << received << " received, "
               << loss << "% packet loss\n";
 
+    print_warmup(warmup_rtt_us);
     if (received == 0) return;
 
     const double avg = static_cast<double>(sum_rtt) / received;
@@ -96,7 +108,8 @@ void print_summary(const std::string& ip, int sent,
  */
 void print_summary_continuous(const std::string& ip, int sent, int received,
                               long min_rtt, long max_rtt, long sum_rtt,
-                              const std::vector<long>& rtts)
+                              std::span<const long> rtts,
+                              long warmup_rtt_us)
 {
     int loss = sent > 0 ? (100 - (received * 100 / sent)) : 100;
 
@@ -105,6 +118,7 @@ void print_summary_continuous(const std::string& ip, int sent, int received,
               << received << " received, "
               << loss << "% packet loss\n";
 
+    print_warmup(warmup_rtt_us);
     if (received == 0) return;
 
     const double avg = static_cast<double>(sum_rtt) / received;
@@ -119,7 +133,7 @@ void print_summary_continuous(const std::string& ip, int sent, int received,
     }
 
     // --- Median
-    auto sorted = rtts;
+    std::vector<long> sorted(rtts.begin(), rtts.end());
     std::sort(sorted.begin(), sorted.end());
     double median = (sorted.size() % 2 == 0)
         ? (sorted[sorted.size()/2 - 1] + sorted[sorted.size()/2]) / 2.0
@@ -139,3 +153,105 @@ void print_summary_continuous(const std::string& ip, int sent, int received,
               << stddev << "/"
               << jitter << " ms\n";
 }
+
+/**
+ * Print group rollups for the multi-target monitor.
+ *
+ * RTT values are kept in microseconds internally and shown in ms
+ * with three decimals, matching the precision of the histograms.
+ */
+void print_group_summary(const std::vector<GroupSummary>& groups)
+{
+    auto ms = [](double us) { return us / 1000.0; };
+
+    std::cout << "\n--- group statistics ---\n";
+    std::cout << std::left << std::setw(24) << "group"
+              << std::right << std::setw(8) << "members"
+              << std::setw(9) << "sent"
+              << std::setw(8) << "loss%"
+              << "  rtt min/avg/p50/p90/p99/max ms\n";
+
+    const auto flags = std::cout.flags();
+    const auto prec  = std::cout.precision();
+    std::cout << std::fixed << std::setprecision(3);
+
+    for (const auto& g : groups) {
+        std::cout << std::left << std::setw(24) << g.name
+                  << std::right << std::setw(8) << g.members
+                  << std::setw(9) << g.sent
+                  << std::setw(8) << std::setprecision(1) << g.loss_pct
+                  << std::setprecision(3) << "  ";
+
+        if (g.received == 0) {
+            std::cout << "-\n";
+            continue;
+        }
+
+        std::cout << ms(g.min_us) << "/" << ms(g.mean_us) << "/"
+                  << ms(g.p50_us) << "/" << ms(g.p90_us) << "/"
+                  << ms(g.p99_us) << "/" << ms(g.max_us) << "\n";
+    }
+
+    std::cout.flags(flags);
+    std::cout.precision(prec);
+}
+
+void print_latency_percentiles(const LatencyHistogram& raw,
+                               const LatencyHistogram& corrected)
+{
+    if (raw.count() == 0)
+        return;
+
+    auto row = [](const char* name, const LatencyHistogram& h) {
+        auto ms = [](uint64_t us) { return us / 1000.0; };
+        std::cout << std::left << std::setw(13) << name << std::right
+                  << ms(h.percentile_us(50)) << "/"
+                  << ms(h.percentile_us(90)) << "/"
+                  << ms(h.percentile_us(99)) << "/"
+                  << ms(h.percentile_us(99.9)) << "/"
+                  << ms(h.max_us()) << " ms (" << h.count() << " samples)\n";
+    };
+
+    const auto flags = std::cout.flags();
+    const auto prec  = std::cout.precision();
+    std::cout << std::fixed << std::setprecision(3);
+
+    std::cout << "latency p50/p90/p99/p99.9/max\n";
+    row("  raw", raw);
+    row("  corrected", corrected);
+
+    std::cout.flags(flags);
+    std::cout.precision(prec);
+}
+
+void print_flood_summary(const FloodStats& s)
+{
+    const auto flags = std::cout.flags();
+    const auto prec  = std::cout.precision();
+    std::cout << std::fixed << std::setprecision(1);
+
+    std::cout << "\n--- flood statistics ---\n";
+    if (s.invalid_targets)
+        std::cout << s.invalid_targets << " invalid target(s) skipped\n";
+    std::cout << s.sent << " sent, " << s.received << " received, "
+              << s.loss_pct << "% loss in " << std::setprecision(3)
+              << s.elapsed_s << "s\n";
+    std::cout << std::setprecision(0)
+              << "rate " << s.send_pps << " pps sent, "
+              << s.reply_pps << " pps answered\n";
+    std::cout << "window " << s.final_window << " final, "
+              << s.peak_window << " peak\n";
+
+    if (s.latency.count()) {
+        auto ms = [](uint64_t us) { return us / 1000.0; };
+        std::cout << std::setprecision(3)
+                  << "rtt min/p50/p99/max = "
+                  << ms(s.latency.min_us()) << "/"
+                  << ms(s.latency.percentile_us(50)) << "/"
+                  << ms(s.latency.percentile_us(99)) << "/"
+                  << ms(s.latency.max_us()) << " ms\n";
+    }
+
+    std::cout.flags(flags);
+    std::cout.precision(prec);
+}
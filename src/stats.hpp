@@ -2,6 +2,11 @@
 #include <string>
 #include <vector>
 #include "cping/ping.hpp"
+#include <span>
+#include "cping/arena.hpp"
+#include "cping/flood.hpp"
+#include "cping/groups.hpp"
+#include "cping/histogram.hpp"
 
 /**
  * Print summary statistics for classic ping mode.
@@ -12,10 +17,14 @@
  *  - standard deviation (mdev)
  *  - jitter (temporal)
  *  - packet loss
+ *
+ * A warmup RTT (>= 0) is printed on its own line and is not part of
+ * any of the statistics above.
  */
 void print_summary(const std::string& ip,
                    int sent,
-                   const std::vector<cping::PingProbeResult>& probes);
+                   const cping::ProbeLog& probes,
+                   long warmup_rtt_us = -1);
 
 /**
  * Print summary statistics for continuous ping mode.
@@ -29,4 +38,29 @@ void print_summary_continuous(const std::string& ip,
                               long min_rtt,
                               long max_rtt,
                               long sum_rtt,
-                              const std::vector<long>& rtts);
+                              std::span<const long> rtts,
+                              long warmup_rtt_us = -1);
+
+/**
+ * Print per-group rollups for multi-target monitor mode.
+ *
+ * One line per group: members, probes, loss and RTT percentiles.
+ * Input comes straight from GroupIndex::summaries(), no rescans.
+ */
+void print_group_summary(const std::vector<cping::GroupSummary>& groups);
+
+/**
+ * Print raw vs. coordinated-omission corrected latency percentiles.
+ *
+ * Raw is the measured RTT; corrected is measured from each probe's
+ * intended send time, so stalls inflate it the way they would for a
+ * fixed-rate client. A large gap between the two means the sender fell
+ * behind schedule during the run.
+ */
+void print_latency_percentiles(const cping::LatencyHistogram& raw,
+                               const cping::LatencyHistogram& corrected);
+
+/**
+ * Print the outcome of a flood run: rates, loss, window and latency.
+ */
+void print_flood_summary(const cping::FloodStats& stats);
@@ -0,0 +1,697 @@
+/**
+ * Resumable range sweeps: permutation order, responder bitmap and
+ * periodic checkpoints.
+ *
+ * In-flight probes occupy a ring of `window` slots indexed by send
+ * sequence. Each slot remembers the permutation state it was drawn from,
+ * so the checkpoint resume point is simply the state of the oldest slot
+ * that has not settled yet (the low watermark). A probe that was never
+ * answered for lack of a send (rejected, sendto() failure, shutdown) is
+ * undecided rather than silent: the sweep stops and resumes before it.
+ */
+
+#include "cping/sweep.hpp"
+#include "cping/address.hpp"
+#include "cping/engine.hpp"
+#include "cping/prefix_trie.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+
+namespace cping {
+
+namespace {
+
+constexpr int kMinPrefix = 8;
+
+/** Reply RTT in microseconds, clamped to the u32 record field. */
+uint32_t rtt_of(const PingProbeResult& probe) {
+    long us = probe.rtt_us >= 0 ? probe.rtt_us : probe.rtt_ms * 1000L;
+    return static_cast<uint32_t>(std::clamp<long>(us, 0, std::numeric_limits<uint32_t>::max()));
+}
+
+/**
+ * Ring slot of one probe in flight. Held by shared_ptr with the rest of
+ * the run so completion callbacks never outlive it.
+ */
+struct Slot {
+    uint64_t perm_before{0};            // Permutation state before this offset was drawn
+    uint32_t offset{0};
+    bool     settled{false};
+};
+
+struct SweepRun {
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::vector<Slot> ring;
+    std::vector<uint64_t> bitmap;
+    std::vector<SweepResponder> responders;
+
+    // Oldest probe that failed without a verdict (no such probe: undecided_seq = max)
+    uint64_t undecided_seq{std::numeric_limits<uint64_t>::max()};
+    uint64_t undecided_state{0};
+
+    bool undecided() const { return undecided_seq != std::numeric_limits<uint64_t>::max(); }
+
+    void on_done(const PingProbeResult& probe, uint64_t seq) {
+        std::lock_guard<std::mutex> lk(mtx);
+        Slot& s = ring[seq % ring.size()];
+        s.settled = true;
+
+        // Only a reply or a timeout says anything about the host
+        if (!probe.success && probe.error_msg != "Timeout") {
+            if (seq < undecided_seq) {
+                undecided_seq   = seq;
+                undecided_state = s.perm_before;
+            }
+            cv.notify_all();
+            return;
+        }
+
+        // A resumed sweep re-probes its last window: count each host once
+        uint64_t& word = bitmap[s.offset >> 6];
+        const uint64_t bit = uint64_t(1) << (s.offset & 63);
+        if (probe.success && !(word & bit)) {
+            word |= bit;
+            responders.push_back(SweepResponder{ s.offset, rtt_of(probe),
+                static_cast<uint8_t>(std::clamp(probe.ttl, 0, 255)) });
+        }
+        cv.notify_all();
+    }
+};
+
+// Little-endian integer I/O for the checkpoint format
+void put_u16(std::ostream& out, uint16_t v) {
+    char b[2] = { char(v & 0xFF), char(v >> 8) };
+    out.write(b, 2);
+}
+
+void put_u32(std::ostream& out, uint32_t v) {
+    char b[4];
+    for (int i = 0; i < 4; ++i) b[i] = char((v >> (8 * i)) & 0xFF);
+    out.write(b, 4);
+}
+
+void put_u64(std::ostream& out, uint64_t v) {
+    char b[8];
+    for (int i = 0; i < 8; ++i) b[i] = char((v >> (8 * i)) & 0xFF);
+    out.write(b, 8);
+}
+
+bool get_u16(std::istream& in, uint16_t& v) {
+    unsigned char b[2];
+    if (!in.read(reinterpret_cast<char*>(b), 2)) return false;
+    v = static_cast<uint16_t>(b[0] | (b[1] << 8));
+    return true;
+}
+
+bool get_u32(std::istream& in, uint32_t& v) {
+    unsigned char b[4];
+    if (!in.read(reinterpret_cast<char*>(b), 4)) return false;
+    v = 0;
+    for (int i = 0; i < 4; ++i) v |= uint32_t(b[i]) << (8 * i);
+    return true;
+}
+
+bool get_u64(std::istream& in, uint64_t& v) {
+    unsigned char b[8];
+    if (!in.read(reinterpret_cast<char*>(b), 8)) return false;
+    v = 0;
+    for (int i = 0; i < 8; ++i) v |= uint64_t(b[i]) << (8 * i);
+    return true;
+}
+
+size_t bitmap_words(uint64_t size) {
+    return static_cast<size_t>((size + 63) / 64);
+}
+
+bool test_bit(const std::vector<uint64_t>& bm, uint64_t i) {
+    return (bm[i >> 6] >> (i & 63)) & 1u;
+}
+
+void set_bit(std::vector<uint64_t>& bm, uint64_t i, bool on) {
+    const uint64_t bit = uint64_t(1) << (i & 63);
+    if (on) bm[i >> 6] |= bit; else bm[i >> 6] &= ~bit;
+}
+
+/**
+ * Shared state of one rescan; probe tags carry the offset in the low 32
+ * bits and the attempt number above.
+ */
+struct RescanRun {
+    std::mutex mtx;
+    std::condition_variable cv;
+    size_t outstanding{0};
+    int dead_retries{0};
+    std::vector<uint64_t> prev;                 // Previous inventory
+    std::vector<uint64_t> now;                  // Current inventory (starts as prev)
+    std::vector<uint64_t> measured;             // Replied during this run
+    std::vector<SweepResponder> fresh;
+    std::deque<std::pair<uint32_t, int>> retries;
+    std::vector<RescanDelta> pending;           // Not yet handed to on_delta
+    bool undecided{false};                      // A probe ended without a verdict
+
+    void on_done(const PingProbeResult& probe, uint64_t tag) {
+        const auto offset  = static_cast<uint32_t>(tag);
+        const auto attempt = static_cast<int>(tag >> 32);
+
+        std::lock_guard<std::mutex> lk(mtx);
+        const bool was = test_bit(prev, offset);
+
+        if (probe.success) {
+            if (!test_bit(measured, offset)) {
+                set_bit(measured, offset, true);
+                fresh.push_back(SweepResponder{ offset, rtt_of(probe),
+                    static_cast<uint8_t>(std::clamp(probe.ttl, 0, 255)) });
+            }
+            if (!was && !test_bit(now, offset)) {
+                set_bit(now, offset, true);
+                pending.push_back(RescanDelta{ offset, RescanChange::NewlyAlive, rtt_of(probe) });
+            }
+        } else if (probe.error_msg != "Timeout") {
+            // Send error, cancel or shutdown: says nothing about the host
+            undecided = true;
+        } else if (was && !test_bit(measured, offset)) {
+            if (attempt < dead_retries) {
+                retries.emplace_back(offset, attempt + 1);
+            } else {
+                set_bit(now, offset, false);
+                pending.push_back(RescanDelta{ offset, RescanChange::NewlyDead, 0 });
+            }
+        }
+
+        --outstanding;
+        cv.notify_all();
+    }
+};
+
+} // namespace
+
+
+// ============================================================================
+// Range and permutation
+// ============================================================================
+bool parse_sweep_range(std::string_view cidr, SweepRange& out) {
+    int prefix = 32;
+    const size_t slash = cidr.find('/');
+    if (slash != std::string_view::npos) {
+        auto len = cidr.substr(slash + 1);
+        auto [p, ec] = std::from_chars(len.data(), len.data() + len.size(), prefix);
+        if (ec != std::errc{} || p != len.data() + len.size() ||
+            prefix < kMinPrefix || prefix > 32)
+            return false;
+        cidr = cidr.substr(0, slash);
+    }
+
+    auto a = Address::parse(cidr);
+    if (!a || !a->is_v4())
+        return false;
+
+    const uint32_t host = (uint32_t(a->bytes[12]) << 24) | (uint32_t(a->bytes[13]) << 16) |
+                          (uint32_t(a->bytes[14]) << 8)  |  uint32_t(a->bytes[15]);
+    const uint64_t size = uint64_t(1) << (32 - prefix);
+    out.first = host & ~static_cast<uint32_t>(size - 1);
+    out.size  = size;
+    return true;
+}
+
+SweepPermutation::SweepPermutation(uint64_t n, uint64_t seed)
+    : n_(n),
+      mask_(std::bit_ceil(std::max<uint64_t>(n, 1)) - 1),
+      // Full period modulo 2^k: multiplier = 1 (mod 4), odd increment
+      a_(6364136223846793005ull),
+      c_(((seed << 1) | 1) & mask_),
+      x_((seed * 0x9E3779B97F4A7C15ull) & mask_)
+{
+    if (mask_ == 0) c_ = 0;
+}
+
+bool SweepPermutation::next(uint64_t& offset) {
+    if (emitted_ >= n_)
+        return false;
+    do {
+        x_ = (a_ * x_ + c_) & mask_;
+    } while (x_ >= n_);
+    ++emitted_;
+    offset = x_;
+    return true;
+}
+
+SweepState new_sweep(const SweepRange& range, uint64_t seed) {
+    SweepState st;
+    st.range      = range;
+    st.seed       = seed;
+    st.perm_state = SweepPermutation(range.size, seed).state();
+    st.bitmap.assign(bitmap_words(range.size), 0);
+    return st;
+}
+
+
+// ============================================================================
+// Run
+// ============================================================================
+bool run_sweep(SweepState& st, const SweepOptions& opt, const std::atomic<bool>* keep_running) {
+    if (st.bitmap.size() != bitmap_words(st.range.size))
+        st.bitmap.assign(bitmap_words(st.range.size), 0);
+    if (st.complete() || !engine_available())
+        return st.complete();
+
+    using Clock = std::chrono::steady_clock;
+
+    auto run = std::make_shared<SweepRun>();
+    run->ring.resize(static_cast<size_t>(std::max(1, opt.window)));
+    run->bitmap.swap(st.bitmap);
+    run->responders.swap(st.responders);
+
+    SweepPermutation perm(st.range.size, st.seed);
+    perm.restore(st.perm_state, st.done);
+
+    const uint64_t base = st.done;          // Settled before this run
+    uint64_t low  = 0;                      // Oldest unsettled sequence
+    uint64_t high = 0;                      // Next sequence to send
+
+    // Resume point: oldest unsettled slot, or the send cursor when idle,
+    // but never past an undecided probe. Called with run->mtx held.
+    auto resume_point = [&](uint64_t& state, uint64_t& done) {
+        while (low < high && run->ring[low % run->ring.size()].settled)
+            ++low;
+        if (run->undecided_seq < low) {
+            state = run->undecided_state;
+            done  = base + run->undecided_seq;
+            return;
+        }
+        state = low < high ? run->ring[low % run->ring.size()].perm_before : perm.state();
+        done  = base + low;
+    };
+
+    auto checkpoint = [&] {
+        SweepState snap;
+        snap.range = st.range;
+        snap.seed  = st.seed;
+        {
+            std::lock_guard<std::mutex> lk(run->mtx);
+            resume_point(snap.perm_state, snap.done);
+            snap.bitmap     = run->bitmap;
+            snap.responders = run->responders;
+        }
+        save_sweep_state(snap, opt.checkpoint_path);
+    };
+
+    const auto step = opt.rate_pps > 0
+        ? std::chrono::duration_cast<Clock::duration>(std::chrono::seconds(1)) / opt.rate_pps
+        : Clock::duration::zero();
+    const auto period = std::chrono::milliseconds(std::max(1, opt.checkpoint_ms));
+    auto next = Clock::now();
+    auto next_checkpoint = next + period;
+
+    ProbeRequest req;
+    req.timeout_ms   = opt.timeout_ms;
+    req.payload_size = opt.payload_size;
+    req.ttl          = opt.ttl;
+    req.priority     = opt.priority;
+
+    // ---------------------------------------------------------------------
+    // Sending phase
+    // ---------------------------------------------------------------------
+    while (!keep_running || keep_running->load()) {
+        {
+            // Window full: wait for the oldest probe to settle
+            std::unique_lock<std::mutex> lk(run->mtx);
+            uint64_t s, d;
+            resume_point(s, d);
+            while (high - low >= run->ring.size() && !run->undecided()) {
+                run->cv.wait_for(lk, std::chrono::milliseconds(50));
+                resume_point(s, d);
+            }
+            // A probe could not be sent: stop, the checkpoint resumes there
+            if (run->undecided())
+                break;
+        }
+
+        if (!opt.checkpoint_path.empty() && Clock::now() >= next_checkpoint) {
+            checkpoint();
+            next_checkpoint = Clock::now() + period;
+        }
+
+        const uint64_t before = perm.state();
+        uint64_t offset;
+        if (!perm.next(offset))
+            break;
+
+        // Excluded addresses keep their place in the sequence, settled unsent
+        const bool skip = opt.exclude && opt.exclude->contains_v4(st.address(offset));
+        const uint64_t seq = high++;
+        {
+            std::lock_guard<std::mutex> lk(run->mtx);
+            run->ring[seq % run->ring.size()] = Slot{ before, static_cast<uint32_t>(offset), skip };
+        }
+        if (skip)
+            continue;
+
+        // Sleep in >= 1 ms batches; the engine keeps the spacing within one
+        if (step != Clock::duration::zero()) {
+            if (next - Clock::now() >= std::chrono::milliseconds(1))
+                std::this_thread::sleep_until(next - std::chrono::milliseconds(1));
+            req.send_at = next;
+            // A stall (full window, slow checkpoint) must not turn into a burst
+            next = std::max(next + step, Clock::now());
+        }
+
+        req.addr = Address::v4(st.address(offset));
+        req.tag  = seq;
+
+        bool accepted = submit_probe(req,
+            [run](const PingProbeResult& probe, uint64_t tag) {
+                run->on_done(probe, tag);
+            },
+            AdmitMode::Block);
+
+        // Rejected (engine stopping): undecided, resume from here
+        if (!accepted) {
+            PingProbeResult probe{};
+            probe.error_msg = "Probe not accepted";
+            run->on_done(probe, seq);
+            break;
+        }
+    }
+
+    // Every accepted probe completes: reply, timeout or engine shutdown
+    {
+        std::unique_lock<std::mutex> lk(run->mtx);
+        uint64_t s, d;
+        resume_point(s, d);
+        while (low < high) {
+            run->cv.wait(lk);
+            resume_point(s, d);
+        }
+        st.perm_state = s;
+        st.done       = d;
+        st.bitmap.swap(run->bitmap);
+        st.responders.swap(run->responders);
+    }
+
+    if (!opt.checkpoint_path.empty())
+        save_sweep_state(st, opt.checkpoint_path);
+    return st.complete();
+}
+
+
+// ============================================================================
+// Checkpoint format
+// ============================================================================
+bool write_sweep_state(const SweepState& st, std::ostream& out) {
+    out.write("CPSW", 4);
+    put_u16(out, 1);
+    put_u16(out, 0);
+    put_u32(out, st.range.first);
+    put_u64(out, st.range.size);
+    put_u64(out, st.seed);
+    put_u64(out, st.perm_state);
+    put_u64(out, st.done);
+    put_u64(out, st.responders.size());
+
+    for (size_t i = 0; i < bitmap_words(st.range.size); ++i)
+        put_u64(out, i < st.bitmap.size() ? st.bitmap[i] : 0);
+
+    for (const auto& r : st.responders) {
+        put_u32(out, r.offset);
+        put_u32(out, r.rtt_us);
+        out.put(static_cast<char>(r.ttl));
+    }
+    return static_cast<bool>(out);
+}
+
+bool read_sweep_state(std::istream& in, SweepState& st) {
+    st = SweepState{};
+
+    char magic[4];
+    uint16_t version, reserved;
+    uint64_t count;
+    if (!in.read(magic, 4) || std::string(magic, 4) != "CPSW") return false;
+    if (!get_u16(in, version) || version != 1 || !get_u16(in, reserved)) return false;
+    if (!get_u32(in, st.range.first) || !get_u64(in, st.range.size) ||
+        !get_u64(in, st.seed) || !get_u64(in, st.perm_state) ||
+        !get_u64(in, st.done) || !get_u64(in, count))
+        return false;
+
+    // Same bounds parse_sweep_range() enforces
+    if (st.range.size == 0 || st.range.size > (uint64_t(1) << (32 - kMinPrefix)) ||
+        st.done > st.range.size || count > st.range.size)
+        return false;
+
+    st.bitmap.resize(bitmap_words(st.range.size));
+    for (auto& w : st.bitmap)
+        if (!get_u64(in, w)) return false;
+
+    st.responders.resize(static_cast<size_t>(count));
+    for (auto& r : st.responders) {
+        char ttl;
+        if (!get_u32(in, r.offset) || !get_u32(in, r.rtt_us) || !in.get(ttl))
+            return false;
+        if (r.offset >= st.range.size) return false;
+        r.ttl = static_cast<uint8_t>(ttl);
+    }
+    return true;
+}
+
+bool save_sweep_state(const SweepState& st, const std::string& path) {
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out || !write_sweep_state(st, out))
+            return false;
+        out.flush();
+        if (!out)
+            return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    return !ec;
+}
+
+SweepState sweep_from_list(const SweepRange& range, const std::vector<Address>& alive) {
+    SweepState st = new_sweep(range);
+    st.done = range.size;
+
+    for (const auto& a : alive) {
+        if (!a.is_v4()) continue;
+        const uint32_t host = (uint32_t(a.bytes[12]) << 24) | (uint32_t(a.bytes[13]) << 16) |
+                              (uint32_t(a.bytes[14]) << 8)  |  uint32_t(a.bytes[15]);
+        const uint64_t offset = uint64_t(host) - range.first;
+        if (host >= range.first && offset < range.size)
+            set_bit(st.bitmap, offset, true);
+    }
+    return st;
+}
+
+
+// ============================================================================
+// Incremental rescan
+// ============================================================================
+RescanResult run_rescan(const SweepState& previous, const RescanOptions& opt,
+                        const std::function<void(const RescanDelta&)>& on_delta,
+                        const std::atomic<bool>* keep_running)
+{
+    using Clock = std::chrono::steady_clock;
+
+    RescanResult res;
+    res.state       = new_sweep(previous.range, previous.seed);
+    res.state.done  = previous.range.size;
+
+    const uint64_t size = previous.range.size;
+    if (size == 0 || previous.bitmap.size() != bitmap_words(size) || !engine_available())
+        return res;
+
+    auto run = std::make_shared<RescanRun>();
+    run->dead_retries = std::max(0, opt.dead_retries);
+    run->prev = previous.bitmap;
+    run->now  = previous.bitmap;
+    run->measured.assign(previous.bitmap.size(), 0);
+
+    const size_t window = static_cast<size_t>(std::max(1, opt.window));
+    auto step_of = [](int pps) {
+        return pps > 0
+            ? std::chrono::duration_cast<Clock::duration>(std::chrono::seconds(1)) / pps
+            : Clock::duration::zero();
+    };
+    const auto fg_step = step_of(opt.rate_pps);
+    const auto bg_step = step_of(opt.background_pps);
+
+    // Hand out deltas on this thread, outside the lock
+    std::vector<RescanDelta> batch;
+    auto dispatch = [&] {
+        {
+            std::lock_guard<std::mutex> lk(run->mtx);
+            batch.swap(run->pending);
+        }
+        for (const auto& d : batch) {
+            res.deltas.push_back(d);
+            if (on_delta) on_delta(d);
+        }
+        batch.clear();
+    };
+
+    auto excluded = [&](uint64_t offset) {
+        return opt.exclude && opt.exclude->contains_v4(previous.address(offset));
+    };
+
+    // Previous responders in address order, then the rest in permutation order
+    uint64_t fg_pos = 0;
+    auto next_fg = [&](uint64_t& offset) {
+        while (fg_pos < size) {
+            const uint64_t word = previous.bitmap[fg_pos >> 6] >> (fg_pos & 63);
+            if (word == 0) {
+                fg_pos = (fg_pos | 63) + 1;
+                continue;
+            }
+            fg_pos += static_cast<uint64_t>(std::countr_zero(word));
+            if (fg_pos >= size) break;
+            offset = fg_pos++;
+            if (!excluded(offset))
+                return true;
+        }
+        return false;
+    };
+
+    SweepPermutation bg(size, previous.seed);
+    auto next_bg = [&](uint64_t& offset) {
+        while (bg.next(offset))
+            if (!test_bit(previous.bitmap, offset) && !excluded(offset))
+                return true;
+        return false;
+    };
+
+    ProbeRequest req;
+    req.timeout_ms   = opt.timeout_ms;
+    req.payload_size = opt.payload_size;
+    req.ttl          = opt.ttl;
+    req.priority     = opt.priority;
+
+    bool fg_done = false, bg_done = false, stopped = false;
+    bool bg_started = false;
+    auto fg_due = Clock::now();
+    auto bg_due = fg_due;
+
+    // ---------------------------------------------------------------------
+    // Sending phase
+    // ---------------------------------------------------------------------
+    for (;;) {
+        dispatch();
+        if (keep_running && !keep_running->load()) {
+            stopped = true;
+            break;
+        }
+
+        uint64_t offset = 0;
+        int attempt = 0;
+        bool have = false, foreground = true;
+        {
+            std::unique_lock<std::mutex> lk(run->mtx);
+            while (run->outstanding >= window)
+                run->cv.wait_for(lk, std::chrono::milliseconds(50));
+
+            // Retries of silent responders jump the queue
+            if (!run->retries.empty()) {
+                offset  = run->retries.front().first;
+                attempt = run->retries.front().second;
+                run->retries.pop_front();
+                have = true;
+            }
+        }
+
+        if (!have && !fg_done) {
+            have = next_fg(offset);
+            fg_done = !have;
+        }
+        if (!have && fg_done && !bg_done) {
+            if (!bg_started) {
+                bg_due = std::max(bg_due, Clock::now());
+                bg_started = true;
+            }
+            have = next_bg(offset);
+            bg_done = !have;
+            foreground = false;
+        }
+
+        if (!have) {
+            // Only retries can still turn up: wait for the last replies
+            std::unique_lock<std::mutex> lk(run->mtx);
+            if (run->outstanding == 0 && run->retries.empty())
+                break;
+            run->cv.wait_for(lk, std::chrono::milliseconds(10));
+            continue;
+        }
+
+        auto& due        = foreground ? fg_due : bg_due;
+        const auto& step = foreground ? fg_step : bg_step;
+        if (step != Clock::duration::zero()) {
+            if (due - Clock::now() >= std::chrono::milliseconds(1))
+                std::this_thread::sleep_until(due - std::chrono::milliseconds(1));
+            req.send_at = due;
+            due = std::max(due + step, Clock::now());
+        } else {
+            req.send_at = {};
+        }
+
+        req.addr = Address::v4(previous.address(offset));
+        req.tag  = offset | (uint64_t(attempt) << 32);
+
+        {
+            std::lock_guard<std::mutex> lk(run->mtx);
+            ++run->outstanding;
+        }
+
+        bool accepted = submit_probe(req,
+            [run](const PingProbeResult& probe, uint64_t tag) {
+                run->on_done(probe, tag);
+            },
+            AdmitMode::Block);
+
+        // Rejected (engine stopping): not a probe and not silence; the
+        // host keeps its previous status and the run ends incomplete
+        if (!accepted) {
+            std::lock_guard<std::mutex> lk(run->mtx);
+            --run->outstanding;
+            stopped = true;
+            break;
+        }
+        ++res.probes;
+    }
+
+    // Every accepted probe completes: reply, timeout or engine shutdown
+    {
+        std::unique_lock<std::mutex> lk(run->mtx);
+        run->cv.wait(lk, [&] { return run->outstanding == 0; });
+    }
+    dispatch();
+
+    // ---------------------------------------------------------------------
+    // New inventory: fresh records, plus old ones of hosts not re-probed
+    // ---------------------------------------------------------------------
+    std::lock_guard<std::mutex> lk(run->mtx);
+    res.state.bitmap     = run->now;
+    res.state.responders = run->fresh;
+    for (const auto& r : previous.responders) {
+        if (r.offset < size && test_bit(run->now, r.offset) && !test_bit(run->measured, r.offset))
+            res.state.responders.push_back(r);
+    }
+
+    // Retries left over on an interrupted run did not decide anything
+    res.complete = !stopped && !run->undecided && fg_done && bg_done && run->retries.empty();
+    return res;
+}
+
+} // namespace cping
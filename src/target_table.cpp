@@ -0,0 +1,186 @@
+/**
+ * Struct-of-arrays target table.
+ *
+ * Addresses are parsed once at load time; everything on the probe path
+ * works with the dense TargetId (or the stored Address) only.
+ */
+
+#include "cping/target_table.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace cping {
+
+// IPv4-mapped IPv6 prefix ::ffff:0:0/96
+static constexpr uint8_t kV4Mapped[12] = { 0,0,0,0, 0,0,0,0, 0,0,0xff,0xff };
+
+
+// ============================================================================
+// Loading / addressing
+// ============================================================================
+TargetId TargetTable::add(std::string_view ip) {
+    auto a = Address::parse(ip);
+    return a ? add(*a) : kInvalidTarget;
+}
+
+TargetId TargetTable::add(const Address& a) {
+    if (a.empty() || size() >= kInvalidTarget)
+        return kInvalidTarget;
+
+    addr_.push_back(a.bytes);
+    next_due_.push_back(0);
+    srtt_us_.push_back(0);
+    rttvar_us_.push_back(0);
+    sent_.push_back(0);
+    lost_.push_back(0);
+    hist_.push_back(kNoHistogram);
+    streak_.push_back(0);
+
+    return static_cast<TargetId>(size() - 1);
+}
+
+void TargetTable::reserve(size_t n) {
+    addr_.reserve(n);
+    next_due_.reserve(n);
+    srtt_us_.reserve(n);
+    rttvar_us_.reserve(n);
+    sent_.reserve(n);
+    lost_.reserve(n);
+    hist_.reserve(n);
+    streak_.reserve(n);
+}
+
+bool TargetTable::is_v4(TargetId id) const {
+    return std::memcmp(addr_[id].data(), kV4Mapped, sizeof(kV4Mapped)) == 0;
+}
+
+std::string TargetTable::address(TargetId id) const {
+    return addr(id).to_string();
+}
+
+Address TargetTable::addr(TargetId id) const {
+    Address a;
+    a.bytes  = addr_[id];
+    a.family = is_v4(id) ? 4 : 6;
+    return a;
+}
+
+
+// ============================================================================
+// Scheduling
+// ============================================================================
+size_t TargetTable::collect_due(int64_t now_us, int64_t interval_us,
+                                std::vector<TargetId>& out, size_t max,
+                                std::vector<int64_t>* intended,
+                                std::vector<uint32_t>* skipped)
+{
+    const size_t n = size();
+    if (n == 0 || max == 0) return 0;
+
+    size_t taken = 0;
+    size_t pos = scan_pos_ < n ? scan_pos_ : 0;
+
+    // One full lap at most; due times are ordered along the ring
+    while (taken < max && taken < n && next_due_[pos] <= now_us) {
+        // 0 = never probed: the schedule starts now
+        const int64_t start = next_due_[pos] > 0 ? next_due_[pos] : now_us;
+
+        int64_t next = start + interval_us;
+        uint32_t dropped = 0;
+        if (next <= now_us) {                                 // > 1 interval behind
+            dropped = static_cast<uint32_t>(std::min<int64_t>(
+                (now_us - start) / std::max<int64_t>(1, interval_us), UINT32_MAX));
+            next = now_us + interval_us;
+        }
+        if (next < tail_due_)  next = tail_due_;              // keep the ring ordered
+        next_due_[pos] = tail_due_ = next;
+
+        out.push_back(static_cast<TargetId>(pos));
+        if (intended) intended->push_back(start);
+        if (skipped)  skipped->push_back(dropped);
+        ++sent_[pos];
+        ++taken;
+        if (++pos == n) pos = 0;
+    }
+
+    scan_pos_ = pos;
+    return taken;
+}
+
+int64_t TargetTable::earliest_due() const {
+    if (next_due_.empty())
+        return std::numeric_limits<int64_t>::max();
+    return next_due_[scan_pos_ < size() ? scan_pos_ : 0];
+}
+
+
+// ============================================================================
+// Results
+// ============================================================================
+/**
+ * RFC 6298 smoothing (alpha = 1/8, beta = 1/4) in integer microseconds.
+ * srtt == 0 marks "no sample yet"; real samples are stored as >= 1 us.
+ */
+void TargetTable::record(TargetId id, const PingProbeResult& probe) {
+    if (!probe.success) {
+        ++lost_[id];
+        if (streak_[id] < std::numeric_limits<uint16_t>::max())
+            ++streak_[id];
+        return;
+    }
+
+    streak_[id] = 0;
+
+    long us = probe.rtt_us >= 0 ? probe.rtt_us
+            : probe.rtt_ms >= 0 ? probe.rtt_ms * 1000L
+            : 0;
+    uint32_t r = static_cast<uint32_t>(std::clamp<long>(us, 1, 0x7FFFFFFF));
+
+    uint32_t& srtt   = srtt_us_[id];
+    uint32_t& rttvar = rttvar_us_[id];
+
+    if (srtt == 0) {
+        srtt   = r;
+        rttvar = r / 2;
+    } else {
+        uint32_t err = srtt > r ? srtt - r : r - srtt;
+        rttvar = rttvar - rttvar / 4 + err / 4;
+        srtt   = srtt - srtt / 8 + r / 8;
+        if (srtt == 0) srtt = 1;
+    }
+
+    if (hist_[id] != kNoHistogram)
+        hist_pool_[hist_[id]].record(static_cast<uint64_t>(us > 0 ? us : 0));
+}
+
+
+// ============================================================================
+// Histograms
+// ============================================================================
+uint32_t TargetTable::attach_histogram(TargetId id) {
+    if (hist_[id] == kNoHistogram) {
+        hist_pool_.emplace_back();
+        hist_[id] = static_cast<uint32_t>(hist_pool_.size() - 1);
+    }
+    return hist_[id];
+}
+
+const LatencyHistogram* TargetTable::histogram(TargetId id) const {
+    return hist_[id] == kNoHistogram ? nullptr : &hist_pool_[hist_[id]];
+}
+
+size_t TargetTable::memory_bytes() const {
+    return addr_.capacity()      * sizeof(addr_[0])
+         + next_due_.capacity()  * sizeof(int64_t)
+         + srtt_us_.capacity()   * sizeof(uint32_t)
+         + rttvar_us_.capacity() * sizeof(uint32_t)
+         + sent_.capacity()      * sizeof(uint32_t)
+         + lost_.capacity()      * sizeof(uint32_t)
+         + hist_.capacity()      * sizeof(uint32_t)
+         + streak_.capacity()    * sizeof(uint16_t)
+         + hist_pool_.capacity() * sizeof(LatencyHistogram);
+}
+
+} // namespace cping
@@ -0,0 +1,45 @@
+#pragma once
+/**
+ * USDT tracepoints (provider "cping") on the engine and ping hot paths.
+ *
+ * Built on <sys/sdt.h> when CPING_USDT is defined (CMake option, on by
+ * default) and the header is installed. Each site compiles to a single
+ * nop plus an ELF note describing its arguments; bpftrace, perf or
+ * SystemTap patch the nop into a trap only while attached, so a site
+ * costs nothing on an untraced process. Without sdt.h the macros compile
+ * away and their arguments are never evaluated.
+ *
+ * Arguments must be integers or pointers and cheap to compute: they are
+ * materialised in registers even when nobody is tracing.
+ *
+ *   bpftrace -l 'usdt:/usr/lib/libcping.so:cping:*'
+ *
+ * Probes:
+ *   submit(tag, priority, mode)              submit_probe() validated a request (pre-admission)
+ *   send(seq, dst, bytes, result)            engine sendto()/sendmsg() returned
+ *   reply(id, seq, ttl, matched)             listener dispatched an Echo Reply
+ *   timeout(tag, waited_us)                  waiter expired without a reply
+ *   batch(messages, wait_ms)                 listener drained one poll() wakeup
+ *   oneshot_send(dst, bytes, result)         non-engine probe sent
+ *   oneshot_done(dst, success, rtt_us)       non-engine probe finished
+ *
+ * `dst` is the IPv4 address in network byte order (in_addr::s_addr).
+ */
+
+#if defined(CPING_USDT) && defined(__has_include)
+  #if __has_include(<sys/sdt.h>)
+    #include <sys/sdt.h>
+    #define CPING_HAVE_USDT 1
+  #endif
+#endif
+
+#if defined(CPING_HAVE_USDT)
+  #define CPING_TRACE2(name, a, b)          STAP_PROBE2(cping, name, a, b)
+  #define CPING_TRACE3(name, a, b, c)       STAP_PROBE3(cping, name, a, b, c)
+  #define CPING_TRACE4(name, a, b, c, d)    STAP_PROBE4(cping, name, a, b, c, d)
+#else
+  // Arguments stay referenced (no unused warnings) but are never evaluated
+  #define CPING_TRACE2(name, a, b)          do { if (false) { (void)(a); (void)(b); } } while (0)
+  #define CPING_TRACE3(name, a, b, c)       do { if (false) { (void)(a); (void)(b); (void)(c); } } while (0)
+  #define CPING_TRACE4(name, a, b, c, d)    do { if (false) { (void)(a); (void)(b); (void)(c); (void)(d); } } while (0)
+#endif
@@ -1,7 +1,40 @@
 #include "cping/ping.hpp"
+#include "cping/engine.hpp"
+#include "cping/agent.hpp"
+#include "cping/address.hpp"
+#include "cping/flood.hpp"
+#include "cping/admission.hpp"
+#include "cping/anomaly.hpp"
+#include "cping/arena.hpp"
+#include "cping/batch.hpp"
+#include "cping/capture.hpp"
+#include "cping/clock.hpp"
+#include "cping/groups.hpp"
+#include "cping/histogram.hpp"
+#include "cping/matrix.hpp"
+#include "cping/monitor.hpp"
+#include "cping/outage_log.hpp"
+#include "cping/prefix_trie.hpp"
+#include "cping/shard.hpp"
+#include "cping/sweep.hpp"
+#include "cping/target_table.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <string_view>
 #include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
 #include <vector>
 
 // Simple test framework
@@ -83,6 +116,1054 @@ bool test_options_ttl() {
     return true; 
 }
 
+bool test_admission_priority() {
+    cping::AdmissionControl adm(1);
+    if (!adm.try_acquire(cping::ProbePriority::Normal)) return false;
+    if (adm.try_acquire(cping::ProbePriority::High)) return false; // cap reached
+
+    std::vector<int> order;
+    adm.acquire_async(cping::ProbePriority::Bulk, [&](bool ok) { if (ok) order.push_back(2); });
+    adm.acquire_async(cping::ProbePriority::High, [&](bool ok) { if (ok) order.push_back(0); });
+    if (!order.empty()) return false;
+
+    adm.release();                 // High takes the slot despite queueing later
+    adm.release();                 // then Bulk
+    if (order != std::vector<int>{0, 2}) return false;
+
+    adm.release();
+    return adm.in_flight() == 0;
+}
+
+bool test_engine_async_loopback() {
+    if (!cping::init_engine()) return false;
+    cping::set_max_inflight(4);
+
+    // 127.0.0.2 is not an interface address, so it takes the engine path
+    std::atomic<int> ok{0}, done{0};
+    for (int i = 0; i < 16; ++i) {
+        cping::ProbeRequest req;
+        req.ip = "127.0.0.2";
+        req.timeout_ms = 500;
+        req.priority = (i % 2) ? cping::ProbePriority::Bulk : cping::ProbePriority::High;
+        cping::submit_probe(req, [&](const cping::PingProbeResult& r, uint64_t) {
+            if (r.success) ok++;
+            done++;
+        }, cping::AdmitMode::Callback);
+    }
+
+    auto until = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+    while (done.load() < 16 && std::chrono::steady_clock::now() < until)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    cping::set_max_inflight(0);
+
+    // An interface pin bypasses the (unbound) engine socket
+    cping::PingOptions pinned;
+    pinned.timeout_ms = 300;
+    pinned.if_name    = "lo";
+    auto lo = cping::ping_host("127.0.0.2", pinned);
+    cping::shutdown_engine();
+
+    return ok.load() == 16 && lo.reachable && !lo.probes.empty() &&
+           lo.probes[0].if_name == "lo";
+}
+
+bool test_latency_histogram() {
+    cping::LatencyHistogram h;
+    for (uint64_t us = 1; us <= 1000; ++us) h.record(us);
+
+    // Log-linear buckets: percentiles within ~6% of the exact value
+    auto near = [](uint64_t v, uint64_t exact) {
+        return v >= exact * 94 / 100 && v <= exact * 106 / 100;
+    };
+    if (!near(h.percentile_us(50), 500)) return false;
+    if (!near(h.percentile_us(99), 990)) return false;
+
+    cping::LatencyHistogram g;
+    g.record(5000);
+    g.merge(h);
+    return g.count() == 1001 && g.max_us() == 5000 && g.min_us() == 1;
+}
+
+bool test_target_table() {
+    cping::TargetTable t;
+    auto a = t.add("10.0.0.1");
+    auto b = t.add("2001:db8::1");
+    if (a != 0 || b != 1) return false;
+    if (t.add("not-an-ip") != cping::kInvalidTarget) return false;
+    if (!t.is_v4(a) || t.is_v4(b) || t.address(a) != "10.0.0.1") return false;
+
+    // Both due at t=0; afterwards nothing is due until the interval passes
+    std::vector<cping::TargetId> due;
+    if (t.collect_due(0, 1000, due, 16) != 2) return false;
+    if (t.collect_due(500, 1000, due, 16) != 0) return false;
+    if (t.collect_due(1000, 1000, due, 16) != 2) return false;
+
+    cping::PingProbeResult ok;
+    ok.success = true;
+    ok.rtt_us = 800;
+    t.attach_histogram(a);
+    t.record(a, ok);
+    t.record(a, cping::PingProbeResult{});
+
+    return t.srtt_us(a) == 800 && t.lost(a) == 1 && t.failure_streak(a) == 1
+        && t.sent(a) == 2 && t.histogram(a)->count() == 1
+        && cping::TargetTable::kBytesPerTarget <= 64;
+}
+
+bool test_monitor_loopback() {
+    if (!cping::init_engine()) return false;
+
+    cping::TargetTable t;
+    for (int i = 2; i < 6; ++i)
+        t.add("127.0.0." + std::to_string(i));
+
+    cping::MonitorOptions mo;
+    mo.interval_ms = 50;
+    mo.timeout_ms  = 200;
+    cping::Monitor m(t, mo);
+
+    // Completions may come from several threads but never overlap
+    std::atomic<int> inside{0};
+    bool overlapped = false;
+    m.add_hook([&](cping::TargetId, const cping::PingProbeResult&) {
+        if (inside.fetch_add(1) != 0) overlapped = true;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        inside.fetch_sub(1);
+    });
+
+    m.run_for(std::chrono::milliseconds(220));
+    m.wait_idle(std::chrono::milliseconds(500));
+    cping::shutdown_engine();
+
+    if (overlapped) return false;
+    for (cping::TargetId id = 0; id < t.size(); ++id) {
+        if (t.sent(id) < 3 || t.lost(id) != 0 || t.srtt_us(id) == 0)
+            return false;
+    }
+    return true;
+}
+
+bool test_group_rollups() {
+    std::istringstream list(
+        "10.0.0.1 site:a\n"
+        "10.0.0.2 site:a  # comment\n"
+        "10.0.1.1 site:b\n"
+        "2001:db8::1 site:b\n"
+        "garbage\n");
+
+    // IPv6 is counted and skipped: the engine cannot probe it
+    cping::TargetTable t;
+    cping::GroupIndex g;
+    size_t v6 = 0;
+    if (cping::load_target_list(list, t, &g, nullptr, &v6) != 3 || v6 != 1) return false;
+    if (g.group_count() != 4) return false;      // two /24s + two sites
+
+    cping::PingProbeResult ok;
+    ok.success = true;
+    ok.rtt_us = 1000;
+    g.record(0, ok);
+    g.record(1, cping::PingProbeResult{});
+    g.record(2, ok);
+
+    auto site_a = g.summary(g.group("site:a"));
+    auto net0   = g.summary(g.group("10.0.0.0/24"));
+    return site_a.members == 2 && site_a.sent == 2 && site_a.received == 1
+        && site_a.loss_pct == 50.0 && net0.p50_us == 1000
+        && g.summary(g.group("site:b")).loss_pct == 0.0;
+}
+
+bool test_anomaly_detector() {
+    cping::AnomalyDetector det;
+    cping::AnomalyState st;
+    cping::AnomalyEvent ev[cping::AnomalyDetector::kMaxEvents];
+    int shifts = 0, spikes = 0, bursts = 0;
+
+    auto feed = [&](bool ok, long us) {
+        cping::PingProbeResult p;
+        p.success = ok;
+        p.rtt_us = ok ? us : -1;
+        int n = det.observe(st, p, ev);
+        for (int i = 0; i < n; ++i) {
+            if (ev[i].kind == cping::AnomalyKind::RttLevelShift) shifts++;
+            if (ev[i].kind == cping::AnomalyKind::JitterSpike)   spikes++;
+            if (ev[i].kind == cping::AnomalyKind::LossBurst)     bursts++;
+        }
+    };
+
+    for (int i = 0; i < 40; ++i) feed(true, 10000 + (i % 3) * 100);
+    if (shifts || spikes || bursts) return false;      // stable baseline
+
+    feed(true, 60000);                                 // lone outlier
+    feed(true, 10000);
+    if (shifts != 0 || spikes == 0) return false;
+
+    for (int i = 0; i < 40; ++i) feed(true, 30000 + (i % 3) * 100);
+    if (shifts != 1) return false;                     // one level shift
+
+    for (int i = 0; i < 4; ++i) feed(false, 0);
+    return bursts == 1 && sizeof(cping::AnomalyState) <= 40;
+}
+
+bool test_coordinated_omission() {
+    // A 1 s stall under a 200 ms schedule stands for 5 late probes
+    cping::LatencyHistogram raw, corrected;
+    for (int i = 0; i < 95; ++i) {
+        raw.record(1000);
+        corrected.record_corrected(1000, 200000);
+    }
+    raw.record(1000000);
+    corrected.record_corrected(1000000, 200000);
+
+    if (raw.count() != 96 || corrected.count() != 100) return false;
+    if (raw.percentile_us(99) > 2000) return false;          // stall hidden
+    if (corrected.percentile_us(99) < 700000) return false;  // stall visible
+
+    // Late ticks keep targets on their intended grid
+    cping::TargetTable t;
+    t.add("192.0.2.1");
+    std::vector<cping::TargetId> due;
+    std::vector<int64_t> intended;
+    std::vector<uint32_t> skipped;
+    t.collect_due(1000, 1000, due, 4, &intended, &skipped);  // first: now
+    t.collect_due(2400, 1000, due, 4, &intended, &skipped);  // 400 us late
+    t.collect_due(9000, 1000, due, 4, &intended, &skipped);  // far behind
+    if (intended.size() != 3 || intended[1] != 2000 || intended[2] != 3000 ||
+        t.next_due(0) != 10000)
+        return false;
+    if (skipped.size() != 3 || skipped[0] != 0 || skipped[1] != 0 || skipped[2] != 6)
+        return false;
+
+    // End to end: late but on-grid probes are recorded once, and only
+    // slots dropped by a stall are back-filled
+    if (!cping::init_engine()) return false;
+
+    cping::TargetTable lo;
+    lo.add("127.0.0.2");
+    cping::MonitorOptions mo;
+    mo.interval_ms = 100;
+    mo.timeout_ms  = 500;
+    cping::Monitor m(lo, mo);
+
+    m.tick();
+    m.wait_idle(std::chrono::milliseconds(500));
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    m.tick();                                                 // 50 ms late
+    m.wait_idle(std::chrono::milliseconds(500));
+    bool on_time = m.raw_latency().count() == 2 &&
+                   m.corrected_latency().count() == 2;
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(350));
+    m.tick();                                                 // 2-3 slots dropped
+    m.wait_idle(std::chrono::milliseconds(500));
+    cping::shutdown_engine();
+
+    auto extra = m.corrected_latency().count() - m.raw_latency().count();
+    return on_time && m.raw_latency().count() == 3 && extra >= 2 && extra <= 3;
+}
+
+bool test_flood_loopback() {
+    if (!cping::init_engine()) return false;
+
+    cping::FloodOptions fo;
+    fo.targets = { "127.0.0.2", "not-an-ip", "::1" };
+    fo.max_probes = 2000;
+    fo.duration_ms = 5000;
+    fo.timeout_ms = 500;
+    fo.max_window = 64;       // stay well inside the default socket buffer
+
+    auto s = cping::run_flood(fo);
+    cping::shutdown_engine();
+
+    // Clean loopback: no loss, the window opens up beyond its start; the
+    // bad targets are set aside instead of failing every other send
+    return s.sent == 2000 && s.received == 2000 && s.invalid_targets == 2 &&
+           s.peak_window > fo.initial_window && s.send_pps > 0;
+}
+
+bool test_batch_deadline() {
+    if (!cping::init_engine()) return false;
+
+    std::vector<std::string> targets(16, "127.0.0.2");
+    targets.push_back("not-an-ip");
+
+    cping::BatchOptions bo;
+    bo.deadline_ms = 200;
+    bo.probe_timeout_ms = 1000;
+
+    auto t0 = std::chrono::steady_clock::now();
+    auto res = cping::ping_batch(targets, bo);
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - t0).count();
+
+    // Probes still queued behind the in-flight cap at the deadline are
+    // cancelled, not sent late
+    cping::set_max_inflight(1);
+    bo.deadline_ms = 100;
+    auto held = cping::ping_batch(std::vector<std::string>(8, "10.255.255.1"), bo);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const int late = cping::engine_inflight();
+    cping::set_max_inflight(0);
+    cping::shutdown_engine();
+
+    int replied = 0;
+    for (const auto& r : res)
+        if (r.status == cping::BatchStatus::Replied) replied++;
+    bool pending = true;
+    for (const auto& r : held)
+        pending = pending && r.status == cping::BatchStatus::Pending;
+
+    return res.size() == 17 && replied == 16 && ms <= 260 &&
+           res.back().status == cping::BatchStatus::Failed &&
+           pending && late == 0;
+}
+
+bool test_cancellation() {
+    using namespace std::chrono;
+    auto elapsed_ms = [](steady_clock::time_point t0) {
+        return duration_cast<milliseconds>(steady_clock::now() - t0).count();
+    };
+
+    // Blocking API without the engine: the retry loop and the receive wait
+    std::stop_source src;
+    std::thread canceller([&] {
+        std::this_thread::sleep_for(milliseconds(50));
+        src.request_stop();
+    });
+
+    cping::PingOptions opt;
+    opt.timeout_ms = 3000;
+    opt.retries = 3;
+
+    auto t0 = steady_clock::now();
+    auto res = cping::ping_host("10.255.255.1", opt, src.get_token());
+    canceller.join();
+    if (res.reachable || elapsed_ms(t0) > 500) return false;
+
+    // Engine: the probe completes at once and its slot is freed
+    if (!cping::init_engine()) return false;
+
+    std::stop_source src2;
+    std::atomic<bool> done{false};
+    std::string why;
+
+    cping::ProbeRequest req;
+    req.ip = "10.255.255.1";
+    req.timeout_ms = 3000;
+    req.stop = src2.get_token();
+    cping::submit_probe(req, [&](const cping::PingProbeResult& r, uint64_t) {
+        why = r.error_msg;
+        done = true;
+    });
+
+    std::this_thread::sleep_for(milliseconds(50));
+    bool was_inflight = cping::engine_inflight() == 1;
+
+    t0 = steady_clock::now();
+    src2.request_stop();
+    bool quick = done.load() && elapsed_ms(t0) < 50;
+    bool freed = cping::engine_inflight() == 0;
+
+    // Already-stopped token: rejected or cancelled without waiting
+    auto p = cping::ping_once_engine("10.255.255.1", 3000, 0, -1,
+                                     cping::ProbePriority::Normal, src2.get_token());
+    cping::shutdown_engine();
+
+    return was_inflight && quick && freed && why == "Cancelled" &&
+           p.error_msg == "Cancelled";
+}
+
+bool test_streaming_probes() {
+    cping::PingOptions opt;
+    opt.timeout_ms = 50;
+    opt.retries = 4;
+
+    // Every attempt is delivered, nothing is stored
+    int calls = 0, last = -1;
+    auto res = cping::ping_host("10.255.255.1", opt,
+        [&](const cping::PingProbeResult& p, int attempt) {
+            calls++;
+            last = attempt;
+            return !p.success;
+        });
+    if (calls != 4 || last != 3 || !res.probes.empty()) return false;
+
+    // Returning false stops the remaining attempts
+    calls = 0;
+    cping::ping_host("10.255.255.1", opt,
+        [&](const cping::PingProbeResult&, int) { calls++; return false; });
+    return calls == 1;
+}
+
+bool test_address_parsing() {
+    // Same acceptance rules as inet_pton
+    for (const char* ok : { "0.0.0.0", "127.0.0.1", "255.255.255.255", "10.0.0.9",
+                            "::1", "2001:db8::1", "::ffff:192.0.2.1" })
+        if (!cping::Address::parse(ok)) return false;
+    for (const char* bad : { "", "1.2.3", "1.2.3.4.5", "256.0.0.1", "01.2.3.4",
+                             "1.2.3.4 ", "1..3.4", "1.2.3.-4", "host", "1:2:3" })
+        if (cping::Address::parse(bad)) return false;
+
+    auto a = cping::Address::parse("192.0.2.10");
+    if (!a || !a->is_v4() || a->to_string() != "192.0.2.10") return false;
+    if (*a != cping::Address::v4(0xC000020A)) return false;
+
+    // Bulk list: comments, blanks, labels and junk lines
+    std::vector<cping::Address> list;
+    size_t rejected = 0;
+    size_t n = cping::parse_address_list(
+        "# targets\n192.0.2.1 edge\n\n  2001:db8::2\r\nnot-an-ip\n198.51.100.7",
+        list, &rejected);
+    if (n != 3 || rejected != 1 || list[1].to_string() != "2001:db8::2") return false;
+
+    // Table round trip and a probe through the pre-parsed overload
+    cping::TargetTable table;
+    auto id = table.add(list[2]);
+    if (table.addr(id) != list[2] || table.address(id) != "198.51.100.7") return false;
+
+    cping::PingOptions opt;
+    opt.timeout_ms = 1000;
+    return cping::ping_host(*cping::Address::parse("127.0.0.1"), opt).reachable;
+}
+
+bool test_warmup() {
+    cping::PingOptions opt;
+    opt.timeout_ms = 1000;
+    opt.retries = 3;
+    opt.stop_on_first_success = false;
+    opt.warmup = 2;
+
+    // Warmup reply is reported apart; every attempt is still measured
+    int calls = 0;
+    auto res = cping::ping_host("127.0.0.1", opt,
+        [&](const cping::PingProbeResult&, int) { calls++; return true; });
+    if (!res.reachable || res.warmup_rtt_us < 0 || calls != 3) return false;
+
+    // No reply: every warmup probe is spent, nothing is reported
+    opt.timeout_ms = 50;
+    opt.retries = 1;
+    auto t0 = std::chrono::steady_clock::now();
+    res = cping::ping_host("10.255.255.1", opt);
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - t0).count();
+
+    return res.warmup_rtt_us == -1 && res.probes.size() == 1 && ms >= 140;
+}
+
+bool test_reachability_matrix() {
+    std::vector<cping::MatrixSource> sources(2);
+    cping::MatrixSource bogus;
+    if (!cping::parse_matrix_source("127.0.0.1", sources[0]) ||
+        !cping::parse_matrix_source("lo", sources[1]) ||
+        cping::parse_matrix_source("no-such-if0", bogus))
+        return false;
+
+    std::vector<cping::Address> targets = {
+        *cping::Address::parse("127.0.0.2"), *cping::Address::parse("10.255.255.1") };
+
+    if (!cping::init_engine()) return false;
+    cping::MatrixOptions mo;
+    mo.probes = 3;
+    mo.timeout_ms = 100;
+    auto m = cping::run_matrix(sources, targets, mo);
+    cping::shutdown_engine();
+
+    // Both sources reach loopback, nobody reaches the blackhole
+    for (size_t s = 0; s < 2; ++s) {
+        if (m.at(s, 0).sent != 3 || m.at(s, 0).received != 3) return false;
+        if (m.at(s, 1).received != 0 || m.at(s, 1).loss_pct() != 100.0) return false;
+        if (m.at(s, 0).p50_us > m.at(s, 0).max_us) return false;
+    }
+
+    // Binary round trip
+    std::stringstream bin;
+    cping::ReachabilityMatrix back;
+    if (!cping::write_matrix_binary(m, bin) || !cping::read_matrix_binary(bin, back))
+        return false;
+    if (back.sources != m.sources || back.targets[1] != "10.255.255.1" ||
+        back.at(1, 0).max_us != m.at(1, 0).max_us)
+        return false;
+
+    // A header claiming more than the data holds is refused before any
+    // allocation: one source too many, then an absurd shape
+    std::string bytes = bin.str();
+    bytes[8] = 3;
+    std::istringstream more(bytes);
+    bytes[8] = bytes[9] = bytes[10] = bytes[11] = '\xff';
+    std::istringstream huge(bytes);
+    return !cping::read_matrix_binary(more, back) && back.cells.empty() &&
+           !cping::read_matrix_binary(huge, back) && back.cells.empty();
+}
+
+bool test_sharded_monitor() {
+    std::istringstream list(
+        "127.0.0.2 a\n127.0.0.3 a\n127.0.0.4 a\n127.0.0.5 b\n"
+        "127.0.0.6 b\n127.0.0.7 b\n10.255.255.1 dead\n");
+    cping::TargetTable table;
+    cping::GroupIndex groups;
+    if (cping::load_target_list(list, table, &groups) != 7) return false;
+
+    cping::ShardOptions so;
+    so.workers = 3;
+    so.rounds  = 2;
+    so.monitor.interval_ms = 50;
+    so.monitor.timeout_ms  = 100;
+
+    cping::ShardedResult res;
+    if (!cping::run_sharded(table, &groups, so, res)) return false;
+    if (res.workers != 3 || res.workers_ok != 3) return false;
+
+    // Every target was probed by exactly one worker; records land by id
+    for (cping::TargetId id = 0; id < table.size(); ++id)
+        if (res.targets[id].sent == 0) return false;
+    if (res.targets[6].lost != res.targets[6].sent || res.targets[0].srtt_us == 0) return false;
+
+    // Group rollups and histograms merged across workers
+    auto a = groups.summary(groups.group("a"));
+    auto dead = groups.summary(groups.group("dead"));
+    return a.sent >= 6 && a.received == a.sent && dead.loss_pct == 100.0 &&
+           res.raw.count() == a.received + groups.summary(groups.group("b")).received;
+}
+
+bool test_distributed_agents() {
+    if (!cping::init_engine()) return false;
+
+    // Two vantage points on loopback, each serving on its own thread
+    std::atomic<bool> serving{true};
+    cping::AgentOptions ao;
+    ao.bind       = "0.0.0.0";
+    ao.port       = 0;
+    ao.batch_size = 1;
+    cping::ProbeAgent open(ao);
+    ao.secret     = "s3cret";
+    cping::ProbeAgent a(ao), b(ao), c(ao);
+    if (open.listen() || !a.listen() || !b.listen() || !c.listen()) {
+        cping::shutdown_engine();
+        return false;
+    }
+    std::thread ta([&] { a.serve(&serving); });
+    std::thread tb([&] { b.serve(&serving); });
+    std::thread tc([&] { c.serve(&serving); });
+
+    cping::AgentCoordinator coord;
+    bool ok = coord.connect("127.0.0.1", a.port(), "s3cret") &&
+              coord.connect("127.0.0.1", b.port(), "s3cret") &&
+              !coord.connect("127.0.0.1", 1);
+
+    cping::AgentJob job;
+    job.id          = 7;
+    job.targets     = { *cping::Address::parse("127.0.0.2"),
+                        *cping::Address::parse("10.255.255.1") };
+    job.rounds      = 2;
+    job.interval_ms = 100;
+    job.timeout_ms  = 100;
+
+    cping::CoordinatorResult res;
+    if (ok) res = coord.run(job);
+
+    // A wrong secret gets the connection closed before any job runs
+    cping::AgentCoordinator intruder;
+    if (ok && intruder.connect("127.0.0.1", c.port(), "guess")) {
+        auto bad = intruder.run(job);
+        ok = bad.vantage.size() == 1 && !bad.vantage[0].complete &&
+             bad.sent == 0 && intruder.agents() == 0;
+    }
+
+    // Out-of-range probe parameters are refused the same way
+    if (ok) {
+        cping::AgentJob wild = job;
+        wild.ttl = 300;
+        auto bad = coord.run(wild);
+        ok = bad.sent == 0 && coord.agents() == 0;
+    }
+
+    serving = false;
+    ta.join();
+    tb.join();
+    tc.join();
+    cping::shutdown_engine();
+
+    if (!ok || res.vantage.size() != 2) return false;
+    for (const auto& v : res.vantage)
+        if (!v.complete || v.sent != 4 || v.received != 2 || v.latency.count() != 2) return false;
+    return res.sent == 8 && res.received == 4 && res.global.count() == 4;
+}
+
+bool test_packet_capture() {
+    const auto path = (std::filesystem::temp_directory_path() / "cping_test.pcapng").string();
+
+    cping::PcapngWriter writer;
+    if (!writer.open(path) || !cping::init_engine()) return false;
+    cping::set_engine_capture(&writer);
+
+    auto live = *cping::Address::parse("127.0.0.2");
+    auto dead = *cping::Address::parse("10.255.255.1");
+    int ok = 0;
+    for (int i = 0; i < 3; ++i)
+        ok += cping::ping_once_engine(live, 500).success;
+    ok += cping::ping_once_engine(dead, 100).success;
+
+    cping::shutdown_engine();
+    cping::set_engine_capture(nullptr);
+    writer.close();
+    if (ok != 3 || writer.packets() != 7 || writer.dropped() != 0) return false;
+
+    std::vector<cping::CapturedPacket> packets;
+    std::ifstream in(path, std::ios::binary);
+    bool read = cping::read_pcapng(in, packets);
+    in.close();
+    std::remove(path.c_str());
+    if (!read || packets.size() != 7) return false;
+
+    // File order is queue order: a fast reply may be queued before its
+    // request, so check the directions by count rather than position
+    const auto requests = std::count_if(packets.begin(), packets.end(), [](const cping::CapturedPacket& p) {
+        return p.dir == cping::CaptureDirection::Outbound && p.data.size() == 36 && p.data[0] == 0x45;
+    });
+    const auto replies = std::count_if(packets.begin(), packets.end(), [](const cping::CapturedPacket& p) {
+        return p.dir == cping::CaptureDirection::Inbound;
+    });
+    if (requests != 4 || replies != 3) return false;
+
+    // Offline replay rebuilds the same outcome from the capture alone
+    auto targets = cping::replay_capture(packets);
+    if (targets.size() != 2 || targets[0].target != live || targets[1].target != dead) return false;
+    for (const auto& p : targets[0].probes)
+        if (!p.success || p.rtt_us < 0 || p.ttl <= 0) return false;
+    return targets[0].probes.size() == 3 && targets[1].probes.size() == 1 &&
+           !targets[1].probes[0].success;
+}
+
+bool test_rx_overflow() {
+    if (!cping::init_engine()) return false;
+    const auto before = cping::engine_stats();
+
+    cping::ProbeRequest req;
+    req.ip         = "127.0.0.2";
+    req.timeout_ms = 1000;
+
+    // Stall the listener in a completion callback so replies pile up
+    std::atomic<bool> stalled{false};
+    std::atomic<int>  done{0};
+    cping::submit_probe(req, [&](const cping::PingProbeResult&, uint64_t) {
+        stalled = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        done++;
+    });
+    for (int i = 0; i < 1000 && !stalled; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    constexpr int burst = 3000;
+    for (int i = 0; i < burst; ++i)
+        if (!cping::submit_probe(req, [&](const cping::PingProbeResult&, uint64_t) { done++; }))
+            done++;
+
+    for (int i = 0; i < 500 && done < burst + 1; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    const auto after = cping::engine_stats();
+    cping::shutdown_engine();
+
+    // Drops are counted, and the buffer grows whenever the limit allows
+    // it (the kernel reports twice the size it was asked for)
+    long rmem_max = 0;
+    std::ifstream rmem("/proc/sys/net/core/rmem_max");
+    rmem >> rmem_max;
+    const bool can_grow = 2 * rmem_max > long(before.rcvbuf_bytes);
+
+    return stalled && before.rx_dropped == 0 && after.rx_dropped > 0 &&
+           after.rcvbuf_bytes >= before.rcvbuf_bytes &&
+           (can_grow ? after.rcvbuf_grows > 0 && after.rcvbuf_bytes > before.rcvbuf_bytes
+                     : after.rcvbuf_grows == 0);
+}
+
+bool test_departure_schedule() {
+    using Clock = std::chrono::steady_clock;
+    if (!cping::init_engine()) return false;
+
+    // Userspace pacer: probes submitted together leave on their own schedule
+    constexpr int n = 5;
+    const auto step  = std::chrono::milliseconds(20);
+    const auto start = Clock::now() + step;
+
+    std::mutex mtx;
+    std::vector<std::pair<uint64_t, Clock::time_point>> done;
+    std::vector<cping::PingProbeResult> probes(n);
+
+    cping::ProbeRequest req;
+    req.ip = "127.0.0.2";
+    for (int i = 0; i < n; ++i) {
+        req.tag     = static_cast<uint64_t>(i);
+        req.send_at = start + step * i;
+        cping::submit_probe(req, [&](const cping::PingProbeResult& p, uint64_t tag) {
+            std::lock_guard<std::mutex> lk(mtx);
+            probes[tag] = p;
+            done.emplace_back(tag, Clock::now());
+        });
+    }
+    const bool submitted_early = Clock::now() < start;
+
+    for (int i = 0; i < 200; ++i) {
+        { std::lock_guard<std::mutex> lk(mtx); if (done.size() == n) break; }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    bool paced = submitted_early && done.size() == n;
+    for (size_t i = 0; paced && i < done.size(); ++i) {
+        const auto [tag, at] = done[i];
+        paced = tag == i && probes[tag].success &&
+                at >= start + step * static_cast<int>(tag) &&
+                probes[tag].rtt_us < 20000;
+    }
+
+    // Kernel txtime, where available (loopback has no fq: sent at once)
+    bool kernel = true;
+    if (cping::set_engine_txtime(true)) {
+        req.send_at = Clock::now() + std::chrono::milliseconds(5);
+        auto res = std::make_shared<std::promise<cping::PingProbeResult>>();
+        auto fut = res->get_future();
+        kernel = cping::engine_txtime() &&
+                 cping::submit_probe(req, [res](const cping::PingProbeResult& p, uint64_t) {
+                     res->set_value(p);
+                 }) &&
+                 fut.get().success;
+        cping::set_engine_txtime(false);
+        kernel = kernel && !cping::engine_txtime();
+    }
+
+    cping::shutdown_engine();
+    return paced && kernel;
+}
+
+bool test_tsc_clock() {
+    using std::chrono::steady_clock;
+    auto offset_us = [] {
+        auto a = cping::TscClock::now();
+        auto r = steady_clock::now();
+        return std::chrono::duration_cast<std::chrono::microseconds>(a - r).count();
+    };
+
+    // Unsuitable CPUs fall back to steady_clock
+    if (!cping::TscClock::calibrate(std::chrono::milliseconds(20)))
+        return !cping::TscClock::active() && cping::TscClock::frequency_hz() == 0.0 &&
+               std::abs(offset_us()) < 1000;
+
+    bool ok = cping::TscClock::active() && cping::TscClock::frequency_hz() > 1e8;
+
+    // Monotonic on every thread across a re-anchor (one per second), and
+    // on the steady_clock timeline within a few microseconds
+    auto monotonic = [] {
+        const auto until = steady_clock::now() + std::chrono::milliseconds(1200);
+        auto prev = cping::TscClock::now();
+        while (steady_clock::now() < until) {
+            auto t = cping::TscClock::now();
+            if (t < prev) return false;
+            prev = t;
+        }
+        return true;
+    };
+    bool other = false;
+    std::thread reader([&] { other = monotonic(); });
+    ok = monotonic() && ok;
+    reader.join();
+    ok = ok && other && std::abs(offset_us()) < 100;
+
+    // The engine path measures real RTTs with it
+    if (ok && cping::set_engine_tsc(true) && cping::init_engine()) {
+        auto r = cping::ping_once_engine("127.0.0.2", 500);
+        ok = r.success && r.rtt_us >= 0 && r.rtt_us < 100000;
+        cping::shutdown_engine();
+    }
+    cping::set_engine_tsc(false);
+    cping::TscClock::disable();
+    return ok;
+}
+
+bool test_sweep_permutation() {
+    cping::SweepRange r;
+    if (!cping::parse_sweep_range("10.1.2.3/22", r) || r.first != 0x0A010000 || r.size != 1024)
+        return false;
+    if (cping::parse_sweep_range("10.0.0.0/7", r) || cping::parse_sweep_range("10.0.0.0/x", r))
+        return false;
+
+    // Every offset exactly once, and a restored cursor continues the sequence
+    cping::SweepPermutation p(1000, 42);
+    std::vector<bool> seen(1000);
+    uint64_t off, state = 0, emitted = 0;
+    std::vector<uint64_t> tail;
+    for (int i = 0; p.next(off); ++i) {
+        if (off >= 1000 || seen[off]) return false;
+        seen[off] = true;
+        if (i == 499) { state = p.state(); emitted = p.emitted(); }
+        if (i >= 500) tail.push_back(off);
+    }
+    if (p.emitted() != 1000) return false;
+
+    cping::SweepPermutation q(1000, 42);
+    q.restore(state, emitted);
+    for (uint64_t expect : tail)
+        if (!q.next(off) || off != expect) return false;
+    return !q.next(off);
+}
+
+bool test_sweep_resume() {
+    const auto path = (std::filesystem::temp_directory_path() / "cping_sweep.ckpt").string();
+    cping::SweepRange r;
+    if (!cping::parse_sweep_range("127.0.0.0/28", r) || !cping::init_engine()) return false;
+
+    cping::SweepOptions opt;
+    opt.rate_pps        = 100;
+    opt.timeout_ms      = 200;
+    opt.checkpoint_path = path;
+
+    // Interrupted part way through
+    std::atomic<bool> running{true};
+    std::thread stopper([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(60));
+        running = false;
+    });
+    auto st = cping::new_sweep(r, 7);
+    bool finished = cping::run_sweep(st, opt, &running);
+    stopper.join();
+
+    // Resume from the checkpoint file, not the in-memory state
+    cping::SweepState resumed;
+    std::ifstream in(path, std::ios::binary);
+    bool read = cping::read_sweep_state(in, resumed);
+    in.close();
+    const uint64_t first_done = resumed.done;
+
+    bool done = read && cping::run_sweep(resumed, opt);
+    cping::shutdown_engine();
+    std::remove(path.c_str());
+
+    if (finished || !done || first_done == 0 || first_done >= r.size) return false;
+
+    // 127.0.0.1 .. .15 all answer on loopback; each counted once
+    size_t bits = 0;
+    for (uint64_t i = 0; i < r.size; ++i) bits += resumed.alive(i);
+    return resumed.complete() && resumed.alive(1) && resumed.alive(15) &&
+           bits == resumed.responders.size() && bits >= 15;
+}
+
+bool test_sweep_engine_stop() {
+    cping::SweepRange r;
+    if (!cping::parse_sweep_range("127.0.0.0/28", r) || !cping::init_engine()) return false;
+
+    cping::SweepOptions opt;
+    opt.rate_pps   = 100;
+    opt.timeout_ms = 200;
+
+    // The engine going away mid-sweep must not settle the rest as silent
+    std::thread stopper([] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(60));
+        cping::shutdown_engine();
+    });
+    auto st = cping::new_sweep(r, 3);
+    bool finished = cping::run_sweep(st, opt);
+    stopper.join();
+    if (finished || st.done >= r.size) return false;
+
+    // Resuming on a fresh engine covers every address
+    if (!cping::init_engine()) return false;
+    bool done = cping::run_sweep(st, opt);
+    cping::shutdown_engine();
+
+    size_t bits = 0;
+    for (uint64_t i = 0; i < r.size; ++i) bits += st.alive(i);
+    return done && bits >= 15;
+}
+
+bool test_incremental_rescan() {
+    cping::SweepRange lo, blackhole;
+    if (!cping::parse_sweep_range("127.0.0.0/29", lo) ||
+        !cping::parse_sweep_range("10.255.255.0/30", blackhole) || !cping::init_engine())
+        return false;
+
+    cping::RescanOptions opt;
+    opt.rate_pps       = 1000;
+    opt.background_pps = 200;
+    opt.timeout_ms     = 200;
+
+    // .1 - .3 known; the rest of the /29 answers too and must come up as new
+    auto prev = cping::sweep_from_list(lo, { cping::Address::v4(0x7F000001),
+                                            cping::Address::v4(0x7F000002),
+                                            cping::Address::v4(0x7F000003) });
+    size_t live_calls = 0;
+    auto up = cping::run_rescan(prev, opt, [&](const cping::RescanDelta&) { ++live_calls; });
+
+    // A "responder" in a blackholed net must be retried, then reported dead
+    auto gone = cping::run_rescan(
+        cping::sweep_from_list(blackhole, { cping::Address::v4(0x0AFFFF01) }), opt);
+    cping::shutdown_engine();
+
+    bool new_only = !up.deltas.empty() && live_calls == up.deltas.size();
+    for (const auto& d : up.deltas)
+        new_only = new_only && d.change == cping::RescanChange::NewlyAlive &&
+                              (d.offset == 0 || d.offset >= 4);
+
+    return up.complete && new_only && up.probes == lo.size &&
+           up.state.alive(1) && up.state.alive(7) && up.state.complete() &&
+           gone.complete && gone.deltas.size() == 1 &&
+           gone.deltas[0].change == cping::RescanChange::NewlyDead &&
+           gone.deltas[0].offset == 1 && !gone.state.alive(1) &&
+           gone.probes == blackhole.size + 1;
+}
+
+bool test_prefix_trie() {
+    std::istringstream file(
+        "# site map\n"
+        "10.0.0.0/8      corp\n"
+        "10.1.0.0/16     fra1\n"
+        "10.1.2.0/24     fra1-lab\n"
+        "10.1.2.128/25   fra1-lab\n"
+        "2001:db8::/32   v6\n"
+        "bogus/99        x\n");
+    cping::GroupIndex groups;
+    cping::PrefixTrie trie;
+    if (cping::load_prefix_list(file, trie, &groups) != 5 || groups.group_count() != 4) return false;
+
+    auto group_of = [&](const char* ip) {
+        uint32_t g = trie.lookup(*cping::Address::parse(ip));
+        return g == cping::PrefixTrie::kNoValue ? std::string("-") : groups.summary(g).name;
+    };
+    if (group_of("10.1.2.200") != "fra1-lab" || group_of("10.1.2.3") != "fra1-lab" ||
+        group_of("10.1.3.1") != "fra1" || group_of("10.9.9.9") != "corp" ||
+        group_of("11.0.0.1") != "-" || group_of("2001:db8:1::1") != "v6" ||
+        group_of("2001:db9::1") != "-")
+        return false;
+
+    // Random prefixes against a linear longest-match scan
+    std::mt19937 rng(42);
+    cping::PrefixTrie rnd;
+    std::vector<std::pair<uint32_t, int>> rules;
+    for (uint32_t i = 0; i < 2000; ++i) {
+        int len = int(rng() % 33);
+        uint32_t net = len ? uint32_t(rng()) & (~0u << (32 - len)) : 0;
+        net &= 0xFF0FFFFFu;                             // Cluster the prefixes a little
+        bool dup = false;
+        for (auto& r : rules) dup = dup || (r.first == net && r.second == len);
+        if (dup) continue;
+        rules.emplace_back(net, len);
+        rnd.insert(cping::Address::v4(net), len, uint32_t(rules.size() - 1));
+    }
+    if (rnd.size() != rules.size()) return false;
+
+    for (int i = 0; i < 20000; ++i) {
+        uint32_t ip = uint32_t(rng());
+        if (i % 2) ip = rules[rng() % rules.size()].first | (rng() & 0xFF);
+        uint32_t want = cping::PrefixTrie::kNoValue;
+        int best = -1;
+        for (size_t r = 0; r < rules.size(); ++r) {
+            const int len = rules[r].second;
+            const uint32_t mask = len ? ~0u << (32 - len) : 0;
+            if ((ip & mask) == rules[r].first && len > best) {
+                best = len;
+                want = uint32_t(r);
+            }
+        }
+        if (rnd.lookup_v4(ip) != want) return false;
+    }
+    return true;
+}
+
+bool test_sweep_exclusion() {
+    cping::SweepRange r;
+    cping::PrefixTrie exclude;
+    if (!cping::parse_sweep_range("127.0.0.0/29", r) || !exclude.insert("127.0.0.4/30", 0) ||
+        !cping::init_engine())
+        return false;
+
+    cping::SweepOptions opt;
+    opt.timeout_ms = 200;
+    opt.exclude    = &exclude;
+    auto st = cping::new_sweep(r);
+    bool done = cping::run_sweep(st, opt);
+    cping::shutdown_engine();
+
+    // Excluded hosts settle without a probe, so they never show as alive
+    return done && st.alive(1) && st.alive(3) &&
+           !st.alive(4) && !st.alive(7) && st.responders.size() <= 4;
+}
+
+bool test_collect_responders() {
+    if (!cping::init_engine()) return false;
+
+    // Unicast on loopback: one responder, but the probe stays open until its deadline
+    auto t0 = std::chrono::steady_clock::now();
+    auto lo = cping::ping_collect_engine(*cping::Address::parse("127.0.0.2"), 300);
+    auto took = std::chrono::steady_clock::now() - t0;
+
+    auto none = cping::ping_collect_engine(*cping::Address::parse("10.255.255.1"), 200);
+    cping::shutdown_engine();
+
+    return lo.error_msg.empty() && lo.responders.size() == 1 &&
+           lo.responders[0].addr == *cping::Address::parse("127.0.0.2") &&
+           lo.responders[0].rtt_us >= 0 && lo.responders[0].ttl > 0 &&
+           took >= std::chrono::milliseconds(290) &&
+           none.responders.empty() && none.error_msg == "Timeout";
+}
+
+bool test_run_arena() {
+    // Sized up front: the log must never reach the upstream resource
+    constexpr size_t n = 256;
+    cping::RunArena arena(cping::RunArena::bytes_for(n),
+                          std::pmr::null_memory_resource());
+    {
+        cping::ProbeLog log(arena.resource());
+        log.reserve(n);
+
+        cping::PingProbeResult p;
+        p.error_msg = "Destination host unreachable (longer than SSO)";
+        for (size_t i = 0; i < n; ++i)
+            log.emplace_back(p);
+
+        if (log.size() != n || std::string_view(log.back().error_msg) != p.error_msg) return false;
+        if (log.back().error_msg.get_allocator().resource() != arena.resource())
+            return false;
+    }
+
+    arena.release();
+    cping::ProbeLog again(arena.resource());
+    again.reserve(n);
+    return again.capacity() >= n;
+}
+
+bool test_outage_log() {
+    cping::TargetTable table;
+    table.add("192.0.2.1");
+
+    std::vector<cping::OutageRecord> log;
+    cping::OutageTracker tracker(table, cping::OutagePolicy{},
+        [&](const cping::OutageRecord& r) { log.push_back(r); });
+
+    // 1 probe/s: up 0..9, lost 10..19, back at 20
+    for (int t = 0; t < 30; ++t) {
+        cping::PingProbeResult p;
+        p.success = (t < 10 || t >= 20);
+        p.rtt_us  = p.success ? 1000 : -1;
+        tracker.observe(0, p, t * 1000);
+    }
+    tracker.flush(30000);
+
+    if (log.size() != 3) return false;
+    if (log[1].state != cping::TargetState::Down ||
+        log[1].start_ms != 10000 || log[1].end_ms != 20000) return false;
+
+    // The losses that confirmed the outage are counted inside it
+    if (log[0].probes != 10 || log[0].lost != 0 || log[1].lost != 10) return false;
+
+    auto all = cping::availability(log, "", 0, 30000);
+    auto mid = cping::availability(log, "192.0.2.1", 15000, 25000);
+    if (all.down_ms != 10000 || all.availability_pct < 66.6 || all.availability_pct > 66.7)
+        return false;
+    if (mid.up_ms != 5000 || mid.down_ms != 5000) return false;
+
+    std::istringstream in("192.0.2.1,down,1000,4000,3,3,0,0,0\ngarbage\n");
+    auto parsed = cping::read_outage_log(in);
+    return parsed.size() == 1 && parsed[0].end_ms == 4000;
+}
+
 int main() {
     std::cout << "Running cping tests...\n";
 
@@ -91,6 +1172,36 @@ int main() {
     run_test("Invalid IP Handling", test_invalid_ip);
     run_test("Payload Option", test_options_payload);
     run_test("TTL Option", test_options_ttl);
+    run_test("Admission Priority", test_admission_priority);
+    run_test("Engine Async Loopback", test_engine_async_loopback);
+    run_test("Latency Histogram", test_latency_histogram);
+    run_test("Target Table", test_target_table);
+    run_test("Monitor Loopback", test_monitor_loopback);
+    run_test("Group Rollups", test_group_rollups);
+    run_test("Anomaly Detector", test_anomaly_detector);
+    run_test("Outage Log", test_outage_log);
+    run_test("Coordinated Omission", test_coordinated_omission);
+    run_test("Flood Loopback", test_flood_loopback);
+    run_test("Batch Deadline", test_batch_deadline);
+    run_test("Cancellation", test_cancellation);
+    run_test("Streaming Probes", test_streaming_probes);
+    run_test("Run Arena", test_run_arena);
+    run_test("Address Parsing", test_address_parsing);
+    run_test("Warmup", test_warmup);
+    run_test("Reachability Matrix", test_reachability_matrix);
+    run_test("Sharded Monitor", test_sharded_monitor);
+    run_test("Distributed Agents", test_distributed_agents);
+    run_test("Packet Capture", test_packet_capture);
+    run_test("Receive Overflow", test_rx_overflow);
+    run_test("Departure Schedule", test_departure_schedule);
+    run_test("TSC Clock", test_tsc_clock);
+    run_test("Sweep Permutation", test_sweep_permutation);
+    run_test("Sweep Resume", test_sweep_resume);
+    run_test("Sweep Engine Stop", test_sweep_engine_stop);
+    run_test("Incremental Rescan", test_incremental_rescan);
+    run_test("Prefix Trie", test_prefix_trie);
+    run_test("Sweep Exclusion", test_sweep_exclusion);
+    run_test("Collect Responders", test_collect_responders);
 
     std::cout << "\nTests completed with " << g_failures << " failures.\n";
     return g_failures > 0 ? 1 : 0;